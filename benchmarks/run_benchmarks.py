@@ -0,0 +1,185 @@
+"""
+Runs the DyND-Python benchmark suite in benchmarks/suite, printing
+a table of timings and optionally writing them as JSON so the results
+of different builds can be compared.
+
+The benchmarks follow the conventions of asv (airspeed velocity), so
+they can also be run with it. Each bench_*.py module contains classes
+whose ``time_*`` methods are timed, after calling the class's
+``setup`` method if it has one.
+
+Usage: python run_benchmarks.py [options]
+
+    --bench REGEX       Only run benchmarks whose name matches REGEX
+    --output FILE       Write the results to FILE as JSON
+    --compare FILE      Compare against the JSON results in FILE, and
+                        exit with status 1 if anything regressed
+    --threshold RATIO   The slowdown counted as a regression (default 1.25)
+    --repeat N          The number of samples per benchmark (default 5)
+    --min-time SECONDS  The minimum time of each sample (default 0.05)
+    --quick             Take a single short sample of each benchmark
+"""
+from __future__ import print_function, absolute_import
+import sys
+import os
+import re
+import importlib
+import json
+import time
+import timeit
+import platform
+import optparse
+
+SUITE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'suite')
+
+def discover(suite_dir, pattern=None):
+    """
+    Returns a sorted list of (name, class, method name) for every
+    ``time_*`` method of the classes in the bench_*.py modules.
+    """
+    regex = re.compile(pattern) if pattern else None
+    benchmarks = []
+    if suite_dir not in sys.path:
+        sys.path.insert(0, suite_dir)
+    for fname in sorted(os.listdir(suite_dir)):
+        if not (fname.startswith('bench_') and fname.endswith('.py')):
+            continue
+        modname = fname[:-3]
+        mod = importlib.import_module(modname)
+        for clsname in sorted(dir(mod)):
+            cls = getattr(mod, clsname)
+            if not isinstance(cls, type) or cls.__module__ != modname:
+                continue
+            for methname in sorted(dir(cls)):
+                if not methname.startswith('time_'):
+                    continue
+                name = '%s.%s.%s' % (modname, clsname, methname)
+                if regex is None or regex.search(name):
+                    benchmarks.append((name, cls, methname))
+    return benchmarks
+
+def run_one(cls, methname, repeat, min_time):
+    """
+    Times one benchmark, returning a dict with the per-call
+    times of the samples.
+    """
+    obj = cls()
+    if hasattr(obj, 'setup'):
+        obj.setup()
+    try:
+        fn = getattr(obj, methname)
+        timer = timeit.default_timer
+        # Find how many calls make a sample last at least min_time
+        number = 1
+        while True:
+            start = timer()
+            for i in range(number):
+                fn()
+            elapsed = timer() - start
+            if elapsed >= min_time or number >= 1000000:
+                break
+            number *= 10 if elapsed < min_time / 10 else 2
+        samples = [elapsed / number]
+        for r in range(repeat - 1):
+            start = timer()
+            for i in range(number):
+                fn()
+            samples.append((timer() - start) / number)
+    finally:
+        if hasattr(obj, 'teardown'):
+            obj.teardown()
+    samples.sort()
+    return {
+        'min': samples[0],
+        'median': samples[len(samples) // 2],
+        'max': samples[-1],
+        'number': number,
+        'repeat': len(samples),
+    }
+
+def environment():
+    import dynd
+    import numpy
+    return {
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'machine': platform.machine(),
+        'numpy': numpy.__version__,
+        'dynd_python': dynd.__version__,
+        'dynd_python_git_sha1': dynd.__git_sha1__,
+        'libdynd': dynd.__libdynd_version__,
+        'libdynd_git_sha1': dynd.__libdynd_git_sha1__,
+        'date': time.strftime('%Y-%m-%dT%H:%M:%S'),
+    }
+
+def format_time(t):
+    for unit, scale in [('s', 1.0), ('ms', 1e-3), ('us', 1e-6)]:
+        if t >= scale:
+            return '%8.3f%-2s' % (t / scale, unit)
+    return '%8.3f%-2s' % (t / 1e-9, 'ns')
+
+def compare(results, baseline, threshold):
+    """
+    Prints the benchmarks whose median time changed by more than
+    the threshold, returning the names of the regressions.
+    """
+    regressions = []
+    for name in sorted(results):
+        if name not in baseline:
+            continue
+        old = baseline[name]['median']
+        new = results[name]['median']
+        if old <= 0:
+            continue
+        ratio = new / old
+        if ratio >= threshold:
+            regressions.append(name)
+            print('REGRESSION %-60s %s -> %s (%.2fx)' %
+                  (name, format_time(old), format_time(new), ratio))
+        elif ratio <= 1.0 / threshold:
+            print('improved   %-60s %s -> %s (%.2fx)' %
+                  (name, format_time(old), format_time(new), ratio))
+    return regressions
+
+def main(argv):
+    parser = optparse.OptionParser(usage='%prog [options]')
+    parser.add_option('--bench', default=None)
+    parser.add_option('--output', default=None)
+    parser.add_option('--compare', default=None)
+    parser.add_option('--threshold', type='float', default=1.25)
+    parser.add_option('--repeat', type='int', default=5)
+    parser.add_option('--min-time', type='float', default=0.05, dest='min_time')
+    parser.add_option('--quick', action='store_true', default=False)
+    options, args = parser.parse_args(argv)
+    if options.quick:
+        options.repeat = 1
+        options.min_time = 0
+
+    results = {}
+    failures = []
+    for name, cls, methname in discover(SUITE_DIR, options.bench):
+        try:
+            r = run_one(cls, methname, options.repeat, options.min_time)
+        except Exception as e:
+            failures.append(name)
+            print('%-70s FAILED: %s' % (name, e))
+            continue
+        results[name] = r
+        print('%-70s %s' % (name, format_time(r['median'])))
+        sys.stdout.flush()
+
+    if options.output:
+        with open(options.output, 'w') as f:
+            json.dump({'environment': environment(), 'results': results},
+                      f, indent=2, sort_keys=True)
+
+    status = 1 if failures else 0
+    if options.compare:
+        with open(options.compare) as f:
+            baseline = json.load(f)['results']
+        if compare(results, baseline, options.threshold):
+            status = 1
+    return status
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
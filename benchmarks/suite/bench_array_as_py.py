@@ -0,0 +1,35 @@
+"""
+Benchmarks converting dynd arrays to Python objects (array_as_py).
+"""
+from dynd import nd, ndt
+
+class TimeAsPy:
+    def setup(self):
+        self.ints = nd.range(100000)
+        self.floats = nd.range(100000, dtype=ndt.float64)
+        self.nested = nd.array([[i, i + 1, i + 2] for i in range(30000)])
+        self.strings = nd.array(['item%d' % i for i in range(30000)])
+        self.records = nd.array([(i, i * 0.5) for i in range(10000)],
+                                dtype='{x: int32, y: float64}')
+        self.scalar = nd.array(12345)
+
+    def time_int_array(self):
+        nd.as_py(self.ints)
+
+    def time_float_array(self):
+        nd.as_py(self.floats)
+
+    def time_nested_array(self):
+        nd.as_py(self.nested)
+
+    def time_string_array(self):
+        nd.as_py(self.strings)
+
+    def time_lazy_string_array(self):
+        nd.as_py(self.strings, strings='lazy')
+
+    def time_struct_array(self):
+        nd.as_py(self.records)
+
+    def time_scalar(self):
+        nd.as_py(self.scalar)
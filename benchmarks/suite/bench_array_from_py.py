@@ -0,0 +1,97 @@
+"""
+Benchmarks converting Python objects to dynd arrays (array_from_py).
+"""
+from dynd import nd, ndt
+
+class TimeListConversion:
+    def setup(self):
+        self.ints = list(range(100000))
+        self.floats = [i * 0.5 for i in range(100000)]
+        self.nested = [[i, i + 1, i + 2] for i in range(30000)]
+        self.strings = ['item%d' % i for i in range(30000)]
+        self.ragged = [list(range(i % 10)) for i in range(10000)]
+
+    def time_int_list(self):
+        nd.array(self.ints)
+
+    def time_float_list(self):
+        nd.array(self.floats)
+
+    def time_nested_list(self):
+        nd.array(self.nested)
+
+    def time_string_list(self):
+        nd.array(self.strings)
+
+    def time_ragged_list(self):
+        nd.array(self.ragged)
+
+    def time_float_list_with_type(self):
+        nd.array(self.floats, type='strided * float64')
+
+class TimeIteratorConversion:
+    def setup(self):
+        self.n = 100000
+
+    def time_generator(self):
+        nd.array((i * 0.5 for i in range(self.n)), type='var * float64')
+
+    def time_array_builder(self):
+        b = nd.array_builder()
+        b.extend(i * 0.5 for i in range(self.n))
+        b.finish()
+
+    def time_array_builder_promoting(self):
+        b = nd.array_builder()
+        b.extend(range(self.n))
+        b.append(0.5)
+        b.finish()
+
+class TimeDictConversion:
+    def setup(self):
+        self.records = [{'x': i, 'y': i * 0.5, 'name': 'n%d' % i}
+                        for i in range(10000)]
+        self.tp = ndt.type('{x: int32, y: float64, name: string}')
+
+    def time_list_of_dicts(self):
+        nd.array(self.records, dtype=self.tp)
+
+class TimeScalarConversion:
+    def time_int(self):
+        nd.array(12345)
+
+    def time_float(self):
+        nd.array(1.5)
+
+    def time_string(self):
+        nd.array('a short string')
+
+class TimeRecordsConversion:
+    def setup(self):
+        names = ['f%d' % i for i in range(40)]
+        self.tp = ndt.make_struct([ndt.int64] * 20 + [ndt.float64] * 10 +
+                                  [ndt.string] * 10, names)
+        self.records = [dict((name, j if k < 20 else (j * 0.5 if k < 30 else name))
+                             for k, name in enumerate(names))
+                        for j in range(5000)]
+        self.tuples = [tuple(r[name] for name in names) for r in self.records]
+
+    def time_list_of_dicts_40_fields(self):
+        nd.array(self.records, dtype=self.tp)
+
+    def time_list_of_tuples_40_fields(self):
+        nd.array(self.tuples, dtype=self.tp)
+
+class TimeBufferConversion:
+    def setup(self):
+        self.data = bytearray(8 * 1000000)
+        self.view = memoryview(self.data)
+
+    def time_view_bytearray(self):
+        nd.view(self.data)
+
+    def time_view_memoryview(self):
+        nd.view(self.view)
+
+    def time_copy_memoryview(self):
+        nd.array(self.view)
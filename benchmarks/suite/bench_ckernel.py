@@ -0,0 +1,137 @@
+"""
+Benchmarks ckernels built from NumPy ufuncs, called through
+the ckernel_deferred interface.
+"""
+import numpy as np
+from dynd import nd, ndt, _lowlevel
+
+class TimeUfuncCKernel:
+    def setup(self):
+        self.ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), False)
+        self.lifted = _lowlevel.lift_ckernel_deferred(self.ckd,
+                        ['strided * float64', 'strided * float64',
+                         'strided * float64'])
+        self.a = nd.range(100000, dtype=ndt.float64)
+        self.b = nd.range(100000, dtype=ndt.float64)
+        self.out = nd.empty(100000, ndt.float64)
+        self.small_a = nd.range(10, dtype=ndt.float64)
+        self.small_out = nd.empty(10, ndt.float64)
+        ickd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.int32, np.int32, np.int32), False)
+        self.sum = _lowlevel.lift_reduction_ckernel_deferred(ickd,
+                        'strided * int32')
+        self.ints = nd.range(100000, dtype=ndt.int32)
+        self.int_out = nd.empty(ndt.int32)
+
+    def time_from_ufunc(self):
+        _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), False)
+
+    def time_lifted_add_large(self):
+        self.lifted.__call__(self.out, self.a, self.b)
+
+    def time_lifted_add_small(self):
+        self.lifted.__call__(self.small_out, self.small_a, self.small_a)
+
+    def time_lifted_sum(self):
+        self.sum.__call__(self.int_out, self.ints)
+
+class TimeCKernelCache:
+    def setup(self):
+        def instantiate_assignment(out_ckb, ckb_offset, types, meta, kerntype):
+            out_ckb = _lowlevel.CKernelBuilderStruct.from_address(out_ckb)
+            return _lowlevel.make_assignment_ckernel(out_ckb, ckb_offset,
+                            types[0], meta[0], types[1], meta[1],
+                            'expr', kerntype)
+        self.pyfunc = _lowlevel.ckernel_deferred_from_pyfunc(
+                        instantiate_assignment, [ndt.float64, ndt.int32])
+        self.cached = _lowlevel.make_cached_ckernel_deferred(self.pyfunc)
+        self.src = nd.array(1, ndt.int32)
+        self.out = nd.empty(ndt.float64)
+
+    def time_pyfunc_uncached(self):
+        for i in range(100):
+            self.pyfunc.__call__(self.out, self.src)
+
+    def time_pyfunc_cached(self):
+        for i in range(100):
+            self.cached.__call__(self.out, self.src)
+
+class TimeParallelReduction:
+    def setup(self):
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), False)
+        self.sum = _lowlevel.lift_reduction_ckernel_deferred(ckd,
+                        'strided * float64', associative=True, commutative=True)
+        self.a = nd.range(10000000, dtype=ndt.float64)
+        self.out = nd.empty(ndt.float64)
+        self.saved_num_threads = nd.get_num_threads()
+
+    def teardown(self):
+        nd.set_num_threads(self.saved_num_threads)
+
+    def time_sum_1_thread(self):
+        nd.set_num_threads(1)
+        self.sum.__call__(self.out, self.a)
+
+    def time_sum_all_threads(self):
+        nd.set_num_threads(0)
+        self.sum.__call__(self.out, self.a)
+
+class TimeSummationModes:
+    def setup(self):
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float32, np.float32, np.float32), False)
+        self.sums = dict((summation, _lowlevel.lift_reduction_ckernel_deferred(ckd,
+                        'strided * float32', associative=True, commutative=True,
+                        summation=summation))
+                        for summation in ['naive', 'pairwise', 'kahan'])
+        self.a = nd.array(np.full(10000000, 0.1, dtype=np.float32))
+        self.out = nd.empty(ndt.float32)
+
+    def time_naive(self):
+        self.sums['naive'].__call__(self.out, self.a)
+
+    def time_pairwise(self):
+        self.sums['pairwise'].__call__(self.out, self.a)
+
+    def time_kahan(self):
+        self.sums['kahan'].__call__(self.out, self.a)
+
+class TimeFusedPipeline:
+    def setup(self):
+        mul = _lowlevel.ckernel_deferred_from_ufunc(np.multiply,
+                        (np.float64, np.float64, np.float64), False)
+        neg = _lowlevel.ckernel_deferred_from_ufunc(np.negative,
+                        (np.float64, np.float64), False)
+        sqrt = _lowlevel.ckernel_deferred_from_ufunc(np.sqrt,
+                        (np.float64, np.float64), False)
+        types2 = ['strided * float64'] * 3
+        types1 = ['strided * float64'] * 2
+        self.mul = _lowlevel.lift_ckernel_deferred(mul, types2)
+        self.sqrt = _lowlevel.lift_ckernel_deferred(sqrt, types1)
+        self.neg = _lowlevel.lift_ckernel_deferred(neg, types1)
+        # sqrt(a * b) and negated, as one pass over memory
+        self.fused = _lowlevel.lift_ckernel_deferred(
+                        _lowlevel.fuse_ckernel_deferreds([mul, sqrt, neg]), types2)
+        self.a = nd.range(10000000, dtype=ndt.float64)
+        self.b = nd.range(10000000, dtype=ndt.float64)
+        self.tmp0 = nd.empty(10000000, ndt.float64)
+        self.tmp1 = nd.empty(10000000, ndt.float64)
+        self.out = nd.empty(10000000, ndt.float64)
+
+    def time_staged(self):
+        self.mul.__call__(self.tmp0, self.a, self.b)
+        self.sqrt.__call__(self.tmp1, self.tmp0)
+        self.neg.__call__(self.out, self.tmp1)
+
+    def time_fused(self):
+        self.fused.__call__(self.out, self.a, self.b)
+
+class TimeArithmetic:
+    def setup(self):
+        self.a = nd.range(100000, dtype=ndt.float64)
+
+    def time_add_eval(self):
+        (self.a + self.a).eval()
@@ -0,0 +1,23 @@
+"""
+Benchmarks calling the builtin elementwise gfuncs, whose
+overhead on small arrays is dominated by dispatch.
+"""
+from dynd import nd, ndt
+from dynd.nd import elwise_gfuncs
+
+class TimeElwiseGFunc:
+    def setup(self):
+        self.small = nd.range(10, dtype=ndt.float64)
+        self.large = nd.range(1000000, dtype=ndt.float64)
+        self.small_int = nd.range(10, dtype=ndt.int16)
+
+    def time_add_small(self):
+        for i in range(100):
+            elwise_gfuncs.add(self.small, self.small)
+
+    def time_add_small_converted(self):
+        for i in range(100):
+            elwise_gfuncs.add(self.small_int, self.small)
+
+    def time_add_large(self):
+        elwise_gfuncs.add(self.large, self.large)
@@ -0,0 +1,32 @@
+"""
+Benchmarks evaluating nd.elwise_map with Python callables.
+"""
+from dynd import nd, ndt
+
+def py_doubler(dst, src):
+    dst[...] = [2 * x for x in nd.as_py(src)]
+
+def numpy_doubler(dst, src):
+    dst[...] = 2 * src
+
+class TimeElwiseMap:
+    def setup(self):
+        self.a = nd.range(100000)
+        self.b = nd.array([[i, i + 1, i + 2] for i in range(10000)])
+
+    def time_unary_1d(self):
+        nd.elwise_map([self.a], py_doubler, ndt.int64).eval()
+
+    def time_unary_2d(self):
+        nd.elwise_map([self.b], py_doubler, ndt.int64).eval()
+
+    def time_unary_2d_buffered(self):
+        nd.elwise_map([self.b], py_doubler, ndt.int64,
+                        block_size=65536).eval()
+
+    def time_numpy_1d(self):
+        nd.elwise_map([self.a], numpy_doubler, ndt.int64, numpy=True).eval()
+
+    def time_numpy_2d_buffered(self):
+        nd.elwise_map([self.b], numpy_doubler, ndt.int64,
+                        numpy=True, block_size=65536).eval()
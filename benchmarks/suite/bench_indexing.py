@@ -0,0 +1,65 @@
+"""
+Benchmarks __getitem__ and __setitem__ with scalar and slice indices.
+"""
+from dynd import nd, ndt
+
+class TimeGetItem:
+    def setup(self):
+        self.a = nd.range(1000, dtype=ndt.float64)
+        self.b = nd.array([[i, i + 1, i + 2] for i in range(1000)])
+
+    def time_scalar_index(self):
+        self.a[10]
+
+    def time_scalar_index_as_py(self):
+        nd.as_py(self.a[10])
+
+    def time_scalar_index_2d(self):
+        self.b[10, 1]
+
+    def time_item(self):
+        self.a.item(10)
+
+    def time_item_2d(self):
+        self.b.item(10, 1)
+
+    def time_slice(self):
+        self.a[10:500:2]
+
+    def time_slice_2d(self):
+        self.b[10:500, 1]
+
+class TimeSetItem:
+    def setup(self):
+        self.a = nd.empty(1000, ndt.float64)
+        self.b = nd.empty(1000, 3, ndt.int32)
+
+    def time_scalar_index(self):
+        self.a[10] = 1.5
+
+    def time_scalar_index_2d(self):
+        self.b[10, 1] = 3
+
+    def time_itemset_2d(self):
+        self.b.itemset(10, 1, 3)
+
+    def time_slice_scalar(self):
+        self.a[10:500] = 2.5
+
+    def time_slice_list(self):
+        self.b[0:2] = [[1, 2, 3], [4, 5, 6]]
+
+class TimeGatherScatter:
+    def setup(self):
+        self.a = nd.range(100000, dtype=ndt.float64).eval_copy(access='rw')
+        self.idx = nd.array([(i * 7919) % 100000 for i in range(100000)])
+        self.mask = nd.array([i % 3 == 0 for i in range(100000)])
+
+    def time_gather(self):
+        self.a[self.idx]
+
+    def time_mask(self):
+        self.a[self.mask]
+
+    def time_scatter(self):
+        self.a[self.idx] = 1.0
@@ -0,0 +1,39 @@
+"""
+Benchmarks parse_json, format_json and groupby.
+"""
+import json
+from dynd import nd, ndt
+
+class TimeJSON:
+    def setup(self):
+        self.ints_json = json.dumps(list(range(100000)))
+        self.records_json = json.dumps([{'x': i, 'y': i * 0.5, 'name': 'n%d' % i}
+                                        for i in range(10000)])
+        self.records_type = 'var * {x: int32, y: float64, name: string}'
+        self.ints = nd.parse_json('var * int32', self.ints_json)
+        self.records = nd.parse_json(self.records_type, self.records_json)
+
+    def time_parse_ints(self):
+        nd.parse_json('var * int32', self.ints_json)
+
+    def time_parse_records(self):
+        nd.parse_json(self.records_type, self.records_json)
+
+    def time_format_ints(self):
+        nd.format_json(self.ints)
+
+    def time_format_records(self):
+        nd.format_json(self.records)
+
+class TimeGroupBy:
+    def setup(self):
+        n = 100000
+        self.data = nd.range(n)
+        self.by = nd.array(['cat%d' % (i % 10) for i in range(n)])
+        self.groups = ndt.factor_categorical(self.by)
+
+    def time_groupby(self):
+        nd.groupby(self.data, self.by).eval()
+
+    def time_groupby_with_groups(self):
+        nd.groupby(self.data, self.by, self.groups).eval()
@@ -0,0 +1,78 @@
+"""
+Benchmarks exchanging data with NumPy, through array_from_numpy_array,
+array_as_numpy and the PEP 3118 buffer protocol.
+"""
+import numpy as np
+from dynd import nd, ndt
+
+class TimeFromNumpy:
+    def setup(self):
+        self.small = np.arange(10, dtype=np.float64)
+        self.large = np.arange(1000000, dtype=np.float64)
+        self.records = np.zeros(1000, dtype=[('x', np.int32),
+                        ('y', np.float64), ('name', 'S16')])
+
+    def time_view_small(self):
+        nd.view(self.small)
+
+    def time_view_large(self):
+        nd.view(self.large)
+
+    def time_view_records(self):
+        nd.view(self.records)
+
+    def time_copy_large(self):
+        nd.array(self.large)
+
+class TimeAsNumpy:
+    def setup(self):
+        self.small = nd.range(10, dtype=ndt.float64)
+        self.large = nd.range(1000000, dtype=ndt.float64)
+        self.records = nd.array(np.zeros(1000, dtype=[('x', np.int32),
+                        ('y', np.float64)]))
+
+    def time_as_numpy_small(self):
+        nd.as_numpy(self.small)
+
+    def time_as_numpy_large(self):
+        nd.as_numpy(self.large)
+
+    def time_as_numpy_records(self):
+        nd.as_numpy(self.records)
+
+    def time_asarray(self):
+        np.asarray(self.large)
+
+class TimeAsNumpyCopy:
+    def setup(self):
+        self.dates = nd.array(np.arange('2000-01-01', '2100-01-01',
+                        dtype='M8[D]'))
+        self.strings = nd.array([u'string %d' % i for i in range(100000)])
+
+    def time_dates(self):
+        nd.as_numpy(self.dates, allow_copy=True)
+
+    def time_strings(self):
+        nd.as_numpy(self.strings, allow_copy=True)
+
+class TimeBufferProtocol:
+    def setup(self):
+        self.a = nd.range(100000, dtype=ndt.float64)
+        self.b = nd.array([[1, 2, 3], [4, 5, 6]])
+        self.records = nd.empty(1000, ndt.make_cstruct(
+                        [ndt.int32, ndt.float64, ndt.make_fixedstring(16, 'ascii')],
+                        ['x', 'y', 'name']))
+
+    def time_memoryview_1d(self):
+        memoryview(self.a)
+
+    def time_memoryview_2d(self):
+        memoryview(self.b)
+
+    def time_memoryview_struct(self):
+        memoryview(self.records)
+
+    def time_memoryview_1000_calls(self):
+        a = self.b
+        for i in range(1000):
+            memoryview(a)
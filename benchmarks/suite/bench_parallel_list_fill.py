@@ -0,0 +1,29 @@
+"""
+Benchmarks converting a large list of floats with nd.array
+using different numbers of threads.
+"""
+from dynd import nd
+
+class TimeParallelListFill:
+    def setup(self):
+        self.saved_num_threads = nd.get_num_threads()
+        self.lst = [i * 0.5 for i in range(2000000)]
+
+    def teardown(self):
+        nd.set_num_threads(self.saved_num_threads)
+
+    def fill(self, num_threads):
+        nd.set_num_threads(num_threads)
+        nd.array(self.lst)
+
+    def time_threads_1(self):
+        self.fill(1)
+
+    def time_threads_2(self):
+        self.fill(2)
+
+    def time_threads_4(self):
+        self.fill(4)
+
+    def time_threads_8(self):
+        self.fill(8)
@@ -0,0 +1,35 @@
+"""
+Benchmarks evaluating dynd expressions from several Python threads
+at once. Since evaluation releases the GIL, the time for one
+evaluation per thread should stay close to the single thread time.
+"""
+import threading
+from dynd import nd, ndt
+
+def worker(expr):
+    expr.eval()
+
+class TimeThreadedEval:
+    def setup(self):
+        arrays = [nd.range(1000000, dtype=ndt.float64) for i in range(8)]
+        self.exprs = [(a + a) * a for a in arrays]
+
+    def eval_threads(self, num_threads):
+        threads = [threading.Thread(target=worker, args=(e,))
+                   for e in self.exprs[:num_threads]]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+    def time_threads_1(self):
+        self.eval_threads(1)
+
+    def time_threads_2(self):
+        self.eval_threads(2)
+
+    def time_threads_4(self):
+        self.eval_threads(4)
+
+    def time_threads_8(self):
+        self.eval_threads(8)
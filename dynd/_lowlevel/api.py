@@ -113,10 +113,20 @@ class _PyLowLevelAPI(ctypes.Structure):
                  ctypes.PYFUNCTYPE(ctypes.py_object,
                         ctypes.py_object, ctypes.py_object)),
                 ('_lift_reduction_ckernel_deferred',
-                 ctypes.PYFUNCTYPE(*([ctypes.py_object] * 10))),
+                 ctypes.PYFUNCTYPE(*([ctypes.py_object] * 11))),
                 ('ckernel_deferred_from_pyfunc',
                  ctypes.PYFUNCTYPE(ctypes.py_object,
                         ctypes.py_object, ctypes.py_object)),
+                # PyObject *make_cached_ckernel_deferred(PyObject *ckd);
+                ('make_cached_ckernel_deferred',
+                 ctypes.PYFUNCTYPE(ctypes.py_object, ctypes.py_object)),
+                ('ckernel_cache_info',
+                 ctypes.PYFUNCTYPE(ctypes.py_object)),
+                ('clear_ckernel_cache',
+                 ctypes.PYFUNCTYPE(ctypes.py_object)),
+                # PyObject *fuse_ckernel_deferreds(PyObject *ckds);
+                ('fuse_ckernel_deferreds',
+                 ctypes.PYFUNCTYPE(ctypes.py_object, ctypes.py_object)),
                ]
 
 api = _LowLevelAPI.from_address(_get_lowlevel_api())
@@ -133,7 +143,8 @@ for a in [api, py_api]:
 def lift_reduction_ckernel_deferred(elwise_reduction, lifted_type,
                 dst_initialization= None, axis=None, keepdims=False,
                 associative=False, commutative=False,
-                right_associative=False, reduction_identity=None):
+                right_associative=False, reduction_identity=None,
+                summation='naive'):
     """
     This function creates a lifted reduction ckernel_deferred,
     broadcasting or reducing dimensions on top of the elwise_reduction
@@ -165,6 +176,12 @@ def lift_reduction_ckernel_deferred(elwise_reduction, lifted_type,
         If True, the elwise_reduction is based on a commutative
         operation, e.g. op(a, b) == op(a, b).
         Defaults to False.
+        When the reduction is both associative and commutative,
+        reduces every dimension to a scalar, has no
+        dst_initialization, and
+        ``nd.get_num_threads()`` is above one, large inputs are
+        split across threads and the partial results combined
+        with elwise_reduction.
     right_associative: bool, optional
         If True, the operation should associate to the right
         instead of to the left, i.e. should reduce as
@@ -175,6 +192,17 @@ def lift_reduction_ckernel_deferred(elwise_reduction, lifted_type,
         the reduction is based on, op(a, X) == op(X, a) == a.
         A reduction of an empty list gets set to this value when
         provided.
+    summation: 'naive', 'pairwise' or 'kahan', optional
+        The order in which to evaluate a reduction of all the
+        dimensions to a scalar. 'naive' folds from left to right.
+        'pairwise' accumulates blocks of 128 elements into eight
+        interleaved partial results, and combines the blocks as a
+        balanced tree, like NumPy's add.reduce. 'kahan' is
+        compensated addition of float32 or float64 values. Both
+        require an elwise_reduction made from numpy.add by
+        ckernel_deferred_from_ufunc, and bound the rounding error
+        of floating point sums far better than 'naive'.
+        Defaults to 'naive'.
 
     Returns
     -------
@@ -184,7 +212,7 @@ def lift_reduction_ckernel_deferred(elwise_reduction, lifted_type,
     return _lift_reduction_ckernel_deferred(elwise_reduction,
                 lifted_type, dst_initialization, axis, keepdims,
                 associative, commutative, right_associative,
-                reduction_identity)
+                reduction_identity, summation)
 
 # Documentation for the LowLevelAPI functions
 memory_block_incref.__doc__ = """
@@ -524,4 +552,68 @@ ckernel_deferred_from_pyfunc.__doc__ = """
     _lowlevel.ckernel_deferred_from_pyfunc(instantiate_pyfunc, types)
 
     TODO
-    """
\ No newline at end of file
+    """
+make_cached_ckernel_deferred.__doc__ = """
+    _lowlevel.make_cached_ckernel_deferred(ckd)
+
+    Wraps a ckernel_deferred so that its instantiations are kept in
+    a process-wide cache, keyed on the calling thread, the kernel
+    request type and the metadata. Instantiating it again with the
+    same metadata on the same thread adds a small ckernel forwarding
+    to the cached one, instead of building the ckernel tree again,
+    which for ckernel_deferreds made from Python functions skips
+    calling into Python.
+
+    The cached ckernels are shared by the instantiations on each
+    thread, so this should not wrap ckernel_deferreds whose ckernels
+    keep state from one call to the next. Ones which only use scratch
+    space during a call, like fused ckernels, are fine. Types with
+    memory block references in their metadata, like var dims, bypass
+    the cache.
+
+    Parameters
+    ----------
+    ckd : nd.array of ckernel_deferred type
+        The ckernel_deferred whose instantiations to cache.
+
+    Returns
+    -------
+    nd.array of ckernel_deferred type
+        A ckernel_deferred with the same types as ckd.
+    """
+ckernel_cache_info.__doc__ = """
+    _lowlevel.ckernel_cache_info()
+
+    Returns a dict with the number of instantiations the ckernel
+    cache satisfied ('hits'), had to build ('misses') and couldn't
+    cache ('bypasses'), along with its 'size' and 'capacity'.
+    """
+clear_ckernel_cache.__doc__ = """
+    _lowlevel.clear_ckernel_cache()
+
+    Empties the ckernel instantiation cache and resets its counters.
+    ckernels already instantiated from it stay valid.
+    """
+fuse_ckernel_deferreds.__doc__ = """
+    _lowlevel.fuse_ckernel_deferreds(ckds)
+
+    Fuses a pipeline of elementwise ckernel_deferreds into one.
+    The first may take any number of inputs, and each one after it
+    takes the previous one's output as its only input. The fused
+    ckernel runs all the stages on a cache-sized tile of elements
+    before moving to the next, keeping the intermediate values in
+    small scratch buffers instead of full temporary arrays.
+
+    Parameters
+    ----------
+    ckds : list of nd.array of ckernel_deferred type
+        The stages, in the order they're applied. The intermediate
+        types must be POD types without metadata, like the
+        numeric types.
+
+    Returns
+    -------
+    nd.array of ckernel_deferred type
+        A ckernel_deferred with the output type of the last stage
+        and the input types of the first.
+    """
@@ -58,3 +58,18 @@ def squeeze(a, axis=None):
                 break
     ix = tuple(ix)
     return a[ix]
+
+def fuse(ckds):
+    """Fuses a pipeline of elementwise ckernel_deferreds into one,
+    which runs every stage on a cache-sized tile of elements before
+    moving on to the next. Lifting the result makes one pass over
+    memory for the whole pipeline, instead of one per stage.
+
+    Parameters
+    ----------
+    ckds : list of nd.array of ckernel_deferred type
+        The stages, in the order they're applied. Each stage after
+        the first takes the previous stage's output as its only input.
+    """
+    from .. import _lowlevel
+    return _lowlevel.fuse_ckernel_deferreds(list(ckds))
@@ -6,13 +6,15 @@ from dynd._pydynd import as_py, as_numpy, w_type, \
                 dtype_of, ndim_of
 
 class FieldExpr:
-    def __init__(self, dst_field_expr, src_field_names, fnname):
+    def __init__(self, dst_field_expr, src_field_names, fnname,
+                    vectorized=False):
         if fnname is None:
             self.__name__ = 'computed_field_expr'
         else:
             self.__name__ = fnname
         self.dst_field_expr = dst_field_expr
         self.src_field_names = src_field_names
+        self.vectorized = vectorized
         # Create a globals dict containing numpy and scipy
         # for the expressions to use
         import datetime
@@ -26,6 +28,16 @@ class FieldExpr:
         self.glbl['as_numpy'] = as_numpy
 
     def __call__(self, dst, src):
+        if self.vectorized:
+            # 'dst' and 'src' are NumPy views of a whole chunk, so
+            # each field expression is evaluated once per chunk
+            lcl = {}
+            for name in self.src_field_names:
+                lcl[str(name)] = src[str(name)]
+            for i, expr in enumerate(self.dst_field_expr):
+                dst[dst.dtype.names[i]] = eval(expr, self.glbl, lcl)
+            return
+
         # Loop element by element
         for dst_itm, src_itm in zip(dst, src):
             # Put all the src fields in a locals dict
@@ -49,7 +61,8 @@ class FieldExpr:
                 v = eval(expr, self.glbl, lcl)
                 dst_itm[i] = v
 
-def add_computed_fields(n, fields, rm_fields=[], fnname=None):
+def add_computed_fields(n, fields, rm_fields=[], fnname=None,
+                vectorized=False):
     """
     Adds one or more new fields to a struct array,
     using nd.elwise_map to create the deferred object.
@@ -73,6 +86,12 @@ def add_computed_fields(n, fields, rm_fields=[], fnname=None):
     fnname : string, optional
         The function name, which affects how the resulting
         deferred expression's dtype is printed.
+    vectorized : bool, optional
+        If True, each field_expr is evaluated once per chunk
+        with the input fields as NumPy arrays, instead of once
+        per element. The expressions must then work elementwise
+        on arrays, and all the field types must have NumPy
+        equivalents.
 
     Examples
     --------
@@ -122,9 +141,28 @@ def add_computed_fields(n, fields, rm_fields=[], fnname=None):
         new_field_expr.append(fe)
 
     result_udt = make_cstruct(new_field_types, new_field_names)
-    fieldexpr = FieldExpr(new_field_expr, field_names, fnname)
 
-    return elwise_map([n], fieldexpr, result_udt)
+    if vectorized:
+        # The expressions are evaluated on NumPy views of whole
+        # chunks, so all the fields need NumPy equivalents
+        src_udt = udt
+        if src_udt.type_id != 'cstruct':
+            src_udt = make_cstruct(field_types, field_names)
+        try:
+            src_udt.as_numpy()
+            result_udt.as_numpy()
+        except TypeError:
+            raise TypeError(('add_computed_fields: vectorized evaluation ' +
+                            'requires fields with NumPy equivalents, ' +
+                            'cannot use %s -> %s') % (udt, result_udt))
+        fieldexpr = FieldExpr(new_field_expr, field_names, fnname, True)
+        if src_udt != udt:
+            return elwise_map([n], fieldexpr, result_udt, [src_udt], numpy=True)
+        else:
+            return elwise_map([n], fieldexpr, result_udt, numpy=True)
+    else:
+        fieldexpr = FieldExpr(new_field_expr, field_names, fnname)
+        return elwise_map([n], fieldexpr, result_udt)
 
 def make_computed_fields(n, replace_ndim, fields, fnname=None):
     """
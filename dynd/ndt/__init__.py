@@ -8,7 +8,9 @@ from dynd._pydynd import w_type as type, \
         make_strided_dim, make_fixed_dim, make_var_dim, \
         make_categorical, replace_dtype, extract_dtype, \
         factor_categorical, make_bytes, make_property, \
-        make_reversed_property, cuda_support
+        make_reversed_property, cuda_support, \
+        numpy_type_cache_info, clear_numpy_type_cache, \
+        pep3118_format_cache_info, clear_pep3118_format_cache
 
 void = type('void')
 bool = type('bool')
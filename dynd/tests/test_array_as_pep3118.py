@@ -0,0 +1,96 @@
+import sys
+import unittest
+from dynd import nd, ndt
+
+@unittest.skipIf(sys.version_info < (3, 3),
+                'memoryview supports suboffsets in Python 3.3 and later')
+class TestVarDimBuffer(unittest.TestCase):
+    def test_outer_var_dim(self):
+        a = nd.array([1, 2, 3], type='var * int32')
+        m = memoryview(a)
+        self.assertEqual(m.shape, (3,))
+        self.assertEqual(m.suboffsets, ())
+        self.assertEqual(m.tolist(), [1, 2, 3])
+
+    def test_inner_var_dim(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]], type='strided * var * int32')
+        m = memoryview(a)
+        self.assertEqual(m.shape, (2, 3))
+        self.assertEqual(m.suboffsets, (0, -1))
+        self.assertEqual(m.tolist(), [[1, 2, 3], [4, 5, 6]])
+
+    def test_nested_var_dims(self):
+        a = nd.array([[1.5, 2.5], [3.5, 4.5]], type='var * var * float64')
+        m = memoryview(a)
+        self.assertEqual(m.shape, (2, 2))
+        self.assertEqual(m.tolist(), [[1.5, 2.5], [3.5, 4.5]])
+
+    def test_ragged(self):
+        a = nd.array([[1, 2, 3], [4]], type='strided * var * int32')
+        self.assertRaises(BufferError, memoryview, a)
+
+class TestStringBuffers(unittest.TestCase):
+    def test_strings(self):
+        a = nd.array([u'abc', u'', u'\xe9t\xe9'])
+        offsets, data = nd.as_string_buffers(a)
+        self.assertEqual(nd.as_py(offsets), [0, 3, 3, 8])
+        self.assertEqual(nd.type_of(offsets), ndt.make_strided_dim(ndt.int64))
+        self.assertEqual(nd.type_of(data), ndt.make_strided_dim(ndt.uint8))
+        self.assertEqual(bytes(bytearray(nd.as_py(data))),
+                        u'abc\xe9t\xe9'.encode('utf_8'))
+
+    def test_strided_strings(self):
+        a = nd.array(['one', 'two', 'three', 'four'])[::2]
+        offsets, data = nd.as_string_buffers(a)
+        self.assertEqual(nd.as_py(offsets), [0, 3, 8])
+        self.assertEqual(bytes(bytearray(nd.as_py(data))), b'onethree')
+
+    def test_empty(self):
+        offsets, data = nd.as_string_buffers(nd.empty(0, ndt.string))
+        self.assertEqual(nd.as_py(offsets), [0])
+        self.assertEqual(nd.as_py(data), [])
+
+    def test_errors(self):
+        self.assertRaises(TypeError, nd.as_string_buffers, nd.array([1, 2]))
+        self.assertRaises(TypeError, nd.as_string_buffers,
+                        nd.array([['a'], ['b']]))
+
+class TestFormatCache(unittest.TestCase):
+    def setUp(self):
+        ndt.clear_pep3118_format_cache()
+
+    def test_hits(self):
+        a = nd.array([(1, 2.5), (3, 4.5)],
+                     dtype=ndt.make_cstruct([ndt.int32, ndt.float64], ['x', 'y']))
+        fmt = memoryview(a).format
+        info = ndt.pep3118_format_cache_info()
+        self.assertEqual(info['misses'], 1)
+        self.assertEqual(info['size'], 1)
+        for i in range(10):
+            self.assertEqual(memoryview(a).format, fmt)
+        info = ndt.pep3118_format_cache_info()
+        self.assertEqual(info['misses'], 1)
+        self.assertEqual(info['hits'], 10)
+
+    def test_bounded(self):
+        capacity = ndt.pep3118_format_cache_info()['capacity']
+        for i in range(capacity + 10):
+            memoryview(nd.empty(ndt.make_cstruct([ndt.int8], ['f%d' % i])))
+        info = ndt.pep3118_format_cache_info()
+        self.assertTrue(info['size'] <= capacity)
+        ndt.clear_pep3118_format_cache()
+        info = ndt.pep3118_format_cache_info()
+        self.assertEqual(info['size'], 0)
+        self.assertEqual(info['hits'], 0)
+
+    def test_many_dims(self):
+        # Buffers too big for the pooled allocations still work
+        x = 1
+        for i in range(24):
+            x = [x]
+        a = nd.array(x)
+        self.assertEqual(memoryview(a).shape, (1,) * 24)
+        self.assertEqual(memoryview(a).tolist(), x)
+
+if __name__ == '__main__':
+    unittest.main()
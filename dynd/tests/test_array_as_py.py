@@ -0,0 +1,99 @@
+import sys
+import unittest
+from dynd import nd, ndt
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+class TestArrayAsPy(unittest.TestCase):
+    def check_builtin(self, lst, dtype):
+        a = nd.array(lst, dtype=dtype)
+        self.assertEqual(nd.as_py(a), lst)
+        # Strided views, including negative strides
+        self.assertEqual(nd.as_py(a[::2]), lst[::2])
+        self.assertEqual(nd.as_py(a[::-1]), lst[::-1])
+
+    def test_bool(self):
+        self.check_builtin([True, False, False, True, True], ndt.bool)
+
+    def test_ints(self):
+        self.check_builtin([0, -128, 127, 5, -3], ndt.int8)
+        self.check_builtin([0, -32768, 32767, 5, -3], ndt.int16)
+        self.check_builtin([0, -2**31, 2**31-1, 5, -3], ndt.int32)
+        self.check_builtin([0, -2**63, 2**63-1, 5, -3], ndt.int64)
+
+    def test_uints(self):
+        self.check_builtin([0, 255, 128, 5, 3], ndt.uint8)
+        self.check_builtin([0, 65535, 128, 5, 3], ndt.uint16)
+        self.check_builtin([0, 2**32-1, 128, 5, 3], ndt.uint32)
+        self.check_builtin([0, 2**64-1, 128, 5, 3], ndt.uint64)
+
+    def test_floats(self):
+        self.check_builtin([0.5, -1.25, 1e10, 3.0], ndt.float32)
+        self.check_builtin([0.5, -1.25, 1e100, 3.0], ndt.float64)
+        self.check_builtin([0.5j, -1.25, 1e10+1j, 3.0], ndt.complex_float32)
+        self.check_builtin([0.5j, -1.25, 1e100+1j, 3.0], ndt.complex_float64)
+
+    def test_multidim(self):
+        lst = [[1, 2, 3], [4, 5, 6]]
+        a = nd.array(lst, dtype=ndt.int16)
+        self.assertEqual(nd.as_py(a), lst)
+        self.assertEqual(nd.as_py(a[:, ::-1]), [[3, 2, 1], [6, 5, 4]])
+        a = nd.array(lst, type='2, 3, int16')
+        self.assertEqual(nd.as_py(a), lst)
+        a = nd.array([[1, 2, 3], [4]], dtype=ndt.int16)
+        self.assertEqual(nd.as_py(a), [[1, 2, 3], [4]])
+
+    def test_empty(self):
+        a = nd.array([], dtype=ndt.float64)
+        self.assertEqual(nd.as_py(a), [])
+
+class TestLazyStrings(unittest.TestCase):
+    def test_string(self):
+        lst = [u'abc', u'this is a test', u'\u0394\u0395', u'']
+        a = nd.array(lst)
+        seq = nd.as_py(a, strings='lazy')
+        self.assertEqual(len(seq), 4)
+        self.assertEqual(list(seq), lst)
+        self.assertEqual(seq[1], lst[1])
+        self.assertEqual(seq[-2], lst[-2])
+        self.assertEqual(list(seq[1:3]), lst[1:3])
+        self.assertRaises(IndexError, lambda: seq[4])
+
+    def test_ascii(self):
+        lst = [u'abc', u'x', u'hello world']
+        a = nd.array(lst, dtype=ndt.make_string('ascii'))
+        self.assertEqual(list(nd.as_py(a, strings='lazy')), lst)
+        a = nd.array(lst, dtype=ndt.make_fixedstring(16, 'ascii'))
+        self.assertEqual(list(nd.as_py(a, strings='lazy')), lst)
+
+    @unittest.skipIf(np is None, 'numpy is not available')
+    def test_ascii_high_bytes(self):
+        # NumPy 'S' arrays are viewed as ascii without validation
+        a = nd.view(np.array([b'abc', b'd\x80e'], dtype='S3'))
+        self.assertEqual(nd.as_py(a[0]), u'abc')
+        self.assertRaises(UnicodeDecodeError, nd.as_py, a)
+        self.assertRaises(UnicodeDecodeError, nd.as_py, a[1])
+        seq = nd.as_py(a, strings='lazy')
+        self.assertEqual(seq[0], u'abc')
+        self.assertRaises(UnicodeDecodeError, lambda: seq[1])
+
+    def test_nested(self):
+        lst = [[u'a', u'bc'], [u'def'], []]
+        a = nd.array(lst)
+        seq = nd.as_py(a, strings='lazy')
+        self.assertEqual(len(seq), 3)
+        self.assertEqual([list(x) for x in seq], lst)
+
+    def test_not_strings(self):
+        # Other types convert as usual
+        a = nd.array([1, 2, 3])
+        self.assertEqual(nd.as_py(a, strings='lazy'), [1, 2, 3])
+        a = nd.array(u'scalar')
+        self.assertEqual(nd.as_py(a, strings='lazy'), u'scalar')
+        self.assertRaises(ValueError, nd.as_py, a, strings='eager')
+
+if __name__ == '__main__':
+    unittest.main()
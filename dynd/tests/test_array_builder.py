@@ -0,0 +1,102 @@
+import sys
+import unittest
+from datetime import date
+from dynd import nd, ndt
+
+class TestArrayBuilder(unittest.TestCase):
+    def test_append_ints(self):
+        b = nd.array_builder()
+        self.assertEqual(b.dtype, None)
+        for i in range(10):
+            b.append(i)
+        self.assertEqual(len(b), 10)
+        self.assertEqual(b.dtype, ndt.int32)
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * int32'))
+        self.assertEqual(nd.as_py(a), list(range(10)))
+        # The builder is empty again after finish
+        self.assertEqual(len(b), 0)
+        self.assertEqual(b.dtype, None)
+
+    def test_extend_generator(self):
+        # Enough values to span several chunks
+        b = nd.array_builder()
+        b.extend(i * 3 for i in range(100000))
+        a = b.finish()
+        self.assertEqual(len(a), 100000)
+        self.assertEqual(nd.as_py(a[99999]), 299997)
+        self.assertEqual(nd.as_py(a[12345]), 37035)
+
+    def test_promotion(self):
+        b = nd.array_builder()
+        b.extend(range(3000))
+        b.append(2**40)
+        b.extend([1, 2])
+        b.append(0.5)
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * float64'))
+        self.assertEqual(nd.as_py(a), list(range(3000)) + [2**40, 1, 2, 0.5])
+
+    def test_promotion_first_value(self):
+        b = nd.array_builder()
+        b.append(True)
+        b.append(3)
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * int32'))
+        self.assertEqual(nd.as_py(a), [1, 3])
+
+    def test_strings(self):
+        b = nd.array_builder()
+        b.extend(str(i) for i in range(2000))
+        b.append(u'last')
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * string'))
+        self.assertEqual(nd.as_py(a[1999]), '1999')
+        self.assertEqual(nd.as_py(a[-1]), 'last')
+
+    def test_dates(self):
+        b = nd.array_builder()
+        b.append(date(2000, 1, 1))
+        b.append(date(2012, 12, 21))
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * date'))
+        self.assertEqual(nd.as_py(a), [date(2000, 1, 1), date(2012, 12, 21)])
+
+    def test_dtype(self):
+        b = nd.array_builder(ndt.int16)
+        b.extend([1, 2, 3])
+        self.assertRaises(OverflowError, b.append, 100000)
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * int16'))
+        self.assertEqual(nd.as_py(a), [1, 2, 3])
+        self.assertEqual(b.dtype, ndt.int16)
+
+    def test_struct_dtype(self):
+        b = nd.array_builder('{x: int32, y: string}')
+        b.append((1, 'one'))
+        b.append({'x': 2, 'y': 'two'})
+        a = b.finish()
+        self.assertEqual(nd.as_py(a), [{'x': 1, 'y': 'one'}, {'x': 2, 'y': 'two'}])
+
+    def test_var_dtype(self):
+        b = nd.array_builder('var * float64')
+        b.extend([[1], [], [2, 3.5]])
+        a = b.finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * var * float64'))
+        self.assertEqual(nd.as_py(a), [[1], [], [2, 3.5]])
+
+    def test_empty(self):
+        a = nd.array_builder().finish()
+        self.assertEqual(len(a), 0)
+        a = nd.array_builder(ndt.float32).finish()
+        self.assertEqual(nd.type_of(a), ndt.type('strided * float32'))
+        self.assertEqual(len(a), 0)
+
+    def test_errors(self):
+        b = nd.array_builder()
+        self.assertRaises(TypeError, b.append, [1, 2])
+        b.append(1)
+        self.assertRaises(TypeError, b.extend, 5)
+
+if __name__ == '__main__':
+    unittest.main()
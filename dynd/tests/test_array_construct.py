@@ -532,6 +532,40 @@ class TestStructConstruct(unittest.TestCase):
         self.assertEqual(nd.as_py(a.size.name), [['X'], ['L', 'M']])
         self.assertEqual(nd.as_py(a.size.id), [[10], [7, 5]])
 
+    def test_struct_records(self):
+        # Many rows go through the batched records conversion
+        tp = ndt.type('{id:int64, x:float64, flag:bool, name:string, n:int32}')
+        n = 1000
+        rows = [{'id': i, 'x': i * 0.5, 'flag': i % 2 == 0,
+                 'name': 'r%d' % i, 'n': -i} for i in range(n)]
+        a = nd.array(rows, dtype=tp)
+        self.assertEqual(nd.as_py(a.id), list(range(n)))
+        self.assertEqual(nd.as_py(a.x), [i * 0.5 for i in range(n)])
+        self.assertEqual(nd.as_py(a.flag), [i % 2 == 0 for i in range(n)])
+        self.assertEqual(nd.as_py(a.name), ['r%d' % i for i in range(n)])
+        self.assertEqual(nd.as_py(a.n), [-i for i in range(n)])
+
+    def test_struct_records_mixed(self):
+        # Dicts with differing key orders, tuples, and values
+        # needing the general conversion, all in one list
+        rows = [{'x': 1, 'y': 'a'}, {'y': 'b', 'x': 2}, (3, 'c'),
+                {'x': 4.0, 'y': u'd'}, [5, 'e'], {'x': True, 'y': 'f'},
+                {'x': 7, 'y': 'g'}] * 100
+        a = nd.array(rows, dtype='{x:int16, y:string}')
+        self.assertEqual(nd.as_py(a.x), [1, 2, 3, 4, 5, 1, 7] * 100)
+        self.assertEqual(nd.as_py(a.y), ['a', 'b', 'c', 'd', 'e', 'f', 'g'] * 100)
+
+    def test_struct_records_errors(self):
+        tp = '{x:int32, y:int32}'
+        self.assertRaises(RuntimeError, nd.array,
+                        [{'x': 0, 'y': 1}, {'x': 0}], dtype=tp)
+        self.assertRaises(RuntimeError, nd.array,
+                        [{'x': 0, 'y': 1}, {'x': 0, 'z': 1}], dtype=tp)
+        self.assertRaises(RuntimeError, nd.array,
+                        [{'x': 0, 'y': 1}, (0, 1, 2)], dtype=tp)
+        self.assertRaises(OverflowError, nd.array,
+                        [{'x': 0, 'y': 1}, {'x': 2**40, 'y': 1}], dtype=tp)
+
     def test_missing_field(self):
         self.assertRaises(RuntimeError, nd.array,
                         [0, 1], type='{x:int32, y:int32, z:int32}')
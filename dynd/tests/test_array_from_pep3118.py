@@ -0,0 +1,121 @@
+import sys
+import unittest
+from dynd import nd, ndt
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+class TestBufferView(unittest.TestCase):
+    def test_bytearray(self):
+        b = bytearray(b'\x01\x02\x03')
+        a = nd.view(b)
+        self.assertEqual(nd.type_of(a), ndt.make_strided_dim(ndt.uint8))
+        self.assertEqual(nd.as_py(a), [1, 2, 3])
+        # It's a writable view of the same memory
+        a[1] = 10
+        self.assertEqual(b[1], 10)
+        b[2] = 20
+        self.assertEqual(nd.as_py(a), [1, 10, 20])
+
+    def test_buffer_lifetime(self):
+        b = bytearray(b'\x01\x02\x03')
+        a = nd.view(b)
+        # The exporter can't be resized while it's viewed
+        self.assertRaises(BufferError, b.append, 4)
+        del b
+        self.assertEqual(nd.as_py(a), [1, 2, 3])
+
+    def test_readonly(self):
+        m = memoryview(b'abc')
+        a = nd.view(m)
+        self.assertEqual(nd.as_py(a), [97, 98, 99])
+        self.assertRaises(RuntimeError, nd.view, m, access='rw')
+        self.assertRaises(RuntimeError, nd.view, m, access='immutable')
+        def assign():
+            a[0] = 1
+        self.assertRaises(RuntimeError, assign)
+        # asarray makes a copy when the buffer doesn't allow the access
+        c = nd.asarray(m, access='rw')
+        c[0] = 1
+        self.assertEqual(nd.as_py(c), [1, 98, 99])
+        self.assertEqual(m.tobytes(), b'abc')
+
+    def test_readonly_view_of_writable(self):
+        b = bytearray(b'\x01\x02')
+        a = nd.view(b, access='r')
+        def assign():
+            a[0] = 1
+        self.assertRaises(RuntimeError, assign)
+
+    @unittest.skipIf(sys.version_info < (3,),
+                    'array.array exports the buffer protocol in Python 3')
+    def test_array_module(self):
+        import array
+        x = array.array('d', [1.5, 2.5, 3.5])
+        a = nd.view(x)
+        self.assertEqual(nd.type_of(a), ndt.make_strided_dim(ndt.float64))
+        x[0] = 10
+        self.assertEqual(nd.as_py(a), [10, 2.5, 3.5])
+        # nd.array copies the buffer
+        c = nd.array(array.array('i', [1, 2, 3]))
+        self.assertEqual(nd.type_of(c), ndt.make_strided_dim(ndt.int32))
+        self.assertEqual(nd.as_py(c), [1, 2, 3])
+
+    @unittest.skipIf(sys.version_info < (3, 3), 'memoryview.cast requires Python 3.3')
+    def test_multidim(self):
+        x = bytearray(range(12))
+        m = memoryview(x).cast('B', (3, 4))
+        a = nd.view(m)
+        self.assertEqual(nd.type_of(a), ndt.make_strided_dim(ndt.uint8, 2))
+        self.assertEqual(nd.as_py(a),
+                        [[0, 1, 2, 3], [4, 5, 6, 7], [8, 9, 10, 11]])
+
+@unittest.skipIf(np is None, 'numpy is not available')
+class TestBufferFormats(unittest.TestCase):
+    def view_of(self, x):
+        return nd.view(memoryview(x))
+
+    def test_strided(self):
+        x = np.arange(12, dtype=np.int32).reshape(3, 4)[:, ::2]
+        a = self.view_of(x)
+        self.assertEqual(nd.type_of(a), ndt.make_strided_dim(ndt.int32, 2))
+        self.assertEqual(nd.as_py(a), x.tolist())
+
+    def test_byteswapped(self):
+        x = np.array([1, 2, 1000], dtype='>i4' if sys.byteorder == 'little' else '<i4')
+        a = self.view_of(x)
+        self.assertEqual(nd.dtype_of(a), ndt.make_byteswap(ndt.int32))
+        self.assertEqual(nd.as_py(a), [1, 2, 1000])
+
+    def test_complex(self):
+        x = np.array([1+2j, 3-4j], dtype=np.complex128)
+        a = self.view_of(x)
+        self.assertEqual(nd.dtype_of(a), ndt.complex_float64)
+        self.assertEqual(nd.as_py(a), [1+2j, 3-4j])
+
+    def test_struct(self):
+        x = np.array([(1, 1.5), (2, 2.5)], dtype=[('x', np.int32), ('y', np.float64)])
+        a = self.view_of(x)
+        self.assertEqual(nd.as_py(a.x), [1, 2])
+        self.assertEqual(nd.as_py(a.y), [1.5, 2.5])
+        a.x[1] = 5
+        self.assertEqual(x['x'][1], 5)
+
+    def test_aligned_struct(self):
+        x = np.zeros(2, dtype=np.dtype([('x', np.int8), ('y', np.int64)], align=True))
+        x['y'] = [10, 20]
+        a = self.view_of(x)
+        self.assertEqual(nd.dtype_of(a),
+                        ndt.make_cstruct([ndt.int8, ndt.int64], ['x', 'y']))
+        self.assertEqual(nd.as_py(a.y), [10, 20])
+
+    def test_subarray(self):
+        x = np.zeros(2, dtype=[('v', np.float32, (2, 3))])
+        a = self.view_of(x)
+        self.assertEqual(nd.dtype_of(a),
+                        ndt.make_cstruct([ndt.make_fixed_dim((2, 3), ndt.float32)], ['v']))
+
+if __name__ == '__main__':
+    unittest.main()
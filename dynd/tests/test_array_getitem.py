@@ -53,6 +53,74 @@ class TestArrayGetItem(unittest.TestCase):
         self.assertRaises(IndexError, lambda x : x[-101:], a)
         self.assertRaises(IndexError, lambda x : x[-5:101:2], a)
 
+    def test_integer_tuple(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]])
+        self.assertEqual(nd.type_of(a[1, 2]), ndt.int32)
+        self.assertEqual(nd.as_py(a[1, 2]), 6)
+        self.assertEqual(nd.as_py(a[-1, -3]), 4)
+        self.assertEqual(nd.type_of(a[1]), ndt.type('A * int32'))
+        self.assertEqual(nd.as_py(a[1]), [4, 5, 6])
+        self.assertRaises(IndexError, lambda x : x[2, 0], a)
+        self.assertRaises(IndexError, lambda x : x[0, 3], a)
+        # The result views the original data
+        b = nd.array([[1, 2], [3, 4]], access='rw')
+        c = b[1, 0]
+        b[1, 0] = 10
+        self.assertEqual(nd.as_py(c), 10)
+
+    def test_item(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]])
+        self.assertEqual(a.item(0, 1), 2)
+        self.assertEqual(a.item(-1, -1), 6)
+        self.assertEqual(a.item(1), [4, 5, 6])
+        self.assertRaises(IndexError, a.item, 2, 0)
+        self.assertRaises(RuntimeError, a.item)
+        self.assertEqual(nd.array([[7]]).item(), 7)
+        self.assertEqual(nd.array(3.25).item(), 3.25)
+        b = nd.array(['this', 'is', 'a', 'test'])
+        self.assertEqual(b.item(3), 'test')
+        # Expression types are evaluated
+        c = nd.array(['1979-03-22', '1932-12-12']).ucast(ndt.date)
+        self.assertEqual(c.year.item(1), 1932)
+
+    def test_index_array(self):
+        a = nd.array([10, 11, 12, 13, 14])
+        b = a[[4, 0, -1, 2]]
+        self.assertEqual(nd.type_of(b), ndt.type('strided * int32'))
+        self.assertEqual(nd.as_py(b), [14, 10, 14, 12])
+        self.assertEqual(nd.as_py(a[nd.array([1, 3], dtype=ndt.int8)]), [11, 13])
+        self.assertEqual(nd.as_py(a[nd.empty(0, ndt.int32)]), [])
+        self.assertRaises(IndexError, lambda x : x[[0, 5]], a)
+        self.assertRaises(IndexError, lambda x : x[[-6]], a)
+        # Gathering copies the data
+        c = nd.array([1, 2, 3], access='rw')
+        d = c[[0, 1]]
+        c[0] = 100
+        self.assertEqual(nd.as_py(d), [1, 2])
+
+    def test_bool_mask(self):
+        a = nd.array([[1, 2], [3, 4], [5, 6]])
+        b = a[[True, False, True]]
+        self.assertEqual(nd.type_of(b), ndt.type('strided * strided * int32'))
+        self.assertEqual(nd.as_py(b), [[1, 2], [5, 6]])
+        self.assertEqual(nd.as_py(a[nd.array([False, False, False])]), [])
+        self.assertRaises(nd.BroadcastError, lambda x : x[[True, False]], a)
+
+    def test_index_array_var_struct(self):
+        a = nd.array([[1], [2, 3], [], [4, 5, 6]], type='4 * var * int32')
+        self.assertEqual(nd.as_py(a[[3, 1]]), [[4, 5, 6], [2, 3]])
+        b = nd.parse_json('var * {x:int32, y:string}',
+                        '[{"x":1, "y":"one"}, {"x":2, "y":"two"}, {"x":3, "y":"three"}]')
+        self.assertEqual(nd.as_py(b[[2, 0]]),
+                        [{'x':3, 'y':'three'}, {'x':1, 'y':'one'}])
+        self.assertEqual(nd.as_py(b[[False, True, False]]), [{'x':2, 'y':'two'}])
+
+    def test_index_array_large(self):
+        # Large index sets use the prefetching loop
+        a = nd.range(10000)
+        idx = [(i * 7919) % 10000 for i in range(10000)]
+        self.assertEqual(nd.as_py(a[idx]), idx)
+
     def test_struct(self):
         a = nd.parse_json('{x:int32, y:string, z:float32}',
                         '{"x":20, "y":"testing one two three", "z":-3.25}')
@@ -48,5 +48,74 @@ class TestNDObjectIn(unittest.TestCase):
         self.assertTrue(u'test' in a)
         self.assertFalse(u'' in a)
 
+    def test_large_immutable(self):
+        # Large immutable arrays use a cached hash index
+        a = nd.array(list(range(0, 300, 3)))
+        for x in range(300):
+            self.assertEqual(x in a, x % 3 == 0)
+        self.assertFalse(-3 in a)
+        self.assertFalse(2**70 in a)
+        # Values which aren't integers fall back to comparison
+        self.assertTrue(3.0 in a)
+        self.assertFalse(3.5 in a)
+
+    def test_large_readwrite(self):
+        a = nd.array(list(range(100)), access='rw')
+        self.assertFalse(1000 in a)
+        a[5] = 1000
+        self.assertTrue(1000 in a)
+
+    def test_large_dates(self):
+        from datetime import date
+        a = nd.array([date(2000, 1, 1 + i) for i in range(31)] +
+                     [date(2012, 2, 29)])
+        self.assertTrue(date(2000, 1, 15) in a)
+        self.assertTrue(date(2012, 2, 29) in a)
+        self.assertFalse(date(2000, 2, 1) in a)
+
+class TestArrayIndex(unittest.TestCase):
+    def test_build_index(self):
+        idx = nd.build_index(nd.array([3, 1, 4, 1, 5], access='rw'))
+        self.assertEqual(len(idx), 4)
+        self.assertTrue(4 in idx)
+        self.assertTrue(1 in idx)
+        self.assertFalse(2 in idx)
+        self.assertTrue(5.0 in idx)
+
+    def test_build_index_strings(self):
+        idx = nd.build_index(nd.array(['this', 'is', 'a', 'test']))
+        self.assertTrue('test' in idx)
+        self.assertTrue(u'is' in idx)
+        self.assertFalse('' in idx)
+
+    def test_build_index_errors(self):
+        self.assertRaises(TypeError, nd.build_index, nd.array([[1, 2], [3, 4]]))
+        self.assertRaises(TypeError, nd.build_index, nd.array([1.5, 2.5]))
+
+    def test_isin_ints(self):
+        a = nd.array([[1, 2, 3], [4, 5, 6]])
+        b = nd.isin(a, [2, 4, 6, 8])
+        self.assertEqual(nd.type_of(b), ndt.type('strided * strided * bool'))
+        self.assertEqual(nd.as_py(b), [[False, True, False], [True, False, True]])
+        # Reusing an index
+        idx = nd.build_index(nd.array([5, 1]))
+        self.assertEqual(nd.as_py(nd.isin(a, idx)),
+                         [[True, False, False], [False, True, False]])
+        self.assertEqual(nd.as_py(idx.isin(a)),
+                         [[True, False, False], [False, True, False]])
+
+    def test_isin_strings(self):
+        a = nd.array(['this', 'is', 'a', 'test'])
+        self.assertEqual(nd.as_py(nd.isin(a, ['a', 'test', 'other'])),
+                         [False, False, True, True])
+        # Strings never match integers
+        self.assertEqual(nd.as_py(nd.isin(a, [1, 2])),
+                         [False, False, False, False])
+
+    def test_isin_dates(self):
+        a = nd.array(['2000-01-01', '2001-02-03', '2002-03-04']).ucast(ndt.date)
+        self.assertEqual(nd.as_py(nd.isin(a, nd.array(['2001-02-03']).ucast(ndt.date))),
+                         [False, True, False])
+
 if __name__ == '__main__':
     unittest.main()
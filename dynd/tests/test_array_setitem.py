@@ -24,5 +24,46 @@ class TestArraySetItem(unittest.TestCase):
         a[4] = 101.0 + 0j
         self.assertEqual(nd.as_py(a[4]), 101)
 
+    def test_integer_tuple(self):
+        a = nd.empty('2 * 3 * int32')
+        a[...] = 0
+        a[1, 2] = 5
+        a[0, -1] = 3.0
+        self.assertEqual(nd.as_py(a), [[0, 0, 3], [0, 0, 5]])
+        a[1] = [7, 8, 9]
+        self.assertEqual(nd.as_py(a), [[0, 0, 3], [7, 8, 9]])
+        def assign_at(x, i, j):
+            x[i, j] = 1
+        self.assertRaises(IndexError, assign_at, a, 2, 0)
+        self.assertRaises(RuntimeError, assign_at, nd.array([[1, 2]]), 0, 0)
+
+    def test_itemset(self):
+        a = nd.empty('2 * 3 * float64')
+        a[...] = 0
+        a.itemset(1, 1, 2.5)
+        a.itemset(0, [1, 2, 3])
+        self.assertEqual(nd.as_py(a), [[1, 2, 3], [0, 2.5, 0]])
+        self.assertRaises(TypeError, a.itemset, 1)
+
+    def test_index_array(self):
+        a = nd.empty(6, ndt.int32)
+        a[...] = 0
+        a[[1, 3, -1]] = 7
+        self.assertEqual(nd.as_py(a), [0, 7, 0, 7, 0, 7])
+        a[nd.array([0, 2])] = [10, 20]
+        self.assertEqual(nd.as_py(a), [10, 7, 20, 7, 0, 7])
+        def assign_at(x, idx, value):
+            x[idx] = value
+        self.assertRaises(IndexError, assign_at, a, [6], 1)
+        self.assertRaises(nd.BroadcastError, assign_at, a, [0, 1], [1, 2, 3])
+
+    def test_bool_mask(self):
+        a = nd.empty('3 * 2 * float64')
+        a[...] = 0
+        a[[True, False, True]] = [[1, 2], [3, 4]]
+        self.assertEqual(nd.as_py(a), [[1, 2], [0, 0], [3, 4]])
+        a[nd.array([False, True, False])] = 5
+        self.assertEqual(nd.as_py(a), [[1, 2], [5, 5], [3, 4]])
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
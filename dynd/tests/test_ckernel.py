@@ -198,6 +198,38 @@ class TestCKernelDeferred(unittest.TestCase):
     def test_from_numpy_int32_add_withgil(self):
         self.check_from_numpy_int32_add(True)
 
+    def check_from_numpy_float64_add_unaligned(self, requiregil):
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64),
+                        requiregil)
+        with _lowlevel.ckernel.CKernelBuilder() as ckb:
+            meta = (ctypes.c_void_p * 3)()
+            _lowlevel.ckernel_deferred_instantiate(ckd, ckb, 0, meta, "strided")
+            ck = ckb.ckernel(_lowlevel.ExprStridedOperation)
+            # Misaligned operands, with more elements than fit in
+            # one staging block
+            count = 3000
+            a = np.zeros(count * 9 + 1, dtype=np.uint8)[1:]
+            b = np.arange(count, dtype=np.float64)
+            c = np.zeros(count * 10 + 1, dtype=np.uint8)[1:]
+            a_view = np.ndarray((count,), np.float64, a.data, 0, (9,))
+            c_view = np.ndarray((count,), np.float64, c.data, 0, (10,))
+            a_view[...] = np.arange(count) * 0.5
+            src = (ctypes.c_void_p * 2)()
+            src[0] = a_view.ctypes.data
+            src[1] = b.ctypes.data
+            strides = (c_ssize_t * 2)()
+            strides[0] = 9
+            strides[1] = 8
+            ck(c_view.ctypes.data, 10, src, strides, count)
+            self.assertEqual(c_view.tolist(), (np.arange(count) * 1.5).tolist())
+
+    def test_from_numpy_float64_add_unaligned_nogil(self):
+        self.check_from_numpy_float64_add_unaligned(False)
+
+    def test_from_numpy_float64_add_unaligned_withgil(self):
+        self.check_from_numpy_float64_add_unaligned(True)
+
     def test_lift_ckernel(self):
         # First get a ckernel from numpy
         requiregil = False
@@ -257,6 +289,152 @@ class TestCKernelDeferred(unittest.TestCase):
                         [['2013-03-11', '2010-10-10'],
                          ['1999-12-31'], []])
 
+class TestCKernelCache(unittest.TestCase):
+    def setUp(self):
+        _lowlevel.clear_ckernel_cache()
+        self.instantiate_count = 0
+
+    def make_pyfunc_ckd(self, types):
+        def instantiate_assignment(out_ckb, ckb_offset, types, meta, kerntype):
+            self.instantiate_count += 1
+            out_ckb = _lowlevel.CKernelBuilderStruct.from_address(out_ckb)
+            return _lowlevel.make_assignment_ckernel(out_ckb, ckb_offset,
+                            types[0], meta[0],
+                            types[1], meta[1],
+                            'expr', kerntype)
+        return _lowlevel.ckernel_deferred_from_pyfunc(instantiate_assignment, types)
+
+    def test_cache_hits(self):
+        ckd = _lowlevel.make_cached_ckernel_deferred(
+                        self.make_pyfunc_ckd([ndt.float64, ndt.int32]))
+        self.assertEqual(nd.as_py(ckd.types), [ndt.float64, ndt.int32])
+        out = nd.empty(ndt.float64)
+        for i in range(5):
+            ckd.__call__(out, nd.array(i, ndt.int32))
+            self.assertEqual(nd.as_py(out), i)
+        # The python instantiate function only ran once
+        self.assertEqual(self.instantiate_count, 1)
+        info = _lowlevel.ckernel_cache_info()
+        self.assertEqual(info['misses'], 1)
+        self.assertEqual(info['hits'], 4)
+        self.assertEqual(info['size'], 1)
+        # Lifting it instantiates strided kernels, a separate entry
+        lifted = _lowlevel.lift_ckernel_deferred(ckd,
+                        ['strided * float64', 'strided * int32'])
+        out = nd.empty(3, ndt.float64)
+        lifted.__call__(out, nd.array([1, 2, 3], ndt.int32))
+        lifted.__call__(out, nd.array([4, 5, 6], ndt.int32))
+        self.assertEqual(nd.as_py(out), [4, 5, 6])
+        self.assertEqual(self.instantiate_count, 2)
+        # Freeing the ckernel_deferred evicts its entries
+        del ckd, lifted
+        self.assertEqual(_lowlevel.ckernel_cache_info()['size'], 0)
+
+    def test_per_thread(self):
+        # Each thread gets its own instance of the cached ckernel
+        import threading
+        ckd = _lowlevel.make_cached_ckernel_deferred(
+                        self.make_pyfunc_ckd([ndt.float64, ndt.int32]))
+        def fn():
+            out = nd.empty(ndt.float64)
+            for i in range(3):
+                ckd.__call__(out, nd.array(i, ndt.int32))
+        fn()
+        t = threading.Thread(target=fn)
+        t.start()
+        t.join()
+        self.assertEqual(self.instantiate_count, 2)
+        info = _lowlevel.ckernel_cache_info()
+        self.assertEqual(info['misses'], 2)
+        self.assertEqual(info['hits'], 4)
+
+    def test_bypass(self):
+        # Strings hold memory block references in their metadata
+        ckd = _lowlevel.make_cached_ckernel_deferred(
+                        self.make_pyfunc_ckd([ndt.string, ndt.date]))
+        out = nd.empty(ndt.string)
+        for i in range(3):
+            ckd.__call__(out, nd.array('2012-11-05', ndt.date))
+            self.assertEqual(nd.as_py(out), '2012-11-05')
+        self.assertEqual(self.instantiate_count, 3)
+        self.assertEqual(_lowlevel.ckernel_cache_info()['bypasses'], 3)
+
+    def test_errors(self):
+        self.assertRaises(TypeError, _lowlevel.make_cached_ckernel_deferred,
+                        nd.array(1))
+
+class TestFuseCKernelDeferred(unittest.TestCase):
+    def make_pipeline(self):
+        # (a + b) -> negative -> int64
+        add = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), False)
+        neg = _lowlevel.ckernel_deferred_from_ufunc(np.negative,
+                        (np.float64, np.float64), False)
+        to_int = _lowlevel.make_ckernel_deferred_from_assignment(
+                        ndt.int64, ndt.float64, "expr", "none")
+        return _lowlevel.fuse_ckernel_deferreds([add, neg, to_int])
+
+    def test_fuse_scalar(self):
+        ckd = self.make_pipeline()
+        self.assertEqual(nd.as_py(ckd.types),
+                        [ndt.int64, ndt.float64, ndt.float64])
+        out = nd.empty(ndt.int64)
+        ckd.__call__(out, nd.array(1.5, ndt.float64), nd.array(2.0, ndt.float64))
+        self.assertEqual(nd.as_py(out), -3)
+
+    def test_fuse_lifted(self):
+        ckd = _lowlevel.lift_ckernel_deferred(self.make_pipeline(),
+                        ['strided * int64', 'strided * float64', 'strided * float64'])
+        # Enough elements to go through several tiles
+        count = 100003
+        a = np.arange(count, dtype=np.float64)
+        b = np.arange(count, dtype=np.float64)[::-1].copy() * 2
+        out = nd.empty(count, ndt.int64)
+        ckd.__call__(out, nd.array(a), nd.array(b))
+        self.assertEqual(nd.as_py(out), (-(a + b)).astype(np.int64).tolist())
+        # A strided view as input
+        out = nd.empty(count // 2, ndt.int64)
+        ckd.__call__(out, nd.array(a)[::2][:count // 2], nd.array(b)[1::2])
+        self.assertEqual(nd.as_py(out),
+                        (-(a[::2][:count // 2] + b[1::2])).astype(np.int64).tolist())
+
+    def test_fuse_unary(self):
+        neg = _lowlevel.ckernel_deferred_from_ufunc(np.negative,
+                        (np.float64, np.float64), False)
+        to_f32 = _lowlevel.make_ckernel_deferred_from_assignment(
+                        ndt.float32, ndt.float64, "unary", "none")
+        ckd = nd.fuse([to_f32])
+        self.assertEqual(nd.as_py(ckd.types), [ndt.float32, ndt.float64])
+        ckd = _lowlevel.lift_ckernel_deferred(
+                        _lowlevel.fuse_ckernel_deferreds([neg, neg, to_f32]),
+                        ['strided * float32', 'strided * float64'])
+        out = nd.empty(5000, ndt.float32)
+        ckd.__call__(out, nd.array(np.arange(5000, dtype=np.float64)))
+        self.assertEqual(nd.as_py(out), list(range(5000)))
+
+    def test_errors(self):
+        add = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), False)
+        neg32 = _lowlevel.ckernel_deferred_from_ufunc(np.negative,
+                        (np.float32, np.float32), False)
+        to_str = _lowlevel.make_ckernel_deferred_from_assignment(
+                        ndt.string, ndt.float64, "unary", "none")
+        from_str = _lowlevel.make_ckernel_deferred_from_assignment(
+                        ndt.float64, ndt.string, "unary", "none")
+        # No stages
+        self.assertRaises(RuntimeError, _lowlevel.fuse_ckernel_deferreds, [])
+        # Not ckernel_deferreds
+        self.assertRaises(TypeError, _lowlevel.fuse_ckernel_deferreds,
+                        [nd.array(1)])
+        # Mismatched intermediate type
+        self.assertRaises(TypeError, _lowlevel.fuse_ckernel_deferreds,
+                        [add, neg32])
+        # A later stage taking two inputs
+        self.assertRaises(TypeError, _lowlevel.fuse_ckernel_deferreds,
+                        [add, add])
+        # An intermediate with metadata
+        self.assertRaises(TypeError, _lowlevel.fuse_ckernel_deferreds,
+                        [to_str, from_str])
 
 class TestLiftReductionCKernelDeferred(unittest.TestCase):
     def test_sum_1d(self):
@@ -324,5 +502,81 @@ class TestLiftReductionCKernelDeferred(unittest.TestCase):
         sum.__call__(out, in0)
         self.assertEqual(nd.as_py(out), [10, 15])
 
+class TestSummationModes(unittest.TestCase):
+    def lift(self, summation, lifted_type='strided * float32', **kwargs):
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float32, np.float32, np.float32), False)
+        return _lowlevel.lift_reduction_ckernel_deferred(ckd, lifted_type,
+                        associative=True, commutative=True,
+                        summation=summation, **kwargs)
+
+    def test_accuracy(self):
+        # Many copies of a value which isn't exact in float32
+        x = np.full(1000003, 0.1, dtype=np.float32)
+        expected = float(x.astype(np.float64).sum())
+        out = nd.empty(ndt.float32)
+        errors = {}
+        for summation in ['naive', 'pairwise', 'kahan']:
+            self.lift(summation).__call__(out, nd.array(x))
+            errors[summation] = abs(nd.as_py(out) - expected) / expected
+        self.assertTrue(errors['pairwise'] < 1e-5)
+        self.assertTrue(errors['kahan'] < 1e-6)
+
+    def test_sizes(self):
+        # Sizes around the leaf and lane boundaries
+        for n in [1, 2, 7, 8, 9, 127, 128, 129, 255, 256, 1000]:
+            x = np.arange(n, dtype=np.float32)
+            for summation in ['pairwise', 'kahan']:
+                out = nd.empty(ndt.float32)
+                self.lift(summation).__call__(out, nd.array(x))
+                self.assertEqual(nd.as_py(out), n * (n - 1) / 2)
+
+    def test_2d_and_strided(self):
+        x = np.arange(3000, dtype=np.float32).reshape(100, 30)
+        for summation in ['pairwise', 'kahan']:
+            sum = self.lift(summation, 'strided * strided * float32')
+            out = nd.empty(ndt.float32)
+            sum.__call__(out, nd.array(x)[:, ::-2])
+            self.assertEqual(nd.as_py(out), float(x[:, ::-2].sum()))
+
+    def test_empty(self):
+        out = nd.empty(ndt.float32)
+        for summation in ['pairwise', 'kahan']:
+            # Like 'naive', an empty reduction needs an identity
+            self.assertRaises(RuntimeError, self.lift(summation).__call__,
+                            out, nd.empty(0, ndt.float32))
+            sum = self.lift(summation, reduction_identity=nd.array(0, ndt.float32))
+            sum.__call__(out, nd.empty(0, ndt.float32))
+            self.assertEqual(nd.as_py(out), 0)
+
+    def test_inf_nan(self):
+        x = np.arange(300, dtype=np.float32)
+        x[100] = np.inf
+        out = nd.empty(ndt.float32)
+        self.lift('kahan').__call__(out, nd.array(x))
+        self.assertEqual(nd.as_py(out), float('inf'))
+        x[200] = np.nan
+        self.lift('kahan').__call__(out, nd.array(x))
+        self.assertTrue(np.isnan(nd.as_py(out)))
+
+    def test_errors(self):
+        self.assertRaises(RuntimeError, self.lift, 'tree')
+        self.assertRaises(TypeError, self.lift, 'pairwise',
+                        'strided * strided * float32', axis=0)
+        self.assertRaises(TypeError, self.lift, 'pairwise', keepdims=True)
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.int32, np.int32, np.int32), False)
+        self.assertRaises(TypeError, _lowlevel.lift_reduction_ckernel_deferred,
+                        ckd, 'strided * int32', summation='kahan')
+        self.assertRaises(TypeError, _lowlevel.lift_reduction_ckernel_deferred,
+                        ckd, 'strided * int32', summation='pairwise')
+        # Only numpy.add is accepted as the elwise reduction
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.maximum,
+                        (np.float32, np.float32, np.float32), False)
+        for summation in ['pairwise', 'kahan']:
+            self.assertRaises(TypeError, _lowlevel.lift_reduction_ckernel_deferred,
+                            ckd, 'strided * float32', associative=True,
+                            commutative=True, summation=summation)
+
 if __name__ == '__main__':
     unittest.main()
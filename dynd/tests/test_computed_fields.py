@@ -36,6 +36,42 @@ class TestComputedFields(unittest.TestCase):
         self.assertEqual(nd.as_py(b.product), [2, -1, 10])
         self.assertEqual(nd.as_py(b.complex), [1+2j, -1+1j, 2+5j])
 
+    def test_vectorized_chunks(self):
+        # With vectorized=True, the expressions see whole chunks as NumPy arrays
+        a = np.arange(100000, dtype=[('x', np.float64)])
+        a['x'] = np.arange(100000)
+        b = nd.add_computed_fields(a,
+                [('sq', np.float64, 'x * x'),
+                 ('isbig', np.bool_, 'x > 50000')], vectorized=True)
+        self.assertEqual(nd.as_py(b.sq[:3]), [0, 1, 4])
+        self.assertEqual(nd.as_py(b.sq[-1]), 99999.0 ** 2)
+        self.assertEqual(nd.as_py(b.isbig[49999:50003]),
+                        [False, False, True, True])
+
+    def test_struct_input(self):
+        # A struct input is viewed as the equivalent cstruct
+        a = nd.array([(1, 2), (3, 4)], dtype='{x: int32, y: int32}')
+        b = nd.add_computed_fields(a, [('sum', np.int32, 'x + y')],
+                        vectorized=True)
+        self.assertEqual(nd.as_py(b.sum), [3, 7])
+        self.assertEqual(nd.as_py(b.x), [1, 3])
+
+    def test_per_element_default(self):
+        # By default the expressions see one element at a time,
+        # so scalar-only Python code works
+        a = nd.array([(1, 2), (3, 4)], dtype='{x: int32, y: int32}')
+        b = nd.add_computed_fields(a,
+                [('big', np.int32, 'x if x > y else y')])
+        self.assertEqual(nd.as_py(b.big), [2, 4])
+
+    def test_string_field(self):
+        # Strings have no NumPy equivalent, so can't be vectorized
+        a = nd.array([('a', 1), ('bc', 2)], dtype='{s: string, n: int32}')
+        b = nd.add_computed_fields(a, [('len', np.int32, 'len(s) + n')])
+        self.assertEqual(nd.as_py(b.len), [2, 4])
+        self.assertRaises(TypeError, nd.add_computed_fields, a,
+                        [('len', np.int32, 'len(s) + n')], vectorized=True)
+
     def test_aggregate(self):
         a = nd.array([
             ('A', 1, 2),
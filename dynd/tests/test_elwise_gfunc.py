@@ -0,0 +1,114 @@
+import sys
+import unittest
+from dynd import nd, ndt, _lowlevel
+from dynd.nd import gfunc
+import numpy as np
+
+class TestElwiseGFunc(unittest.TestCase):
+    def make_add(self):
+        f = gfunc.elwise('myadd')
+        for tp in [np.int32, np.float64]:
+            f.add_kernel(_lowlevel.ckernel_deferred_from_ufunc(np.add,
+                            (tp, tp, tp), False))
+        return f
+
+    def test_exact_match(self):
+        f = self.make_add()
+        self.assertEqual(f.name, 'myadd')
+        a = nd.array([1, 2, 3], type='strided * int32')
+        b = f(a, a)
+        self.assertEqual(nd.type_of(b), ndt.type('strided * int32'))
+        self.assertEqual(nd.as_py(b), [2, 4, 6])
+        b = f(nd.array([1.5, 2.5]), nd.array([1.0, 0.25]))
+        self.assertEqual(nd.type_of(b), ndt.type('strided * float64'))
+        self.assertEqual(nd.as_py(b), [2.5, 2.75])
+
+    def test_conversion(self):
+        f = self.make_add()
+        # int16 goes to the int32 kernel, float32 to the float64 one
+        b = f(nd.array([1, 2], type='strided * int16'), nd.array([3, 4], type='strided * int32'))
+        self.assertEqual(nd.type_of(b), ndt.type('strided * int32'))
+        self.assertEqual(nd.as_py(b), [4, 6])
+        b = f(nd.array([1, 2], type='strided * int32'), nd.array([0.5, 1.5], type='strided * float32'))
+        self.assertEqual(nd.type_of(b), ndt.type('strided * float64'))
+        self.assertEqual(nd.as_py(b), [1.5, 3.5])
+        # Python objects are converted to arrays
+        self.assertEqual(nd.as_py(f([1, 2, 3], 10)), [11, 12, 13])
+
+    def test_broadcast(self):
+        f = self.make_add()
+        a = nd.array([[1, 2, 3], [4, 5, 6]], type='strided * strided * int32')
+        b = nd.array([10, 20, 30], type='strided * int32')
+        self.assertEqual(nd.as_py(f(a, b)), [[11, 22, 33], [14, 25, 36]])
+        self.assertEqual(nd.as_py(f(a, 100)), [[101, 102, 103], [104, 105, 106]])
+        self.assertRaises(nd.BroadcastError, f, a, nd.array([1, 2], type='strided * int32'))
+        # var dims are broadcast too
+        a = nd.array([[1, 2], [3], []], type='strided * var * int32')
+        self.assertEqual(nd.as_py(f(a, 1)), [[2, 3], [4], []])
+
+    def test_out(self):
+        f = self.make_add()
+        out = nd.empty('3 * int32')
+        res = f(nd.array([1, 2, 3], type='strided * int32'), 1, out=out)
+        self.assertEqual(nd.as_py(out), [2, 3, 4])
+        self.assertEqual(nd.as_py(res), [2, 3, 4])
+        self.assertRaises(RuntimeError, f, 1, 2, output=out)
+
+    def test_dispatch_cache(self):
+        f = self.make_add()
+        a = nd.array([1, 2, 3], type='strided * int32')
+        for i in range(5):
+            self.assertEqual(nd.as_py(f(a, nd.array([i] * 3, type='strided * int32'))),
+                            [1 + i, 2 + i, 3 + i])
+        info = f.dispatch_cache_info()
+        self.assertEqual(info['misses'], 1)
+        self.assertEqual(info['hits'], 4)
+        self.assertEqual(info['size'], 1)
+        f(nd.array([1.0]), nd.array([2.0]))
+        self.assertEqual(f.dispatch_cache_info()['size'], 2)
+        f.clear_dispatch_cache()
+        self.assertEqual(f.dispatch_cache_info()['size'], 0)
+
+    def test_reentrant(self):
+        # Evaluating an argument runs Python code, which
+        # can empty the dispatch cache during the call
+        f = self.make_add()
+        def clearing(dst, src):
+            f.clear_dispatch_cache()
+            dst[...] = [nd.as_py(x) for x in src]
+        a = nd.elwise_map([nd.array([1, 2, 3], type='strided * int16')],
+                        clearing, ndt.int16)
+        self.assertEqual(nd.as_py(f(a, a)), [2, 4, 6])
+        self.assertEqual(nd.as_py(f(a, 1)), [2, 3, 4])
+
+    def test_errors(self):
+        f = self.make_add()
+        # No kernel for strings, or for a single argument
+        self.assertRaises(TypeError, f, nd.array(['a']), nd.array(['b']))
+        self.assertRaises(TypeError, f, nd.array([1, 2], type='strided * int32'))
+        # Only scalar ckernel_deferreds are kernels
+        self.assertRaises(RuntimeError, f.add_kernel, nd.array(1))
+        lifted = _lowlevel.lift_ckernel_deferred(
+                        _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                            (np.int32, np.int32, np.int32), False),
+                        ['strided * int32'] * 3)
+        self.assertRaises(TypeError, f.add_kernel, lifted)
+
+    def test_debug_repr(self):
+        f = self.make_add()
+        self.assertTrue('(int32, int32) -> int32' in f.debug_repr())
+        self.assertTrue('(float64, float64) -> float64' in f.debug_repr())
+
+class TestBuiltinElwiseGFuncs(unittest.TestCase):
+    def test_arithmetic(self):
+        from dynd.nd import elwise_gfuncs as eg
+        a = nd.array([1, 2, 3], type='strided * int32')
+        self.assertEqual(nd.as_py(eg.add(a, a)), [2, 4, 6])
+        self.assertEqual(nd.as_py(eg.multiply(a, 2)), [2, 4, 6])
+        self.assertEqual(nd.as_py(eg.divide(a, 2)), [0.5, 1.0, 1.5])
+        self.assertEqual(nd.as_py(eg.maximum(a, 2)), [2, 2, 3])
+        self.assertEqual(nd.as_py(eg.abs(nd.array([-1.5, 2.0]))), [1.5, 2.0])
+        self.assertEqual(nd.as_py(eg.sqrt(nd.array([4.0, 9.0]))), [2.0, 3.0])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,6 +1,7 @@
 import sys
 import unittest
 from dynd import nd, ndt
+import numpy as np
 
 class TestElwiseMap(unittest.TestCase):
     def test_unary_function(self):
@@ -109,5 +110,96 @@ class TestElwiseMap(unittest.TestCase):
         b[...] = 100
         self.assertEqual(nd.as_py(c), [0, -100, 1000, -200, 400])
 
+    def test_buffered_blocks(self):
+        calls = []
+        def doubler(dst, src):
+            calls.append(len(src))
+            dst[...] = [2 * nd.as_py(x) for x in src]
+        a = nd.array([[i, i + 1, i + 2] for i in range(100)], access='rw')
+        b = nd.elwise_map([a], doubler, ndt.int32, block_size=64)
+        self.assertEqual(nd.as_py(b), [[2 * i, 2 * i + 2, 2 * i + 4] for i in range(100)])
+        # The 300 elements are handed over in blocks, not rows of 3
+        self.assertEqual(calls, [64, 64, 64, 64, 44])
+        # Indexing and modifying 'a' still work as unbuffered
+        self.assertEqual(nd.as_py(b[1]), [2, 4, 6])
+        a[0, 0] = 10
+        self.assertEqual(nd.as_py(b[0]), [20, 2, 4])
+
+    def test_buffered_error(self):
+        state = {'fail': True}
+        def doubler(dst, src):
+            if state['fail']:
+                raise ValueError('failed')
+            dst[...] = [2 * nd.as_py(x) for x in src]
+        a = nd.array([[i, i + 1, i + 2] for i in range(10)])
+        b = nd.elwise_map([a], doubler, ndt.int32, block_size=4)
+        self.assertRaises(ValueError, b.eval)
+        # The rows gathered before the error aren't scattered later
+        state['fail'] = False
+        self.assertEqual(nd.as_py(b), [[2 * i, 2 * i + 2, 2 * i + 4] for i in range(10)])
+
+    def test_buffered_broadcast(self):
+        def multiplier(dst, src0, src1):
+            for d, s0, s1 in zip(dst, src0, src1):
+                d[...] = nd.as_py(s0) * nd.as_py(s1)
+        a = nd.array([[1, 2, 3], [4, 5, 6]])
+        b = nd.array([10, 100, 1000])
+        c = nd.elwise_map([a, b], multiplier, ndt.int32, block_size=4)
+        self.assertEqual(nd.as_py(c), [[10, 200, 3000], [40, 500, 6000]])
+        c = nd.elwise_map([a, nd.array(2)], multiplier, ndt.int32, block_size=4)
+        self.assertEqual(nd.as_py(c), [[2, 4, 6], [8, 10, 12]])
+
+    def test_buffered_fallback(self):
+        # String elements don't go through the staging buffers
+        def upper(dst, src):
+            dst[...] = [nd.as_py(x).upper() for x in src]
+        a = nd.array(['abc', 'de'])
+        b = nd.elwise_map([a], upper, ndt.string, block_size=64)
+        self.assertEqual(nd.as_py(b), ['ABC', 'DE'])
+        self.assertRaises(ValueError, nd.elwise_map, [a], upper,
+                        ndt.string, block_size=-1)
+
+class TestElwiseMapNumpy(unittest.TestCase):
+    def test_unary_numpy(self):
+        def doubler(dst, src):
+            self.assertTrue(isinstance(dst, np.ndarray))
+            self.assertTrue(isinstance(src, np.ndarray))
+            dst[...] = 2 * src
+        a = nd.range(1000)
+        b = nd.elwise_map([a], doubler, ndt.int32, numpy=True)
+        self.assertEqual(nd.as_py(b), [2 * i for i in range(1000)])
+        self.assertEqual(nd.as_py(b[1::100]), [2 * i for i in range(1, 1000, 100)])
+
+    def test_binary_numpy_broadcast(self):
+        def multiplier(dst, src0, src1):
+            np.multiply(src0, src1, out=dst)
+        a = nd.array([[1, 2, 3], [4, 5, 6]])
+        b = nd.array([10, 100, 1000])
+        c = nd.elwise_map([a, b], multiplier, ndt.int64, numpy=True)
+        self.assertEqual(nd.as_py(c), [[10, 200, 3000], [40, 500, 6000]])
+        c = nd.elwise_map([a, b], multiplier, ndt.int64,
+                        numpy=True, block_size=4)
+        self.assertEqual(nd.as_py(c), [[10, 200, 3000], [40, 500, 6000]])
+
+    def test_numpy_struct(self):
+        def topolar(dst, src):
+            dst['r'] = np.hypot(src['x'], src['y'])
+            dst['theta'] = np.arctan2(src['y'], src['x'])
+        a = nd.array(np.array([(3, 4), (0, 2)],
+                        dtype=[('x', np.float64), ('y', np.float64)]))
+        b = nd.elwise_map([a], topolar,
+                        ndt.make_cstruct([ndt.float64, ndt.float64], ['r', 'theta']),
+                        numpy=True)
+        self.assertEqual(nd.as_py(b.r), [5, 2])
+        self.assertAlmostEqual(nd.as_py(b.theta)[1], np.pi / 2)
+
+    def test_numpy_held_reference(self):
+        held = []
+        def keeper(dst, src):
+            held.append(src[1:])
+            dst[...] = src
+        b = nd.elwise_map([nd.range(10)], keeper, ndt.int64, numpy=True)
+        self.assertRaises(RuntimeError, b.eval)
+
 if __name__ == '__main__':
     unittest.main()
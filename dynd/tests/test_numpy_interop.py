@@ -122,6 +122,64 @@ class TestNumpyDTypeInterop(unittest.TestCase):
         self.assertRaises(TypeError, ndt.bytes.as_numpy)
         self.assertRaises(TypeError, ndt.string.as_numpy)
 
+class TestNumpyTypeCache(unittest.TestCase):
+    def setUp(self):
+        ndt.clear_numpy_type_cache()
+
+    def test_from_numpy_hits(self):
+        dt = np.dtype([('x', np.int32), ('y', np.float64), ('z', 'S8')])
+        a = np.zeros(3, dtype=dt)
+        b = nd.view(a)
+        info = ndt.numpy_type_cache_info()
+        misses = info['from_numpy']['misses']
+        self.assertTrue(misses > 0)
+        for i in range(10):
+            self.assertEqual(nd.type_of(nd.view(a)), nd.type_of(b))
+        info = ndt.numpy_type_cache_info()
+        self.assertEqual(info['from_numpy']['misses'], misses)
+        self.assertTrue(info['from_numpy']['hits'] >= 10)
+
+    def test_renamed_fields(self):
+        # Renaming the fields of a dtype in place must not
+        # return the stale cached type
+        dt = np.dtype([('x', np.int32), ('y', np.int32)])
+        self.assertEqual(nd.as_py(ndt.type(dt).field_names), ['x', 'y'])
+        dt.names = ('a', 'b')
+        self.assertEqual(nd.as_py(ndt.type(dt).field_names), ['a', 'b'])
+
+    def test_to_numpy_hits(self):
+        tp = ndt.type('{x : int32, y : int64}')
+        self.assertEqual(tp.as_numpy(),
+                        np.dtype([('x', np.int32), ('y', np.int64)], align=True))
+        info = ndt.numpy_type_cache_info()
+        self.assertEqual(info['to_numpy']['misses'], 1)
+        self.assertEqual(tp.as_numpy(),
+                        np.dtype([('x', np.int32), ('y', np.int64)], align=True))
+        info = ndt.numpy_type_cache_info()
+        self.assertEqual(info['to_numpy']['hits'], 1)
+        self.assertEqual(info['to_numpy']['size'], 1)
+
+    def test_to_numpy_modified(self):
+        # Modifying a returned dtype in place must not change
+        # the conversions after it
+        tp = ndt.type('{x : int32, y : int64}')
+        for i in range(2):
+            dt = tp.as_numpy()
+            self.assertEqual(dt.names, ('x', 'y'))
+            dt.names = ('a', 'b')
+        self.assertEqual(tp.as_numpy().names, ('x', 'y'))
+
+    def test_bounded(self):
+        capacity = ndt.numpy_type_cache_info()['capacity']
+        for i in range(capacity + 10):
+            ndt.type(np.dtype([('f%d' % i, np.int8)]))
+        info = ndt.numpy_type_cache_info()
+        self.assertTrue(info['from_numpy']['size'] <= capacity)
+        ndt.clear_numpy_type_cache()
+        info = ndt.numpy_type_cache_info()
+        self.assertEqual(info['from_numpy']['size'], 0)
+        self.assertEqual(info['from_numpy']['hits'], 0)
+
 class TestNumpyViewInterop(unittest.TestCase):
     def setUp(self):
         if sys.byteorder == 'little':
@@ -376,6 +434,45 @@ class TestAsNumpy(unittest.TestCase):
         self.assertEqual(nd.as_py(a.x), b['x'].tolist())
         self.assertEqual(nd.as_py(a.y), b['y'].tolist())
 
+    def test_date_as_numpy(self):
+        a = nd.array([date(2000, 12, 13), date(1995, 5, 2), date(1970, 1, 1)])
+        b = nd.as_numpy(a, allow_copy=True)
+        self.assertEqual(b.dtype, np.dtype('M8[D]'))
+        assert_equal(b, np.array(['2000-12-13', '1995-05-02', '1970-01-01'],
+                        dtype='M8[D]'))
+        # Non-contiguous and multi-dimensional
+        a = nd.array([[date(2000, 1, i), date(2001, 2, i)] for i in range(1, 4)])
+        b = nd.as_numpy(a[:, ::-1], allow_copy=True)
+        self.assertEqual(b.shape, (3, 2))
+        self.assertEqual(b.tolist(), nd.as_py(a[:, ::-1]))
+
+    def test_string_as_numpy(self):
+        a = nd.array([u'abc', u'', u'\xe9t\xe9', u'longer string'])
+        self.assertEqual(nd.type_of(a).element_type, ndt.string)
+        self.assertRaises(TypeError, nd.as_numpy, a)
+        b = nd.as_numpy(a, allow_copy=True)
+        # The unicode dtype is sized for the longest string
+        self.assertEqual(b.dtype, np.dtype('U13'))
+        self.assertEqual(b.tolist(), nd.as_py(a))
+        b = nd.as_numpy(a[::-2], allow_copy=True)
+        self.assertEqual(b.dtype, np.dtype('U13'))
+        self.assertEqual(b.tolist(), [u'longer string', u''])
+        # Code points outside the BMP
+        a = nd.array([[u'\U0001f600x', u'y'], [u'', u'z\u20ac']])
+        b = nd.as_numpy(a, allow_copy=True)
+        self.assertEqual(b.dtype, np.dtype('U2'))
+        self.assertEqual(b.tolist(), nd.as_py(a))
+        # All empty strings
+        b = nd.as_numpy(nd.array([u'', u'']), allow_copy=True)
+        self.assertEqual(b.dtype, np.dtype('U1'))
+        self.assertEqual(b.tolist(), [u'', u''])
+
+    def test_utf8_fixedstring_as_numpy(self):
+        a = nd.array([u'\xe9t\xe9', u'a'], dtype=ndt.make_fixedstring(6, 'utf_8'))
+        b = nd.as_numpy(a, allow_copy=True)
+        self.assertEqual(b.dtype, np.dtype('U6'))
+        self.assertEqual(b.tolist(), [u'\xe9t\xe9', u'a'])
+
 class TestNumpyScalarInterop(unittest.TestCase):
     def test_numpy_scalar_conversion_dtypes(self):
         self.assertEqual(nd.dtype_of(nd.array(np.bool_(True))), ndt.bool)
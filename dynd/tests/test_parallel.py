@@ -0,0 +1,210 @@
+import sys
+import threading
+import unittest
+from dynd import nd, ndt, _lowlevel
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+class TestParallelListFill(unittest.TestCase):
+    def setUp(self):
+        self.saved_num_threads = nd.get_num_threads()
+        nd.set_num_threads(4)
+
+    def tearDown(self):
+        nd.set_num_threads(self.saved_num_threads)
+
+    def test_num_threads(self):
+        self.assertEqual(nd.get_num_threads(), 4)
+        nd.set_num_threads(0)
+        self.assertTrue(nd.get_num_threads() >= 1)
+        self.assertRaises(RuntimeError, nd.set_num_threads, -1)
+
+    def test_float64_1d(self):
+        lst = [i * 0.5 for i in range(1000000)]
+        a = nd.array(lst)
+        self.assertEqual(a.shape, (1000000,))
+        self.assertEqual(nd.dtype_of(a), ndt.float64)
+        self.assertEqual(nd.as_py(a), lst)
+
+    def test_float64_2d(self):
+        lst = [[i * 0.25, i * 0.5, i * 1.5] for i in range(400000)]
+        a = nd.array(lst)
+        self.assertEqual(a.shape, (400000, 3))
+        self.assertEqual(nd.dtype_of(a), ndt.float64)
+        self.assertEqual(nd.as_py(a), lst)
+
+    def test_fallback(self):
+        # Values the parallel fill can't read directly fall back
+        # to the serial conversion
+        lst = [i * 0.5 for i in range(1000000)]
+        lst[-1] = 3j
+        a = nd.array(lst)
+        self.assertEqual(nd.dtype_of(a), ndt.complex_float64)
+        self.assertEqual(nd.as_py(a), lst)
+
+        lst = [[i * 0.25, i * 0.5] for i in range(400000)]
+        lst[123456] = [1.0]
+        a = nd.array(lst)
+        self.assertEqual(nd.as_py(a), lst)
+
+class TestParallelEval(unittest.TestCase):
+    def test_eval_1d(self):
+        a = nd.range(100000).ucast(ndt.float64)
+        b = a.eval(threads=4)
+        self.assertEqual(nd.dtype_of(b), ndt.float64)
+        self.assertEqual(nd.as_py(b), nd.as_py(a.eval(threads=1)))
+
+    def test_eval_2d(self):
+        lst = [[i, i + 1, i + 2] for i in range(50000)]
+        a = nd.array(lst).ucast(ndt.float64)
+        b = a.eval(threads=3)
+        self.assertEqual(b.shape, (50000, 3))
+        self.assertEqual(nd.as_py(b), [[float(x) for x in row] for row in lst])
+
+    def test_eval_small(self):
+        # Too small to split, evaluates on the calling thread
+        a = nd.range(10).ucast(ndt.float64)
+        self.assertEqual(nd.as_py(a.eval(threads=4)), [float(i) for i in range(10)])
+
+    def test_eval_string(self):
+        # Strings allocate from a shared memory block, so
+        # they're evaluated on the calling thread
+        a = nd.range(100000).ucast(ndt.string)
+        b = a.eval(threads=4)
+        self.assertEqual(nd.dtype_of(b), ndt.string)
+        self.assertEqual(nd.as_py(b), [str(i) for i in range(100000)])
+
+    def test_eval_error(self):
+        a = nd.range(100000).ucast(ndt.int8)
+        self.assertRaises(OverflowError, a.eval, threads=4)
+        self.assertRaises(RuntimeError, a.eval, threads=-1)
+
+    def test_eval_python_error(self):
+        # The error raised by the callable on a pool thread
+        # reaches the caller as is
+        def fail(dst, src):
+            raise ValueError('from the callable')
+        a = nd.elwise_map([nd.range(100000)], fail, ndt.int32)
+        self.assertRaises(ValueError, a.eval, threads=4)
+
+    def test_eval_nested(self):
+        # Evaluating in parallel from inside a chunk runs serially
+        inner = nd.range(100000).ucast(ndt.float64)
+        def add_sum(dst, src):
+            total = nd.as_py(inner.eval(threads=4)[-1])
+            dst[...] = [nd.as_py(x) + total for x in src]
+        a = nd.elwise_map([nd.range(100000)], add_sum, ndt.float64)
+        b = a.eval(threads=4)
+        self.assertEqual(nd.as_py(b[:3]), [99999.0, 100000.0, 100001.0])
+        self.assertEqual(nd.as_py(b[-1]), 199998.0)
+
+@unittest.skipIf(np is None, 'numpy is not available')
+class TestParallelReduction(unittest.TestCase):
+    def setUp(self):
+        self.saved_num_threads = nd.get_num_threads()
+        nd.set_num_threads(4)
+
+    def tearDown(self):
+        nd.set_num_threads(self.saved_num_threads)
+
+    def lift(self, ufunc, tp, lifted_type, **kwargs):
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(ufunc, (tp, tp, tp), False)
+        return _lowlevel.lift_reduction_ckernel_deferred(ckd, lifted_type,
+                        associative=True, commutative=True, **kwargs)
+
+    def test_sum_1d(self):
+        sum = self.lift(np.add, np.int64, 'strided * int64')
+        a = nd.range(1000003, dtype=ndt.int64)
+        out = nd.empty(ndt.int64)
+        sum.__call__(out, a)
+        self.assertEqual(nd.as_py(out), 1000002 * 1000003 // 2)
+        # Too small to split, runs on the calling thread
+        sum.__call__(out, a[:10])
+        self.assertEqual(nd.as_py(out), 45)
+
+    def test_sum_2d(self):
+        sum = self.lift(np.add, np.float64, 'strided * strided * float64')
+        a = nd.array(np.arange(600000, dtype=np.float64).reshape(200000, 3))
+        out = nd.empty(ndt.float64)
+        sum.__call__(out, a)
+        self.assertEqual(nd.as_py(out), float(599999 * 600000 // 2))
+
+    def test_minmax(self):
+        x = np.random.RandomState(0).randint(-10**9, 10**9, 500000).astype(np.int32)
+        a = nd.array(x)
+        out = nd.empty(ndt.int32)
+        self.lift(np.minimum, np.int32, 'strided * int32').__call__(out, a)
+        self.assertEqual(nd.as_py(out), x.min())
+        self.lift(np.maximum, np.int32, 'strided * int32').__call__(out, a)
+        self.assertEqual(nd.as_py(out), x.max())
+
+    def test_acquiregil(self):
+        # The ufunc kernels which acquire the GIL work from the threads
+        ckd = _lowlevel.ckernel_deferred_from_ufunc(np.add,
+                        (np.float64, np.float64, np.float64), True)
+        sum = _lowlevel.lift_reduction_ckernel_deferred(ckd, 'strided * float64',
+                        associative=True, commutative=True)
+        out = nd.empty(ndt.float64)
+        sum.__call__(out, nd.range(400000, dtype=ndt.float64))
+        self.assertEqual(nd.as_py(out), float(399999 * 400000 // 2))
+
+    def test_dst_initialization(self):
+        # Initializing with the negated first element must only
+        # happen once, so this reduction isn't split across threads
+        neg = _lowlevel.ckernel_deferred_from_ufunc(np.negative,
+                        (np.int64, np.int64), False)
+        sum = self.lift(np.add, np.int64, 'strided * int64',
+                        dst_initialization=neg)
+        out = nd.empty(ndt.int64)
+        sum.__call__(out, nd.range(1, 1000001, dtype=ndt.int64))
+        self.assertEqual(nd.as_py(out), 1000000 * 1000001 // 2 - 2)
+
+class TestReleaseGIL(unittest.TestCase):
+    def run_threads(self, fn, count=4):
+        errors = []
+        def wrapper():
+            try:
+                fn()
+            except Exception as e:
+                errors.append(e)
+        threads = [threading.Thread(target=wrapper) for i in range(count)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        if errors:
+            raise errors[0]
+
+    def test_eval_concurrent(self):
+        a = nd.range(100000, dtype=ndt.float64)
+        def fn():
+            for i in range(10):
+                b = (a + a).eval()
+                self.assertEqual(nd.as_py(b[10]), 20.0)
+        self.run_threads(fn)
+
+    def test_elwise_map_concurrent(self):
+        # The elwise_map kernel calls back into Python, so it must
+        # reacquire the GIL released by eval
+        def doubler(dst, src):
+            dst[...] = [2 * nd.as_py(x) for x in src]
+        a = nd.range(1000)
+        def fn():
+            for i in range(5):
+                b = nd.elwise_map([a], doubler, ndt.int32).eval()
+                self.assertEqual(nd.as_py(b[:5]), [0, 2, 4, 6, 8])
+        self.run_threads(fn)
+
+    def test_json_concurrent(self):
+        def fn():
+            for i in range(20):
+                a = nd.parse_json('var, int32', '[1, 2, 3, 4, 5]')
+                self.assertEqual(nd.as_py(a), [1, 2, 3, 4, 5])
+                self.assertEqual(nd.as_py(nd.format_json(a)), '[1,2,3,4,5]')
+        self.run_threads(fn)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -69,6 +69,31 @@ class TestPythonList(unittest.TestCase):
         self.assertEqual(a.shape, (2,3))
         self.assertEqual(nd.as_py(a), lst)
 
+    def test_promotion(self):
+        # Each later element promotes the partially converted result
+        lst = [True, 1, 20000000000, 1.5, 2j]
+        a = nd.array(lst)
+        self.assertEqual(nd.dtype_of(a), ndt.complex_float64)
+        self.assertEqual(a.shape, (5,))
+        self.assertEqual(nd.as_py(a), lst)
+
+        lst = [[1, 2], [3, 4], [5, 6.5]]
+        a = nd.array(lst)
+        self.assertEqual(nd.dtype_of(a), ndt.float64)
+        self.assertEqual(a.shape, (3,2))
+        self.assertEqual(nd.as_py(a), lst)
+
+    def test_ragged_and_mixed(self):
+        # Lists which don't match the shape or kind guessed from
+        # the first element
+        lst = [[1, 2], [3], [4, 5, 6]]
+        a = nd.array(lst)
+        self.assertEqual(nd.dtype_of(a), ndt.int32)
+        self.assertEqual(nd.as_py(a), lst)
+
+        lst = [[1.5, 2], [3, [4, 5]]]
+        self.assertRaises(RuntimeError, nd.array, lst)
+
     def test_date(self):
         lst = [date(2011, 3, 15), date(1933, 12, 25), date(1979, 3, 22)]
         lststr = ['2011-03-15', '1933-12-25', '1979-03-22']
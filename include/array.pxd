@@ -54,9 +54,6 @@ cdef extern from "dynd/array.hpp" namespace "dynd":
 
         void debug_print(ostream&)
 
-    ndarray dynd_groupby "dynd::nd::groupby" (ndarray&, ndarray&, ndt_type) except +translate_exception
-    ndarray dynd_groupby "dynd::nd::groupby" (ndarray&, ndarray&) except +translate_exception
-
 cdef extern from "array_functions.hpp" namespace "pydynd":
     void init_w_array_typeobject(object)
 
@@ -75,8 +72,13 @@ cdef extern from "array_functions.hpp" namespace "pydynd":
     void array_init_from_pyobject(ndarray&, object, object) except +translate_exception
     ndarray array_view(object, object) except +translate_exception
     ndarray array_asarray(object, object) except +translate_exception
-    ndarray array_eval(ndarray&) except +translate_exception
+    ndarray array_eval(ndarray&, int) except +translate_exception
     ndarray array_eval_copy(ndarray&, object) except +translate_exception
+    ndarray dynd_groupby "pydynd::array_groupby" (ndarray&, ndarray&, ndt_type&) except +translate_exception
+    ndarray dynd_groupby "pydynd::array_groupby" (ndarray&, ndarray&) except +translate_exception
+    ndarray dynd_parse_json_type "pydynd::array_parse_json" (ndt_type&, ndarray&) except +translate_exception
+    void dynd_parse_json_array "pydynd::array_parse_json" (ndarray&, ndarray&) except +translate_exception
+    ndarray dynd_format_json "pydynd::array_format_json" (ndarray&) except +translate_exception
     ndarray array_zeros(ndt_type&, object) except +translate_exception
     ndarray array_zeros(object, ndt_type&, object) except +translate_exception
     ndarray array_ones(ndt_type&, object) except +translate_exception
@@ -96,6 +98,7 @@ cdef extern from "array_functions.hpp" namespace "pydynd":
 
     ndarray array_getitem(ndarray&, object) except +translate_exception
     void array_setitem(ndarray&, object, object) except +translate_exception
+    object array_item(ndarray&, object) except +translate_exception
     object array_get_shape(ndarray&) except +translate_exception
     object array_get_strides(ndarray&) except +translate_exception
 
@@ -108,11 +111,25 @@ cdef extern from "array_functions.hpp" namespace "pydynd":
 
     ndarray array_cast(ndarray&, ndt_type&, object) except +translate_exception
     ndarray array_ucast(ndarray&, ndt_type&, size_t, object) except +translate_exception
-    object array_as_py(ndarray&) except +translate_exception
+    object array_as_py(ndarray&, bint) except +translate_exception
+    void init_w_lazy_string_sequence_typeobject(object)
+    object lazy_string_sequence_getitem(ndarray&, intptr_t) except +translate_exception
     object array_as_numpy(object, bint) except +translate_exception
     ndarray array_from_py(object) except +translate_exception
 
     int array_getbuffer_pep3118(object ndo, Py_buffer *buffer, int flags) except -1
     int array_releasebuffer_pep3118(object ndo, Py_buffer *buffer) except -1
-
-    const char *array_access_flags_string(ndarray&) except +translate_exception
\ No newline at end of file
+    object array_as_string_buffers(ndarray&) except +translate_exception
+
+    const char *array_access_flags_string(ndarray&) except +translate_exception
+cdef extern from "array_from_py_dynamic.hpp" namespace "pydynd":
+    cdef cppclass array_builder:
+        pass
+
+    array_builder *make_array_builder(object) except +translate_exception
+    void delete_array_builder(array_builder *)
+    void array_builder_append(array_builder *, object) except +translate_exception
+    void array_builder_extend(array_builder *, object) except +translate_exception
+    ndarray array_builder_finish(array_builder *) except +translate_exception
+    intptr_t array_builder_size(array_builder *)
+    object array_builder_get_dtype(array_builder *) except +translate_exception
@@ -23,6 +23,18 @@ namespace pydynd {
  */
 std::string make_pep3118_format(intptr_t& out_itemsize, const dynd::ndt::type& dt, const char *metadata = NULL);
 
+/**
+ * The format strings computed for PEP 3118 buffers are cached per
+ * dynd type. This returns a dict with the hit and miss counts, size
+ * and capacity of the cache.
+ */
+PyObject *pep3118_format_cache_info();
+
+/**
+ * Empties the PEP 3118 format string cache, and resets its counters.
+ */
+void clear_pep3118_format_cache();
+
 /**
  * \brief Converts an nd::array into a PEP3118 buffer.
  */
@@ -33,6 +45,18 @@ int array_getbuffer_pep3118(PyObject *ndo, Py_buffer *buffer, int flags);
  */
 int array_releasebuffer_pep3118(PyObject *ndo, Py_buffer *buffer);
 
+/**
+ * \brief Exports a one-dimensional array of strings or bytes as two
+ *        buffers, the way Arrow lays out variable-sized data.
+ *
+ * Returns a tuple ``(offsets, data)``, where ``offsets`` is an int64
+ * array of size ``len(n) + 1`` and string ``i`` is the bytes
+ * ``data[offsets[i]:offsets[i+1]]``. When the strings are already
+ * stored one after another in memory, ``data`` is a view of them,
+ * otherwise they are packed into a new buffer.
+ */
+PyObject *array_as_string_buffers(const dynd::nd::array& n);
+
 } // namespace pydynd
 
 #endif // _DYND__NDARRAY_AS_PEP3118_HPP_
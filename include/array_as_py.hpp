@@ -15,8 +15,34 @@ namespace pydynd {
 /**
  * Converts an nd::array into a Python object
  * using the default settings.
+ *
+ * \param n  The array to convert.
+ * \param lazy_strings  If true, and the array has a string dtype and at
+ *                      least one dimension, returns a lazy string sequence
+ *                      object viewing the array instead of a list, which
+ *                      decodes each string when it is accessed.
  */
-PyObject *array_as_py(const dynd::nd::array& n);
+PyObject *array_as_py(const dynd::nd::array& n, bool lazy_strings = false);
+
+/**
+ * Converts the value in a type/metadata/data triple into a Python
+ * object, the same way as array_as_py. The type must not be an
+ * expression type, as no evaluation is done.
+ */
+PyObject *element_as_py(const dynd::ndt::type& d, const char *metadata, const char *data);
+
+/**
+ * Registers the Cython type object of w_lazy_string_sequence,
+ * which array_as_py uses for lazy string conversion.
+ */
+void init_w_lazy_string_sequence_typeobject(PyObject *type);
+
+/**
+ * Returns element ``i`` of a lazy string sequence viewing ``n``, either
+ * a decoded Python string, or a nested lazy string sequence if ``n`` has
+ * more than one dimension.
+ */
+PyObject *lazy_string_sequence_getitem(const dynd::nd::array& n, intptr_t i);
 
 } // namespace pydynd
 
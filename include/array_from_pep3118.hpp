@@ -0,0 +1,57 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines viewing objects which export the
+// PEP 3118 buffer protocol as dynd arrays.
+//
+
+#ifndef _DYND__ARRAY_FROM_PEP3118_HPP_
+#define _DYND__ARRAY_FROM_PEP3118_HPP_
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+
+namespace pydynd {
+
+/**
+ * \brief Converts a PEP 3118 format string into a dynd type.
+ *
+ * This is the inverse of ``make_pep3118_format``. Builtin scalars,
+ * complex ('Z'), fixed strings ('s', 'w'), subarrays ('(2,3)d')
+ * and structs ('T{...}') are supported. Non-native byte orders
+ * produce byteswap types.
+ *
+ * \param format  The PEP 3118 (struct module) format string.
+ * \param data_alignment  The alignment the data is known to have,
+ *                        elements which need more become unaligned
+ *                        types. Use 0 to assume aligned data.
+ */
+dynd::ndt::type pep3118_type_from_format(const char *format, size_t data_alignment = 0);
+
+/**
+ * Returns true if the object exports the PEP 3118 buffer protocol,
+ * and should be viewed through it. Python bytes and unicode objects,
+ * which have their own conversions to dynd, are excluded.
+ */
+bool is_pep3118_exporter(PyObject *obj);
+
+/**
+ * \brief Views an object exporting the PEP 3118 buffer protocol
+ *        as a strided dynd array.
+ *
+ * The array holds on to the Py_buffer until it is freed, so the
+ * exporter's memory stays valid and locked for as long as the
+ * view exists.
+ *
+ * \param obj  The buffer exporter.
+ * \param access_flags  Either 0 to use the buffer's access, or
+ *                      the access flags the result requires.
+ * \param always_copy  If true, a copy of the buffer is returned.
+ */
+dynd::nd::array array_from_pep3118(PyObject *obj, uint32_t access_flags, bool always_copy);
+
+} // namespace pydynd
+
+#endif // _DYND__ARRAY_FROM_PEP3118_HPP_
@@ -8,6 +8,8 @@
 
 #include <Python.h>
 
+#include <vector>
+
 #include <dynd/array.hpp>
 
 namespace pydynd {
@@ -29,6 +31,73 @@ namespace pydynd {
  */
 dynd::nd::array array_from_py_dynamic(PyObject *obj);
 
+/**
+ * Builds a one-dimensional array from a stream of Python values,
+ * appended one at a time or from an iterator.
+ *
+ * The values are stored in a list of chunks which grow geometrically,
+ * and are only concatenated once, by finish(). If no dtype is given,
+ * it is deduced from the values, and when a value requires a promoted
+ * dtype, only a new chunk is started with it. Earlier chunks are
+ * converted to the final dtype during the concatenation.
+ */
+class array_builder {
+    struct chunk {
+        dynd::ndt::type dtype;
+        dynd::nd::array arr;
+        intptr_t size, capacity, stride;
+        char *data;
+        const char *el_metadata;
+    };
+
+    // True if the dtype is deduced from the values
+    bool m_deduce_dtype;
+    dynd::ndt::type m_dtype;
+    std::vector<chunk> m_chunks;
+    intptr_t m_size;
+
+    chunk& get_writable_chunk();
+    void promote_dtype(PyObject *obj);
+
+    // Non-copyable
+    array_builder(const array_builder&);
+    array_builder& operator=(const array_builder&);
+
+public:
+    /**
+     * Creates a builder for elements of type 'dtype', or
+     * deducing the type from the values if 'dtype' is
+     * uninitialized.
+     */
+    array_builder(const dynd::ndt::type& dtype);
+
+    void append(PyObject *obj);
+    void extend(PyObject *iterable);
+
+    /**
+     * Returns the built array, with a strided leading dimension,
+     * and resets the builder to empty.
+     */
+    dynd::nd::array finish();
+
+    intptr_t size() const {
+        return m_size;
+    }
+
+    /** The current dtype, or uninitialized if none is known yet */
+    const dynd::ndt::type& get_dtype() const {
+        return m_dtype;
+    }
+};
+
+array_builder *make_array_builder(PyObject *dtype);
+void delete_array_builder(array_builder *builder);
+void array_builder_append(array_builder *builder, PyObject *obj);
+void array_builder_extend(array_builder *builder, PyObject *iterable);
+dynd::nd::array array_builder_finish(array_builder *builder);
+intptr_t array_builder_size(const array_builder *builder);
+PyObject *array_builder_get_dtype(const array_builder *builder);
+
 } // namespace pydynd
 
 #endif // _DYND__ARRAY_FROM_PY_DYNAMIC_HPP_
@@ -24,6 +24,8 @@
 
 namespace pydynd {
 
+class array_hash_index;
+
 /**
  * This is the typeobject and struct of w_array from Cython.
  */
@@ -38,6 +40,8 @@ struct WArray {
   PyObject_HEAD;
   // This is array_placement_wrapper in Cython-land
   dynd::nd::array v;
+  // A lazily built lookup index for ``x in self``, or NULL
+  array_hash_index *index;
 };
 void init_w_array_typeobject(PyObject *type);
 
@@ -70,10 +74,27 @@ void array_init_from_pyobject(dynd::nd::array& n, PyObject* obj, PyObject *acces
 dynd::nd::array array_view(PyObject *obj, PyObject *access);
 dynd::nd::array array_asarray(PyObject *obj, PyObject *access);
 
-dynd::nd::array array_eval(const dynd::nd::array& n);
+/**
+ * The functions which do the heavy lifting in dynd, like evaluation,
+ * groupby, and JSON parsing/formatting, release the GIL while they
+ * run. The ckernels which call back into Python (elwise_map, ufuncs
+ * wrapped with acquire_gil) acquire it again as needed.
+ *
+ * array_eval splits the evaluation of large expression arrays across
+ * ``num_threads`` threads, where 0 means the value of get_num_threads().
+ */
+dynd::nd::array array_eval(const dynd::nd::array& n, int num_threads = 0);
 dynd::nd::array array_eval_copy(const dynd::nd::array& n,
                 PyObject* access,
                 const dynd::eval::eval_context *ectx = &dynd::eval::default_eval_context);
+dynd::nd::array array_groupby(const dynd::nd::array& data,
+                const dynd::nd::array& by, const dynd::ndt::type& groups);
+dynd::nd::array array_groupby(const dynd::nd::array& data,
+                const dynd::nd::array& by);
+dynd::nd::array array_parse_json(const dynd::ndt::type& tp,
+                const dynd::nd::array& json);
+void array_parse_json(dynd::nd::array& out, const dynd::nd::array& json);
+dynd::nd::array array_format_json(const dynd::nd::array& n);
 
 dynd::nd::array array_zeros(const dynd::ndt::type& d, PyObject *access);
 dynd::nd::array array_zeros(PyObject *shape, const dynd::ndt::type& d, PyObject *access);
@@ -186,6 +207,13 @@ dynd::nd::array array_getitem(const dynd::nd::array& n, PyObject *subscript);
  */
 void array_setitem(const dynd::nd::array& n, PyObject *subscript, PyObject *value);
 
+/**
+ * Implementation of nd.array.item(), which returns a single element
+ * as a Python object. Integer subscripts into strided and fixed
+ * dimensions are converted straight from the element's data.
+ */
+PyObject *array_item(const dynd::nd::array& n, PyObject *args);
+
 /**
  * Implementation of nd.range().
  */
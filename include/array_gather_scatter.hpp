@@ -0,0 +1,45 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines indexing of an array's leading
+// dimension with an array of integers or a boolean mask.
+//
+
+#ifndef _DYND__ARRAY_GATHER_SCATTER_HPP_
+#define _DYND__ARRAY_GATHER_SCATTER_HPP_
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+
+namespace pydynd {
+
+/**
+ * If 'subscript' is a one-dimensional array of integers or booleans
+ * (an nd.array, a NumPy array, or a list), gathers the selected elements
+ * of the leading dimension of 'n' into a new array, and returns true.
+ * Returns false if 'subscript' isn't such an array.
+ *
+ * \param n  The array being indexed.
+ * \param subscript  The Python subscript object.
+ * \param out_result  On success, receives the gathered copy.
+ */
+bool array_gather(const dynd::nd::array& n, PyObject *subscript,
+                dynd::nd::array& out_result);
+
+/**
+ * If 'subscript' is a one-dimensional array of integers or booleans,
+ * assigns 'value', broadcast to the selected elements of the leading
+ * dimension of 'n', and returns true. Returns false if 'subscript'
+ * isn't such an array.
+ *
+ * \param n  The array being assigned to.
+ * \param subscript  The Python subscript object.
+ * \param value  The Python value being assigned.
+ */
+bool array_scatter(const dynd::nd::array& n, PyObject *subscript, PyObject *value);
+
+} // namespace pydynd
+
+#endif // _DYND__ARRAY_GATHER_SCATTER_HPP_
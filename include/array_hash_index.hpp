@@ -0,0 +1,117 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines a hashed lookup index over the
+// elements of a one-dimensional dynd array, used to
+// speed up ``x in a`` and nd.isin.
+//
+
+#ifndef _DYND__ARRAY_HASH_INDEX_HPP_
+#define _DYND__ARRAY_HASH_INDEX_HPP_
+
+#include <Python.h>
+
+#include <string>
+#include <unordered_set>
+
+#include <dynd/array.hpp>
+
+namespace pydynd {
+
+/**
+ * A hash set of the values in a one-dimensional array of
+ * builtin integers, strings, or dates. The values are
+ * copied into the index, so it stays valid if the array
+ * changes, but only reflects the array at build time.
+ */
+class array_hash_index {
+public:
+    enum key_kind_t {
+        int_keys,
+        string_keys,
+        date_keys
+    };
+
+private:
+    dynd::nd::array m_array;
+    key_kind_t m_key_kind;
+    std::unordered_set<int64_t> m_int_keys;
+    std::unordered_set<std::string> m_string_keys;
+
+    // Non-copyable
+    array_hash_index(const array_hash_index&);
+    array_hash_index& operator=(const array_hash_index&);
+
+public:
+    /**
+     * Builds an index of the values in ``n``, which must be
+     * one-dimensional with an element type for which
+     * ``get_key_kind`` returns true.
+     */
+    array_hash_index(const dynd::nd::array& n);
+
+    /**
+     * Determines which kind of key an element type hashes as,
+     * returning false if the type isn't supported. Floating
+     * point and uint64 elements are not supported.
+     */
+    static bool get_key_kind(const dynd::ndt::type& tp, key_kind_t& out_kind);
+
+    /** The array the index was built from */
+    const dynd::nd::array& get_array() const {
+        return m_array;
+    }
+
+    key_kind_t get_key_kind() const {
+        return m_key_kind;
+    }
+
+    size_t size() const {
+        return m_key_kind == string_keys ? m_string_keys.size() : m_int_keys.size();
+    }
+
+    /**
+     * Looks up a Python object in the index. Returns 1 or 0 for
+     * found or not found, and -1 if ``x`` isn't a value of the
+     * index's key kind, in which case the caller should fall
+     * back to comparing it against every element.
+     */
+    int contains(PyObject *x) const;
+
+    /**
+     * Returns a boolean array with the shape of ``a``, true
+     * where the element of ``a`` is in the index. The
+     * dimensions of ``a`` must be strided or fixed.
+     */
+    dynd::nd::array isin(const dynd::nd::array& a) const;
+};
+
+/**
+ * Arrays this size or larger which are immutable get a
+ * hash index built and cached the first time ``in`` is used.
+ */
+enum { array_hash_index_auto_min_size = 32 };
+
+/**
+ * Implements ``x in self`` for an nd.array object, building and
+ * caching a hash index for large immutable arrays.
+ */
+bool warray_contains(PyObject *self, PyObject *x);
+
+array_hash_index *build_array_hash_index(const dynd::nd::array& n);
+void delete_array_hash_index(array_hash_index *index);
+bool array_hash_index_contains(const array_hash_index *index, PyObject *x);
+intptr_t array_hash_index_size(const array_hash_index *index);
+dynd::nd::array array_hash_index_isin(const array_hash_index *index,
+                const dynd::nd::array& a);
+
+/**
+ * Returns a boolean array, true where the element of ``a`` is
+ * one of ``values``.
+ */
+dynd::nd::array array_isin(const dynd::nd::array& a, PyObject *values);
+
+} // namespace pydynd
+
+#endif // _DYND__ARRAY_HASH_INDEX_HPP_
@@ -0,0 +1,16 @@
+#
+# Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+# BSD 2-Clause License, see LICENSE.txt
+#
+
+cdef extern from "array_hash_index.hpp" namespace "pydynd":
+    cdef cppclass array_hash_index:
+        pass
+
+    bint warray_contains(object, object) except +translate_exception
+    array_hash_index *build_array_hash_index(ndarray&) except +translate_exception
+    void delete_array_hash_index(array_hash_index *)
+    bint array_hash_index_contains(array_hash_index *, object) except +translate_exception
+    intptr_t array_hash_index_size(array_hash_index *)
+    ndarray array_hash_index_isin(array_hash_index *, ndarray&) except +translate_exception
+    ndarray array_isin(ndarray&, object) except +translate_exception
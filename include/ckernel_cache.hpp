@@ -0,0 +1,57 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines a cache of instantiated ckernels, for
+// ckernel_deferreds which get instantiated with the same
+// types and metadata over and over.
+//
+
+#ifndef _DYND__CKERNEL_CACHE_HPP_
+#define _DYND__CKERNEL_CACHE_HPP_
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+#include <dynd/kernels/ckernel_deferred.hpp>
+
+namespace pydynd {
+
+/**
+ * \brief Wraps a ckernel_deferred so its instantiations are cached.
+ *
+ * Instantiating the result looks up the calling thread, the kernel
+ * request type and the bytes of the metadata in a process-wide LRU
+ * cache. On a miss, the
+ * wrapped ckernel_deferred is instantiated into a ckernel_builder
+ * owned by the cache. Either way, what gets added to the output
+ * ckernel_builder is a small ckernel which forwards to the cached one,
+ * so for example a ckernel_deferred made from a Python function is
+ * only called into once per distinct metadata.
+ *
+ * A cached ckernel is shared by every instantiation with the same key
+ * on one thread. ckernels which use their own data as scratch space
+ * during a call, like fused ones, can be cached, but ones which keep
+ * state from one call to the next, or which reenter themselves,
+ * should not be. Types whose
+ * metadata holds memory block references, like var dims, bypass the
+ * cache, since their metadata bytes don't identify the layout.
+ */
+void make_cached_ckernel_deferred(dynd::ckernel_deferred *out_ckd,
+                const dynd::nd::array& ckd);
+
+/**
+ * Returns a dict with the hit, miss and bypass counts, the size
+ * and the capacity of the ckernel instantiation cache.
+ */
+PyObject *ckernel_cache_info();
+
+/**
+ * Empties the ckernel instantiation cache, and resets its counters.
+ * ckernels instantiated from it stay valid.
+ */
+void clear_ckernel_cache();
+
+} // namespace pydynd
+
+#endif // _DYND__CKERNEL_CACHE_HPP_
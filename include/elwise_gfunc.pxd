@@ -3,15 +3,15 @@
 # BSD 2-Clause License, see LICENSE.txt
 #
 
-cdef extern from "<dynd/gfunc/elwise_gfunc.hpp>" namespace "dynd::gfunc":
+cdef extern from "elwise_gfunc_functions.hpp" namespace "pydynd":
     cdef cppclass elwise_gfunc:
         string& get_name()
 
-cdef extern from "elwise_gfunc_functions.hpp" namespace "pydynd":
-#    void elwise_gfunc_add_kernel(elwise_gfunc&, codegen_cache&, object) except +translate_exception
+    void elwise_gfunc_add_kernel(elwise_gfunc&, object) except +translate_exception
     object elwise_gfunc_call(elwise_gfunc&, object, object) except +translate_exception
-    string elwise_gfunc_repr(elwise_gfunc&) except +translate_exception
     string elwise_gfunc_debug_print(elwise_gfunc&) except +translate_exception
+    object elwise_gfunc_dispatch_cache_info(elwise_gfunc&) except +translate_exception
+    void elwise_gfunc_clear_dispatch_cache(elwise_gfunc&)
 
     cdef struct elwise_gfunc_placement_wrapper:
         pass
@@ -21,4 +21,4 @@ cdef extern from "elwise_gfunc_functions.hpp" namespace "pydynd":
     elwise_gfunc& GET(elwise_gfunc_placement_wrapper&)
 
 cdef extern from "elwise_map.hpp" namespace "pydynd":
-    object dynd_elwise_map "pydynd::elwise_map" (object n_obj, object callable, object dst_type, object src_type)
+    object dynd_elwise_map "pydynd::elwise_map" (object n_obj, object callable, object dst_type, object src_type, intptr_t block_size, bint numpy_views)
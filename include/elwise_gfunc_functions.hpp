@@ -8,48 +8,140 @@
 
 #include <Python.h>
 
-#include <sstream>
-#include <deque>
+#include <list>
+#include <string>
 #include <vector>
 
 #include <dynd/type.hpp>
-#include <dynd/codegen/codegen_cache.hpp>
-#include <dynd/gfunc/elwise_gfunc.hpp>
+#include <dynd/array.hpp>
 
 namespace pydynd {
 
-void elwise_gfunc_add_kernel(dynd::gfunc::elwise& gf, dynd::codegen_cache& cgcache, PyObject *kernel);
+/**
+ * An elementwise function with several signatures, each
+ * of which is a scalar ckernel_deferred. Calling it picks
+ * a kernel from the types of the arguments, lifts it to
+ * their dimensions, and broadcasts them into the output.
+ *
+ * The kernel chosen for a tuple of argument types, and its
+ * lifted version, are kept in a small LRU dispatch cache, so
+ * repeated calls with the same types skip the overload
+ * resolution and the lifting. It relies on the GIL to
+ * serialize access, like the other caches.
+ */
+class elwise_gfunc {
+public:
+    struct dispatch_entry {
+        // The argument types, the key of the entry
+        std::vector<dynd::ndt::type> arg_types;
+        // The dtype each argument is converted to, or an
+        // uninitialized type if it is passed as is
+        std::vector<dynd::ndt::type> convert_dtypes;
+        // The output dtype of the chosen kernel
+        dynd::ndt::type dst_dtype;
+        // The chosen kernel
+        dynd::nd::array ckd;
+        // The kernel lifted to the most recent output type
+        dynd::ndt::type lifted_dst_type;
+        dynd::nd::array lifted_ckd;
+    };
 
-PyObject *elwise_gfunc_call(dynd::gfunc::elwise& gf, PyObject *args, PyObject *kwargs);
+private:
+    std::string m_name;
+    // The kernels, in the order overload resolution tries them
+    std::vector<dynd::nd::array> m_kernels;
+    std::list<dispatch_entry> m_dispatch_cache;
+    size_t m_hits, m_misses;
 
-inline std::string elwise_gfunc_debug_print(dynd::gfunc::elwise& gf)
+    dispatch_entry resolve(const std::vector<dynd::ndt::type>& arg_types) const;
+
+public:
+    explicit elwise_gfunc(const char *name)
+        : m_name(name), m_hits(0), m_misses(0)
+    {
+    }
+
+    const std::string& get_name() const {
+        return m_name;
+    }
+
+    const std::vector<dynd::nd::array>& get_kernels() const {
+        return m_kernels;
+    }
+
+    /**
+     * Adds a kernel, which must be an nd.array of type
+     * ckernel_deferred with a unary or expr signature.
+     * Kernels added earlier take precedence.
+     */
+    void add_kernel(PyObject *ckd);
+
+    /**
+     * Returns a copy of the dispatch entry for the argument types,
+     * resolving it on a miss. It's a copy because calling the gfunc
+     * may run Python code which calls the gfunc again, evicting
+     * the cached entry.
+     */
+    dispatch_entry get_dispatch(const std::vector<dynd::ndt::type>& arg_types);
+
+    /**
+     * Records the lifted kernel in the dispatch entry for the
+     * argument types, if it is still in the cache.
+     */
+    void set_lifted(const std::vector<dynd::ndt::type>& arg_types,
+                    const dynd::ndt::type& lifted_dst_type,
+                    const dynd::nd::array& lifted_ckd);
+
+    void clear_dispatch_cache();
+
+    PyObject *dispatch_cache_info() const;
+};
+
+inline void elwise_gfunc_add_kernel(elwise_gfunc& gf, PyObject *kernel)
+{
+    gf.add_kernel(kernel);
+}
+
+/**
+ * Calls the gfunc on the positional arguments, which can be
+ * nd.arrays or anything convertible to them. The keyword
+ * argument 'out' provides an nd.array to write the result to,
+ * otherwise one with the broadcast shape is allocated.
+ */
+PyObject *elwise_gfunc_call(elwise_gfunc& gf, PyObject *args, PyObject *kwargs);
+
+std::string elwise_gfunc_debug_print(const elwise_gfunc& gf);
+
+inline PyObject *elwise_gfunc_dispatch_cache_info(const elwise_gfunc& gf)
+{
+    return gf.dispatch_cache_info();
+}
+
+inline void elwise_gfunc_clear_dispatch_cache(elwise_gfunc& gf)
 {
-    std::stringstream ss;
-    //gf.debug_print(ss); TODO reenable
-    ss << "temporarily disabled\n";
-    return ss.str();
+    gf.clear_dispatch_cache();
 }
 
 struct elwise_gfunc_placement_wrapper {
-    intptr_t dummy[(sizeof(dynd::gfunc::elwise) + sizeof(intptr_t) - 1)/sizeof(intptr_t)];
+    intptr_t dummy[(sizeof(elwise_gfunc) + sizeof(intptr_t) - 1)/sizeof(intptr_t)];
 };
 
 inline void placement_new(elwise_gfunc_placement_wrapper& v, const char *name)
 {
     // Call placement new
-    new (&v) dynd::gfunc::elwise(name);
+    new (&v) elwise_gfunc(name);
 }
 
 inline void placement_delete(elwise_gfunc_placement_wrapper& v)
 {
     // Call the destructor
-    ((dynd::gfunc::elwise *)(&v))->~elwise();
+    ((elwise_gfunc *)(&v))->~elwise_gfunc();
 }
 
 // placement cast
-inline dynd::gfunc::elwise& GET(elwise_gfunc_placement_wrapper& v)
+inline elwise_gfunc& GET(elwise_gfunc_placement_wrapper& v)
 {
-    return *(dynd::gfunc::elwise *)&v;
+    return *(elwise_gfunc *)&v;
 }
 
 } // namespace pydynd
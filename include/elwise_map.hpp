@@ -29,8 +29,15 @@ namespace pydynd {
  * \param callable  The Python callable which does the mapping.
  * \param dst_type  A dynd type for the destination elements.
  * \param src_type  A dynd type for the source elements.
+ * \param block_size  If nonzero, the elements of all the strided
+ *                    dimensions are gathered into contiguous buffers,
+ *                    and the callable is called once per block of
+ *                    this many elements.
+ * \param numpy_views  If true, the callable is given NumPy arrays
+ *                     viewing the data instead of dynd arrays.
  */
-PyObject *elwise_map(PyObject *n_obj, PyObject *callable, PyObject *dst_type, PyObject *src_type);
+PyObject *elwise_map(PyObject *n_obj, PyObject *callable, PyObject *dst_type,
+                PyObject *src_type, intptr_t block_size = 0, bool numpy_views = false);
 
 } // namespace pydynd
 
@@ -0,0 +1,44 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines fusing a pipeline of ckernel_deferreds
+// into one, which keeps its intermediate values in cache.
+//
+
+#ifndef _DYND__FUSE_CKERNEL_DEFERRED_HPP_
+#define _DYND__FUSE_CKERNEL_DEFERRED_HPP_
+
+#include <Python.h>
+
+#include <vector>
+
+#include <dynd/array.hpp>
+#include <dynd/kernels/ckernel_deferred.hpp>
+
+namespace pydynd {
+
+/**
+ * \brief Fuses a pipeline of elementwise ckernel_deferreds into one.
+ *
+ * The first stage may take any number of inputs, and each following
+ * stage takes the output of the one before it as its only input, so
+ * the result has the output type of the last stage and the input
+ * types of the first. The intermediate types must be POD types
+ * without metadata.
+ *
+ * The fused strided ckernel works through its input in tiles sized
+ * to stay in the L1 cache, running every stage on a tile before
+ * moving on to the next, with the intermediate values in small
+ * scratch buffers. Lifting the result therefore makes one pass
+ * over memory for the whole pipeline.
+ *
+ * \param out_ckd  The ckernel_deferred to fill in.
+ * \param stages  The ckernel_deferreds, in the order they're applied.
+ */
+void fuse_ckernel_deferreds(dynd::ckernel_deferred *out_ckd,
+                const std::vector<dynd::nd::array>& stages);
+
+} // namespace pydynd
+
+#endif // _DYND__FUSE_CKERNEL_DEFERRED_HPP_
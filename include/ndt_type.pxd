@@ -139,3 +139,9 @@ cdef extern from "type_functions.hpp" namespace "pydynd":
 
 cdef extern from "numpy_interop.hpp" namespace "pydynd":
     object numpy_dtype_obj_from_ndt_type(ndt_type&) except +translate_exception
+    object dynd_numpy_type_cache_info "pydynd::numpy_type_cache_info" () except +translate_exception
+    void dynd_clear_numpy_type_cache "pydynd::clear_numpy_type_cache" ()
+
+cdef extern from "array_as_pep3118.hpp" namespace "pydynd":
+    object dynd_pep3118_format_cache_info "pydynd::pep3118_format_cache_info" () except +translate_exception
+    void dynd_clear_pep3118_format_cache "pydynd::clear_pep3118_format_cache" ()
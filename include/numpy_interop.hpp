@@ -161,6 +161,18 @@ dynd::nd::array array_from_numpy_scalar(PyObject* obj, uint32_t access_flags);
  */
 char numpy_kindchar_of(const dynd::ndt::type& tp);
 
+/**
+ * The conversions between NumPy dtypes and dynd types are cached,
+ * keyed on the identity of the source type. This returns a dict
+ * with the hit and miss counts and sizes of the caches.
+ */
+PyObject *numpy_type_cache_info();
+
+/**
+ * Empties the NumPy dtype conversion caches, and resets their counters.
+ */
+void clear_numpy_type_cache();
+
 } // namespace pydynd
 
 #endif // DYND_NUMPY_INTEROP
@@ -46,6 +46,12 @@ PyObject *numpy_typetuples_from_ufunc(PyObject *ufunc);
 PyObject *ckernel_deferred_from_ufunc(PyObject *ufunc,
                 PyObject *type_tuple, int ckernel_acquires_gil);
 
+/**
+ * Returns true if 'ckd' was created by ckernel_deferred_from_ufunc
+ * from a loop of 'ufunc'.
+ */
+bool ckernel_deferred_is_from_ufunc(const dynd::ckernel_deferred *ckd, PyObject *ufunc);
+
 } // namespace pydynd
 
 #endif // _DYND__NUMPY_UFUNC_KERNEL_HPP_
\ No newline at end of file
@@ -0,0 +1,60 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines a small facility for splitting
+// work across threads, used by the optional parallel
+// code paths in pydynd.
+//
+
+#ifndef _DYND__PARALLEL_FOR_HPP_
+#define _DYND__PARALLEL_FOR_HPP_
+
+#include <functional>
+
+#include <dynd/config.hpp>
+
+namespace pydynd {
+
+/**
+ * Returns the number of threads the parallel code paths
+ * use. The default is 1, so parallel execution is opt-in.
+ */
+int get_num_threads();
+
+/**
+ * Sets the number of threads the parallel code paths use.
+ *
+ * \param num_threads  The number of threads, or 0 to use
+ *                     the number of hardware threads.
+ */
+void set_num_threads(int num_threads);
+
+/**
+ * Calls ``fn(begin, end)`` on disjoint chunks covering [0, count),
+ * using up to ``num_threads`` threads from a persistent pool. The
+ * calling thread works on the chunks too, and this returns once all
+ * of them are done. If any of the calls throws, one of the
+ * exceptions is rethrown on the calling thread, along with the
+ * Python error that was set when it was thrown, if any.
+ *
+ * Only one parallel_for runs on the pool at a time. A call made while
+ * the pool is busy by another thread, or one nested inside ``fn``,
+ * runs serially on the calling thread.
+ *
+ * The function is called without any change to the Python GIL, so
+ * if the calling thread holds it, ``fn`` must not use the Python API.
+ *
+ * \param count  The size of the range to split.
+ * \param min_chunk  The smallest chunk worth giving to a thread.
+ * \param fn  The function to call on each chunk.
+ * \param num_threads  The number of threads to use, or 0 for the
+ *                     value of ``get_num_threads()``.
+ */
+void parallel_for(intptr_t count, intptr_t min_chunk,
+                const std::function<void (intptr_t, intptr_t)>& fn,
+                int num_threads = 0);
+
+} // namespace pydynd
+
+#endif // _DYND__PARALLEL_FOR_HPP_
@@ -0,0 +1,8 @@
+#
+# Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+# BSD 2-Clause License, see LICENSE.txt
+#
+
+cdef extern from "parallel_for.hpp" namespace "pydynd":
+    int dynd_get_num_threads "pydynd::get_num_threads" ()
+    void dynd_set_num_threads "pydynd::set_num_threads" (int) except +translate_exception
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines a multi-threaded execution mode for
+// lifted reduction ckernel_deferreds.
+//
+
+#ifndef _DYND__PARALLEL_REDUCTION_HPP_
+#define _DYND__PARALLEL_REDUCTION_HPP_
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+#include <dynd/kernels/ckernel_deferred.hpp>
+
+namespace pydynd {
+
+/**
+ * Returns true if the reduction 'lifted_reduction', lifted from
+ * 'elwise_reduction', can be split across threads. This requires
+ * an associative and commutative operation that reduces every
+ * dimension of a strided leading dimension into a POD scalar, and
+ * whose element types all match that scalar, so that per-thread
+ * partial results can be combined with 'elwise_reduction'.
+ * Reductions with a 'dst_initialization' kernel are not split,
+ * because the partial results would each be initialized with it
+ * instead of being started from the reduction's own elements.
+ */
+bool can_parallelize_reduction(const dynd::nd::array& lifted_reduction,
+                const dynd::nd::array& elwise_reduction,
+                bool associative, bool commutative,
+                bool has_dst_initialization);
+
+/**
+ * \brief Wraps a lifted reduction so it runs across threads.
+ *
+ * When instantiated as a single kernel with ``get_num_threads()``
+ * above one and enough elements, the leading dimension is split into
+ * one chunk per thread. Each chunk is reduced by its own instance of
+ * the lifted reduction into a partial result on a separate cache line,
+ * so it is initialized the same way as the serial reduction, from the
+ * first element or ``reduction_identity``.
+ * The partial results are then combined in order with
+ * 'elwise_reduction'. Otherwise it instantiates the lifted reduction
+ * directly.
+ *
+ * \param out_ckd  The ckernel_deferred to fill in.
+ * \param lifted_reduction  The lifted reduction, for which
+ *                          ``can_parallelize_reduction`` is true.
+ * \param elwise_reduction  The reduction it was lifted from.
+ */
+void make_parallel_reduction_ckernel_deferred(dynd::ckernel_deferred *out_ckd,
+                const dynd::nd::array& lifted_reduction,
+                const dynd::nd::array& elwise_reduction);
+
+} // namespace pydynd
+
+#endif // _DYND__PARALLEL_REDUCTION_HPP_
@@ -43,8 +43,13 @@ struct py_lowlevel_api_t {
     PyObject *(*lift_reduction_ckernel_deferred)(PyObject *elwise_reduction, PyObject *lifted_type,
                     PyObject *dst_initialization, PyObject *axis, PyObject *keepdims,
                     PyObject *associative, PyObject *commutative,
-                    PyObject *right_associative, PyObject *reduction_identity);
+                    PyObject *right_associative, PyObject *reduction_identity,
+                    PyObject *summation);
     PyObject *(*ckernel_deferred_from_pyfunc)(PyObject *instantiate_pyfunc, PyObject *types);
+    PyObject *(*make_cached_ckernel_deferred)(PyObject *ckd);
+    PyObject *(*ckernel_cache_info)();
+    PyObject *(*clear_ckernel_cache)();
+    PyObject *(*fuse_ckernel_deferreds)(PyObject *ckds);
 };
 
 } // namespace pydynd
@@ -0,0 +1,68 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+// This header defines summation orders for lifted reductions
+// which are more accurate than a left fold.
+//
+
+#ifndef _DYND__SUMMATION_REDUCTION_HPP_
+#define _DYND__SUMMATION_REDUCTION_HPP_
+
+#include <Python.h>
+
+#include <dynd/array.hpp>
+#include <dynd/kernels/ckernel_deferred.hpp>
+
+namespace pydynd {
+
+enum summation_mode_t {
+    // A left fold, op(op(op(a, b), c), d)
+    summation_naive,
+    // A blocked pairwise tree, like NumPy's pairwise summation
+    summation_pairwise,
+    // Kahan-Babuska compensated floating point addition
+    summation_kahan
+};
+
+/**
+ * Parses the summation mode strings "naive", "pairwise" and "kahan".
+ */
+summation_mode_t pyarg_summation_mode(PyObject *mode_obj);
+
+/**
+ * \brief Makes a reduction which evaluates a lifted reduction in the
+ *        order given by 'mode', instead of a left fold.
+ *
+ * The reduction must reduce strided or fixed dimensions to a POD
+ * scalar of the same type as all of the elwise reduction's arguments,
+ * and the elwise reduction must be a loop of numpy.add from
+ * ``ckernel_deferred_from_ufunc``. An empty input gives the identity,
+ * or raises if there is none, like the naive order.
+ *
+ * For ``summation_pairwise``, elements are accumulated into eight
+ * interleaved partial results in leaves of 128 elements, which are
+ * combined in a balanced tree using 'elwise_reduction'. For
+ * ``summation_kahan``, the type must be float32 or float64, and the
+ * values are added directly with compensation.
+ *
+ * \param out_ckd  The ckernel_deferred to fill in.
+ * \param lifted_reduction  The lifted reduction, providing the types.
+ * \param elwise_reduction  The reduction it was lifted from.
+ * \param mode  The summation order.
+ * \param associative  Whether the elwise reduction is associative.
+ * \param has_dst_initialization  Whether a dst_initialization was
+ *                                given, which these modes don't support.
+ * \param reduction_identity  The identity, for reducing empty arrays,
+ *                            or a NULL array.
+ */
+void make_summation_reduction_ckernel_deferred(dynd::ckernel_deferred *out_ckd,
+                const dynd::nd::array& lifted_reduction,
+                const dynd::nd::array& elwise_reduction,
+                summation_mode_t mode, bool associative,
+                bool has_dst_initialization,
+                const dynd::nd::array& reduction_identity);
+
+} // namespace pydynd
+
+#endif // _DYND__SUMMATION_REDUCTION_HPP_
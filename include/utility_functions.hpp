@@ -118,6 +118,66 @@ public:
     }
 };
 
+/**
+ * A Python error taken out of a thread state with PyErr_Fetch, so
+ * it can be restored on another thread. The GIL must be held when
+ * calling any of the functions which modify it.
+ */
+struct saved_pyerr {
+    PyObject *type, *value, *traceback;
+
+    saved_pyerr()
+        : type(NULL), value(NULL), traceback(NULL)
+    {
+    }
+
+    bool empty() const {
+        return type == NULL;
+    }
+
+    /** Takes the current Python error, if any, discarding any held one. */
+    inline void fetch()
+    {
+        clear();
+        PyErr_Fetch(&type, &value, &traceback);
+    }
+
+    /** Sets the held error as the current Python error. */
+    inline void restore()
+    {
+        PyErr_Restore(type, value, traceback);
+        type = value = traceback = NULL;
+    }
+
+    inline void clear()
+    {
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        type = value = traceback = NULL;
+    }
+
+    /** Moves the error held by 'other' into this one. */
+    inline void take(saved_pyerr& other)
+    {
+        clear();
+        type = other.type;
+        value = other.value;
+        traceback = other.traceback;
+        other.type = other.value = other.traceback = NULL;
+    }
+};
+
+/**
+ * Sets where PyGILState_RAII saves a Python error left set when it
+ * releases the GIL for the last time on the calling thread, or NULL.
+ * Threads which have no Python thread state of their own, like the
+ * parallel_for workers, lose their thread state and any error in it
+ * at that point, so they use this to pass the error on.
+ */
+void set_thread_pyerr_sink(saved_pyerr *sink);
+saved_pyerr *get_thread_pyerr_sink();
+
 class PyGILState_RAII {
     PyGILState_STATE m_gstate;
 
@@ -129,10 +189,37 @@ public:
     }
 
     inline ~PyGILState_RAII() {
+        if (m_gstate == PyGILState_UNLOCKED && PyErr_Occurred()) {
+            saved_pyerr *sink = get_thread_pyerr_sink();
+            if (sink != NULL) {
+                sink->fetch();
+            }
+        }
         PyGILState_Release(m_gstate);
     }
 };
 
+/**
+ * Releases the GIL for the lifetime of the object, for wrapping
+ * pure dynd computation. Any code run inside, such as ckernels
+ * which call back into Python, must acquire the GIL again with
+ * PyGILState_RAII before touching the Python API.
+ */
+class PyAllowThreads_RAII {
+    PyThreadState *m_tstate;
+
+    PyAllowThreads_RAII(const PyAllowThreads_RAII&);
+    PyAllowThreads_RAII& operator=(const PyAllowThreads_RAII&);
+public:
+    inline PyAllowThreads_RAII() {
+        m_tstate = PyEval_SaveThread();
+    }
+
+    inline ~PyAllowThreads_RAII() {
+        PyEval_RestoreThread(m_tstate);
+    }
+};
+
 size_t pyobject_as_size_t(PyObject *obj);
 intptr_t pyobject_as_index(PyObject *index);
 int pyobject_as_int_index(PyObject *index);
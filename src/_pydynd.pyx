@@ -34,6 +34,7 @@ init_w_array_typeobject(w_array)
 init_w_type_typeobject(w_type)
 init_w_array_callable_typeobject(w_array_callable)
 init_w_ndt_type_callable_typeobject(w_type_callable)
+init_w_lazy_string_sequence_typeobject(w_lazy_string_sequence)
 
 include "dynd.pxd"
 include "ndt_type.pxd"
@@ -42,6 +43,8 @@ include "elwise_gfunc.pxd"
 include "elwise_reduce_gfunc.pxd"
 include "vm_elwise_program.pxd"
 include "gfunc_callable.pxd"
+include "parallel_for.pxd"
+include "array_hash_index.pxd"
 
 # Issue a performance warning if any of the diagnostics macros are enabled
 cdef extern from "<dynd/diagnostics.hpp>" namespace "dynd":
@@ -899,6 +902,48 @@ def factor_categorical(values):
     SET(result.v, dynd_factor_categorical_type(GET(w_array(values).v)))
     return result
 
+def numpy_type_cache_info():
+    """
+    ndt.numpy_type_cache_info()
+
+    Returns a dict with statistics of the caches of conversions
+    between NumPy dtypes and dynd types, which are used by
+    ``nd.array``, ``nd.view`` and ``nd.as_numpy``. The
+    'from_numpy' and 'to_numpy' entries each contain the
+    'hits', 'misses' and 'size' of one direction's cache.
+    """
+    return dynd_numpy_type_cache_info()
+
+def clear_numpy_type_cache():
+    """
+    ndt.clear_numpy_type_cache()
+
+    Empties the caches of conversions between NumPy dtypes and
+    dynd types, and resets their hit and miss counters.
+    """
+    dynd_clear_numpy_type_cache()
+
+def pep3118_format_cache_info():
+    """
+    ndt.pep3118_format_cache_info()
+
+    Returns a dict with statistics of the cache of PEP 3118
+    format strings of dynd types, which is used when a dynd
+    array provides a buffer to ``memoryview``, NumPy or
+    Cython. It contains the 'hits', 'misses', 'size' and
+    'capacity' of the cache.
+    """
+    return dynd_pep3118_format_cache_info()
+
+def clear_pep3118_format_cache():
+    """
+    ndt.clear_pep3118_format_cache()
+
+    Empties the cache of PEP 3118 format strings, and resets
+    its hit and miss counters.
+    """
+    dynd_clear_pep3118_format_cache()
+
 ##############################################################################
 
 # NOTE: This is a possible alternative to the init_w_array_typeobject() call
@@ -967,6 +1012,9 @@ cdef class w_array:
     # SET(self.v, <array value>), which sets the embeded
     # array's value.
     cdef array_placement_wrapper v
+    # A hash index built on demand by __contains__, see
+    # array_hash_index.hpp
+    cdef array_hash_index *index
 
     def __cinit__(self, value=None, dtype=None, type=None, access=None):
         placement_new(self.v)
@@ -986,6 +1034,8 @@ cdef class w_array:
                             'be provided when another keyword parameter is used')
 
     def __dealloc__(self):
+        if self.index != NULL:
+            delete_array_hash_index(self.index)
         placement_delete(self.v)
 
     def __dir__(self):
@@ -1003,16 +1053,22 @@ cdef class w_array:
         set_array_dynamic_property(GET(self.v), name, value)
 
     def __contains__(self, x):
-        return array_contains(GET(self.v), x)
+        return warray_contains(self, x)
 
-    def eval(self):
+    def eval(self, threads=None):
         """
-        a.eval()
+        a.eval(threads=None)
 
         Returns a version of the dynd array with plain values,
         all expressions evaluated. This returns the original
         array back if it has no expression type.
 
+        Parameters
+        ----------
+        threads : int, optional
+            The number of threads to use for evaluating large
+            arrays. The default is the value of ``nd.get_num_threads()``.
+
         Examples
         --------
         >>> from dynd import nd, ndt
@@ -1027,7 +1083,7 @@ cdef class w_array:
         nd.array([1, 2, 3], strided_dim<int16>)
         """
         cdef w_array result = w_array()
-        SET(result.v, array_eval(GET(self.v)))
+        SET(result.v, array_eval(GET(self.v), 0 if threads is None else threads))
         return result
 
     def eval_immutable(self):
@@ -1238,6 +1294,39 @@ cdef class w_array:
     def __setitem__(self, x, y):
         array_setitem(GET(self.v), x, y)
 
+    def item(self, *args):
+        """
+        a.item(*args)
+
+        Returns one element of the array as a Python object. With
+        integer arguments, one for each leading dimension indexed,
+        this avoids creating the intermediate nd.array of ``a[i, j]``.
+        With no arguments, the array must have exactly one element.
+
+        Examples
+        --------
+        >>> from dynd import nd, ndt
+
+        >>> a = nd.array([[1, 2], [3, 4]])
+        >>> a.item(1, 0)
+        3
+        >>> a.item(-1)
+        [3, 4]
+        """
+        return array_item(GET(self.v), args)
+
+    def itemset(self, *args):
+        """
+        a.itemset(*args, value)
+
+        Assigns ``value`` to one element of the array. This is
+        the same as ``a[args] = value``, with the last argument
+        as the value.
+        """
+        if len(args) < 2:
+            raise TypeError('itemset requires indices followed by a value')
+        array_setitem(GET(self.v), args[:-1] if len(args) > 2 else args[0], args[-1])
+
     def __getbuffer__(w_array self, Py_buffer* buffer, int flags):
         # Docstring triggered Cython bug (fixed in master), so it's commented out
         #"""PEP 3118 buffer protocol"""
@@ -1268,6 +1357,76 @@ cdef class w_array:
         SET(result.v, array_divide(GET(w_array(lhs).v), GET(w_array(rhs).v)))
         return result
 
+cdef class w_array_builder:
+    """
+    nd.array_builder(dtype=None)
+
+    Builds a one-dimensional dynd array from a stream of values,
+    without knowing the number of values up front. Values are added
+    with ``append`` and ``extend``, and ``finish`` returns the array.
+
+    The values are stored in chunks which grow geometrically, and are
+    copied into the result only once, by ``finish``. If no dtype is
+    provided, it is deduced from the values, which must be scalars,
+    and promoted as needed when a value doesn't fit it.
+
+    Parameters
+    ----------
+    dtype : dynd type, optional
+        The type of each element.
+
+    Examples
+    --------
+    >>> from dynd import nd, ndt
+
+    >>> b = nd.array_builder()
+    >>> b.extend(x * x for x in range(5))
+    >>> b.append(2.5)
+    >>> b.finish()
+    nd.array([0, 1, 4, 9, 16, 2.5], strided_dim<float64>)
+    """
+    cdef array_builder *v
+
+    def __cinit__(self, dtype=None):
+        self.v = make_array_builder(dtype)
+    def __dealloc__(self):
+        delete_array_builder(self.v)
+
+    def append(self, value):
+        """
+        b.append(value)
+
+        Appends one value to the array being built.
+        """
+        array_builder_append(self.v, value)
+
+    def extend(self, iterable):
+        """
+        b.extend(iterable)
+
+        Appends all the values from an iterable, which
+        may be a one-pass iterator or generator.
+        """
+        array_builder_extend(self.v, iterable)
+
+    def finish(self):
+        """
+        b.finish()
+
+        Returns the built array as an immutable nd.array, and
+        resets the builder to empty.
+        """
+        cdef w_array result = w_array()
+        SET(result.v, array_builder_finish(self.v))
+        return result
+
+    def __len__(self):
+        return array_builder_size(self.v)
+
+    property dtype:
+        def __get__(self):
+            return array_builder_get_dtype(self.v)
+
 def view(obj, access=None):
     """
     nd.view(obj, access=None)
@@ -1407,9 +1566,9 @@ def is_f_contiguous(w_array a):
     """
     return array_is_f_contiguous(GET(a.v))
 
-def as_py(w_array n):
+def as_py(w_array n, strings=None):
     """
-    nd.as_py(n)
+    nd.as_py(n, strings=None)
 
     Evaluates the dynd array, converting it into native Python types.
 
@@ -1421,6 +1580,10 @@ def as_py(w_array n):
     ----------
     n : dynd array
         The dynd array to convert into native Python types.
+    strings : None or 'lazy', optional
+        If 'lazy', an array of strings converts into a read-only
+        sequence which views the dynd array's memory, and decodes
+        each string only when it is accessed.
 
     Examples
     --------
@@ -1432,7 +1595,12 @@ def as_py(w_array n):
     >>> nd.as_py(a)
     [1.0, 2.0, 3.0, 4.0]
     """
-    return array_as_py(GET(n.v))
+    if strings is None:
+        return array_as_py(GET(n.v), False)
+    elif strings == 'lazy':
+        return array_as_py(GET(n.v), True)
+    else:
+        raise ValueError('invalid value for strings parameter: %r' % strings)
 
 def as_numpy(w_array n, allow_copy=False):
     """
@@ -1464,6 +1632,33 @@ def as_numpy(w_array n, allow_copy=False):
     # TODO: Could also convert dynd types into numpy dtypes
     return array_as_numpy(n, bool(allow_copy))
 
+def as_string_buffers(w_array n):
+    """
+    nd.as_string_buffers(n)
+
+    Exports a one-dimensional array of strings or bytes as
+    a tuple of two arrays ``(offsets, data)``. String ``i`` is
+    the encoded bytes ``data[offsets[i]:offsets[i+1]]``. Both
+    arrays support the buffer protocol, so consumers can read
+    the strings without converting each one to Python.
+
+    Parameters
+    ----------
+    n : dynd array
+        A one-dimensional array of strings or bytes.
+
+    Examples
+    --------
+    >>> from dynd import nd, ndt
+
+    >>> offsets, data = nd.as_string_buffers(nd.array(['abc', 'de']))
+    >>> nd.as_py(offsets)
+    [0, 3, 5]
+    >>> bytes(memoryview(data))
+    b'abcde'
+    """
+    return array_as_string_buffers(GET(n.v))
+
 def zeros(*args, **kwargs):
     """
     nd.zeros(type, *, access=None)
@@ -1889,6 +2084,97 @@ def fields(w_array struct_array, *fields_list):
     SET(result.v, nd_fields(GET(struct_array.v), fields_list))
     return result
 
+cdef class w_array_index:
+    """
+    A hash index of the values in a one-dimensional dynd array,
+    created by nd.build_index. Supports ``x in index``, ``len(index)``
+    and ``index.isin(a)``.
+    """
+    cdef array_hash_index *index
+
+    def __dealloc__(self):
+        delete_array_hash_index(self.index)
+
+    def __contains__(self, x):
+        return array_hash_index_contains(self.index, x)
+
+    def __len__(self):
+        return array_hash_index_size(self.index)
+
+    def isin(self, w_array a):
+        """
+        index.isin(a)
+
+        Returns a boolean array with the shape of ``a``, which is
+        true where the element of ``a`` is in the index.
+        """
+        cdef w_array result = w_array()
+        SET(result.v, array_hash_index_isin(self.index, GET(a.v)))
+        return result
+
+def build_index(w_array a):
+    """
+    nd.build_index(a)
+
+    Builds a hash index of the values in the one-dimensional
+    array ``a``, for fast repeated ``x in index`` lookups. The
+    index holds a copy of the values, so it does not see later
+    changes to ``a``.
+
+    Immutable arrays build and cache such an index automatically
+    the first time ``x in a`` is used, so this is mainly useful
+    for mutable arrays, or for passing to nd.isin.
+
+    Parameters
+    ----------
+    a : one-dimensional dynd array
+        An array of integers (except uint64), strings, or dates.
+
+    Examples
+    --------
+    >>> from dynd import nd, ndt
+
+    >>> idx = nd.build_index(nd.array([3, 1, 4, 1, 5]))
+    >>> 4 in idx
+    True
+    >>> len(idx)
+    4
+    """
+    cdef w_array_index result = w_array_index()
+    result.index = build_array_hash_index(GET(a.v))
+    return result
+
+def isin(w_array a, values):
+    """
+    nd.isin(a, values)
+
+    Returns a boolean array with the shape of ``a``, which is
+    true where the element of ``a`` is one of ``values``. The
+    lookup uses a hash of ``values``, so this takes time linear
+    in the sizes of both inputs.
+
+    Parameters
+    ----------
+    a : dynd array
+        An array with strided or fixed dimensions.
+    values : nd.build_index result, or one-dimensional array-like
+        The values to look for. If it is an index returned by
+        nd.build_index, it is reused instead of built again.
+
+    Examples
+    --------
+    >>> from dynd import nd, ndt
+
+    >>> nd.isin(nd.array([1, 2, 3, 4]), [2, 4, 6])
+    nd.array([false, true, false, true], strided_dim<bool>)
+    """
+    cdef w_array result = w_array()
+    if isinstance(values, w_array_index):
+        SET(result.v, array_hash_index_isin((<w_array_index>values).index, GET(a.v)))
+    else:
+        SET(result.v, array_isin(GET(a.v), values))
+    return result
+
 def parse_json(type, json):
     """
     nd.parse_json(type, json)
@@ -1946,9 +2232,11 @@ def format_json(w_array n):
     SET(result.v, dynd_format_json(GET(n.v)))
     return result
 
-def elwise_map(n, callable, dst_type, src_type = None):
+def elwise_map(n, callable, dst_type, src_type = None, block_size = None,
+                numpy = False):
     """
-    nd.elwise_map(n, callable, dst_type, src_type=None)
+    nd.elwise_map(n, callable, dst_type, src_type=None, block_size=None,
+                  numpy=False)
 
     Applies a deferred element-wise mapping function to
     a dynd array 'n'.
@@ -1971,8 +2259,47 @@ def elwise_map(n, callable, dst_type, src_type = None):
         A list of types of the source. If a source array has
         a different type than the one corresponding in this list,
         it will be converted.
+    block_size : int, optional
+        If provided, the elements are gathered into contiguous
+        buffers, and 'callable' is called once for every block of
+        this many elements, instead of once for every innermost
+        strided run. Only used when all the dimensions are
+        strided, and the types are plain old data, otherwise
+        this falls back to the unbuffered evaluation.
+    numpy : bool, optional
+        If True, 'callable' is given one-dimensional NumPy arrays
+        which view the data of 'dst' and 'src' directly, so it can
+        be written with vectorized NumPy expressions. The types
+        must be convertible to NumPy dtypes.
+    """
+    return dynd_elwise_map(n, callable, dst_type, src_type,
+                    0 if block_size is None else block_size, numpy)
+
+def set_num_threads(int num_threads):
+    """
+    nd.set_num_threads(num_threads)
+
+    Sets the number of threads dynd uses for the operations
+    which support parallel execution, such as evaluating large
+    expression arrays with ``a.eval()``, or converting large
+    lists of floats with ``nd.array``. The default is 1.
+
+    Parameters
+    ----------
+    num_threads : int
+        The number of threads to use, or 0 to use the number
+        of hardware threads.
+    """
+    dynd_set_num_threads(num_threads)
+
+def get_num_threads():
     """
-    return dynd_elwise_map(n, callable, dst_type, src_type)
+    nd.get_num_threads()
+
+    Returns the number of threads dynd uses for the operations
+    which support parallel execution.
+    """
+    return dynd_get_num_threads()
 
 class DebugReprObj(object):
     def __init__(self, repr_str):
@@ -2002,9 +2329,15 @@ def debug_repr(obj):
         return DebugReprObj(str(<char *>array_debug_print(GET((<w_array>obj).v)).c_str()))
 
 cdef class w_elwise_gfunc:
+    """
+    An elementwise function with a kernel for each of its
+    signatures. Calling it chooses a kernel from the types of
+    the arguments, converting them if there's no exact match,
+    and broadcasts the arguments together.
+    """
     cdef elwise_gfunc_placement_wrapper v
 
-    def __cinit__(self, bytes name):
+    def __cinit__(self, str name):
         placement_new(self.v, name)
     def __dealloc__(self):
         placement_delete(self.v)
@@ -2013,13 +2346,43 @@ cdef class w_elwise_gfunc:
         def __get__(self):
             return str(<char *>GET(self.v).get_name().c_str())
 
-#    def add_kernel(self, kernel, w_codegen_cache cgcache = default_cgcache_c):
-#        """Adds a kernel to the gfunc object. Currently, this means a ctypes object with prototype."""
-#        elwise_gfunc_add_kernel(GET(self.v), GET(cgcache.v), kernel)
+    def add_kernel(self, kernel):
+        """
+        gf.add_kernel(kernel)
 
-    #def debug_repr(self):
-    #    """Prints a raw representation of the gfunc data."""
-    #    return str(<char *>elwise_gfunc_debug_print(GET(self.v)).c_str())
+        Adds a kernel to the gfunc. Kernels added earlier are
+        preferred when several of them match the arguments.
+
+        Parameters
+        ----------
+        kernel : nd.array of ckernel_deferred type
+            A scalar ckernel_deferred, for example from
+            ``_lowlevel.ckernel_deferred_from_ufunc``.
+        """
+        elwise_gfunc_add_kernel(GET(self.v), kernel)
+
+    def debug_repr(self):
+        """Returns a raw representation of the gfunc data."""
+        return str(<char *>elwise_gfunc_debug_print(GET(self.v)).c_str())
+
+    def dispatch_cache_info(self):
+        """
+        gf.dispatch_cache_info()
+
+        Returns a dict with the number of calls which found their
+        argument types in the gfunc's dispatch cache ('hits') and
+        which had to resolve a kernel ('misses'), along with the
+        cache's 'size' and 'capacity'.
+        """
+        return elwise_gfunc_dispatch_cache_info(GET(self.v))
+
+    def clear_dispatch_cache(self):
+        """
+        gf.clear_dispatch_cache()
+
+        Empties the gfunc's dispatch cache, and resets its counters.
+        """
+        elwise_gfunc_clear_dispatch_cache(GET(self.v))
 
     def __call__(self, *args, **kwargs):
         """Calls the gfunc."""
@@ -2088,6 +2451,30 @@ cdef class w_elwise_program:
     #    """Returns a raw representation of the elwise_program data."""
     #    return str(<char *>vm_elwise_program_debug_print(GET(self.v)).c_str())
 
+cdef class w_lazy_string_sequence:
+    """
+    A read-only sequence of strings viewing an evaluated dynd
+    array, returned by ``nd.as_py(a, strings='lazy')``. Each
+    string is decoded into a Python string when it is accessed.
+    """
+    cdef w_array arr
+    cdef intptr_t size
+
+    def __cinit__(self, w_array arr):
+        self.arr = arr
+        self.size = GET(arr.v).get_dim_size()
+
+    def __len__(self):
+        return self.size
+
+    def __getitem__(self, i):
+        if isinstance(i, slice):
+            return w_lazy_string_sequence(self.arr[i])
+        return lazy_string_sequence_getitem(GET(self.arr.v), i)
+
+    def __repr__(self):
+        return 'nd.lazy_string_sequence(%r)' % list(self)
+
 cdef class w_array_callable:
     cdef array_callable_placement_wrapper v
 
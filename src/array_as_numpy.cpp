@@ -14,10 +14,15 @@
 #include "numpy_interop.hpp"
 #include "array_functions.hpp"
 #include "utility_functions.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
 
 #include <dynd/types/strided_dim_type.hpp>
 #include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/fixedstring_type.hpp>
+#include <dynd/types/string_type.hpp>
 #include <dynd/types/base_struct_type.hpp>
 #include <dynd/types/date_type.hpp>
 #include <dynd/types/bytes_type.hpp>
@@ -287,6 +292,17 @@ static void as_numpy_analysis(pyobject_ownref *out_numpy_dtype, bool *out_requir
                 }
                 break;
             }
+            case string_type_id: {
+                // UTF-8 and ASCII strings get copied into NumPy unicode,
+                // sized to fit the longest string
+                string_encoding_t encoding = static_cast<const string_type *>(dt.extended())->get_encoding();
+                if (encoding == string_encoding_utf_8 || encoding == string_encoding_ascii) {
+                    out_numpy_dtype->clear();
+                    *out_requires_copy = true;
+                    return;
+                }
+                break;
+            }
             case date_type_id: {
 #if NPY_API_VERSION >= 6 // At least NumPy 1.6
                 out_numpy_dtype->clear();
@@ -493,6 +509,295 @@ static void as_numpy_analysis(pyobject_ownref *out_numpy_dtype, bool *out_requir
 }
 
 
+// The smallest number of elements the specialized export
+// kernels give to a thread
+static const intptr_t EXPORT_MIN_CHUNK = 1 << 16;
+
+/**
+ * Calls ``kernel(dst, dst_stride, src, src_stride, count)`` on runs
+ * along the innermost dimension which together cover every element of
+ * a strided array, splitting them across threads. Must not use the
+ * Python API, so it can run with the GIL released.
+ */
+template<class Kernel>
+static void export_elements(intptr_t ndim, const intptr_t *shape,
+                const char *src, const intptr_t *src_strides,
+                char *dst, const intptr_t *dst_strides, const Kernel& kernel)
+{
+    if (ndim == 0) {
+        kernel(dst, 0, src, 0, 1);
+        return;
+    }
+    intptr_t inner_size = shape[ndim - 1];
+    intptr_t src_inner_stride = src_strides[ndim - 1], dst_inner_stride = dst_strides[ndim - 1];
+    intptr_t outer_count = 1;
+    for (intptr_t i = 0; i < ndim - 1; ++i) {
+        outer_count *= shape[i];
+    }
+    if (inner_size == 0 || outer_count == 0) {
+        return;
+    }
+
+    if (outer_count == 1) {
+        // Split the single run into chunks
+        parallel_for(inner_size, EXPORT_MIN_CHUNK, [&](intptr_t begin, intptr_t end) {
+            kernel(dst + begin * dst_inner_stride, dst_inner_stride,
+                            src + begin * src_inner_stride, src_inner_stride, end - begin);
+        });
+    } else {
+        parallel_for(outer_count, max(EXPORT_MIN_CHUNK / inner_size, (intptr_t)1),
+                        [&](intptr_t begin, intptr_t end) {
+            for (intptr_t j = begin; j < end; ++j) {
+                // Convert the run index into offsets in the outer dimensions
+                const char *s = src;
+                char *d = dst;
+                intptr_t remainder = j;
+                for (intptr_t i = ndim - 2; i >= 0; --i) {
+                    intptr_t coord = remainder % shape[i];
+                    remainder /= shape[i];
+                    s += coord * src_strides[i];
+                    d += coord * dst_strides[i];
+                }
+                kernel(d, dst_inner_stride, s, src_inner_stride, inner_size);
+            }
+        });
+    }
+}
+
+/** Widens dynd's int32 days into NumPy's int64 M8[D] */
+struct date_export_kernel {
+    void operator()(char *dst, intptr_t dst_stride, const char *src, intptr_t src_stride,
+                    intptr_t count) const
+    {
+        if (dst_stride == sizeof(int64_t) && src_stride == sizeof(int32_t)) {
+            // Contiguous, so simple enough for the compiler to vectorize
+            int64_t *d = reinterpret_cast<int64_t *>(dst);
+            const int32_t *s = reinterpret_cast<const int32_t *>(src);
+            for (intptr_t i = 0; i < count; ++i) {
+                int32_t days = s[i];
+                d[i] = (days == DYND_DATE_NA) ? NPY_DATETIME_NAT : days;
+            }
+        } else {
+            for (intptr_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride) {
+                int32_t days = *reinterpret_cast<const int32_t *>(src);
+                *reinterpret_cast<int64_t *>(dst) = (days == DYND_DATE_NA) ? NPY_DATETIME_NAT : days;
+            }
+        }
+    }
+};
+
+/**
+ * Decodes the UTF-8 in [begin, end) into UCS4, filling exactly
+ * ``out_size`` code points of ``out`` and padding with zeros.
+ */
+static inline void utf8_to_ucs4(const char *begin, const char *end,
+                uint32_t *out, intptr_t out_size)
+{
+    const uint8_t *s = reinterpret_cast<const uint8_t *>(begin);
+    const uint8_t *s_end = reinterpret_cast<const uint8_t *>(end);
+    uint32_t *out_end = out + out_size;
+    while (s < s_end && out < out_end) {
+        // Widen ASCII eight bytes at a time
+        if (s_end - s >= 8 && out_end - out >= 8) {
+            uint64_t word;
+            memcpy(&word, s, 8);
+            if ((word & 0x8080808080808080ULL) == 0) {
+                for (int k = 0; k < 8; ++k) {
+                    out[k] = s[k];
+                }
+                s += 8;
+                out += 8;
+                continue;
+            }
+        }
+        uint32_t c = *s;
+        if (c < 0x80) {
+            *out++ = c;
+            ++s;
+            continue;
+        }
+        int trail;
+        if ((c & 0xe0) == 0xc0) {
+            c &= 0x1f;
+            trail = 1;
+        } else if ((c & 0xf0) == 0xe0) {
+            c &= 0x0f;
+            trail = 2;
+        } else if ((c & 0xf8) == 0xf0) {
+            c &= 0x07;
+            trail = 3;
+        } else {
+            throw string_decode_error(reinterpret_cast<const char *>(s),
+                            reinterpret_cast<const char *>(s + 1), string_encoding_utf_8);
+        }
+        if (s_end - s <= trail) {
+            throw string_decode_error(reinterpret_cast<const char *>(s), end, string_encoding_utf_8);
+        }
+        for (int k = 1; k <= trail; ++k) {
+            if ((s[k] & 0xc0) != 0x80) {
+                throw string_decode_error(reinterpret_cast<const char *>(s),
+                                reinterpret_cast<const char *>(s + k + 1), string_encoding_utf_8);
+            }
+            c = (c << 6) | (s[k] & 0x3f);
+        }
+        s += trail + 1;
+        *out++ = c;
+    }
+    while (out < out_end) {
+        *out++ = 0;
+    }
+}
+
+/** The number of code points in a UTF-8 string */
+static inline intptr_t utf8_length(const char *begin, const char *end)
+{
+    intptr_t length = 0;
+    for (; begin < end; ++begin) {
+        // Count everything except continuation bytes
+        length += ((*begin & 0xc0) != 0x80);
+    }
+    return length;
+}
+
+/** Transcodes UTF-8 or ASCII strings into NumPy unicode */
+struct string_export_kernel {
+    intptr_t out_size;
+
+    void operator()(char *dst, intptr_t dst_stride, const char *src, intptr_t src_stride,
+                    intptr_t count) const
+    {
+        for (intptr_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride) {
+            const string_type_data *d = reinterpret_cast<const string_type_data *>(src);
+            utf8_to_ucs4(d->begin, d->end, reinterpret_cast<uint32_t *>(dst), out_size);
+        }
+    }
+};
+
+/** Transcodes NUL-padded UTF-8 fixed strings into NumPy unicode */
+struct fixedstring_export_kernel {
+    intptr_t in_size, out_size;
+
+    void operator()(char *dst, intptr_t dst_stride, const char *src, intptr_t src_stride,
+                    intptr_t count) const
+    {
+        for (intptr_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride) {
+            const char *end = reinterpret_cast<const char *>(memchr(src, 0, in_size));
+            utf8_to_ucs4(src, end ? end : (src + in_size),
+                            reinterpret_cast<uint32_t *>(dst), out_size);
+        }
+    }
+};
+
+/** Finds the length in code points of the longest UTF-8 or ASCII string */
+struct string_length_kernel {
+    atomic<intptr_t> *max_length;
+
+    void operator()(char *DYND_UNUSED(dst), intptr_t DYND_UNUSED(dst_stride),
+                    const char *src, intptr_t src_stride, intptr_t count) const
+    {
+        intptr_t run_max = 0;
+        for (intptr_t i = 0; i < count; ++i, src += src_stride) {
+            const string_type_data *d = reinterpret_cast<const string_type_data *>(src);
+            // Each code point takes at least one byte
+            if (d->end - d->begin > run_max) {
+                run_max = max(run_max, utf8_length(d->begin, d->end));
+            }
+        }
+        intptr_t prev = max_length->load();
+        while (run_max > prev && !max_length->compare_exchange_weak(prev, run_max)) {
+        }
+    }
+};
+
+/**
+ * Returns true if the elements of 'tp' have a specialized kernel
+ * for copying into a NumPy array, instead of assigning through a
+ * dynd view of the NumPy array.
+ */
+static bool has_export_kernel(const ndt::type& tp)
+{
+    switch (tp.get_type_id()) {
+        case date_type_id:
+#if NPY_API_VERSION >= 6 // At least NumPy 1.6
+            return true;
+#else
+            return false;
+#endif
+        case string_type_id: {
+            string_encoding_t encoding = static_cast<const string_type *>(tp.extended())->get_encoding();
+            return encoding == string_encoding_utf_8 || encoding == string_encoding_ascii;
+        }
+        case fixedstring_type_id:
+            return static_cast<const fixedstring_type *>(tp.extended())->get_encoding() ==
+                            string_encoding_utf_8;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Copies the elements of 'n' into the NumPy array 'dst' with one of
+ * the specialized kernels, without needing the GIL.
+ */
+static void export_with_kernel(const nd::array& n, const intptr_t *src_strides, PyArrayObject *dst)
+{
+    const ndt::type& tp = n.get_dtype();
+    intptr_t ndim = n.get_ndim();
+    dimvector shape(ndim);
+    n.get_shape(shape.get());
+    const char *src = n.get_readonly_originptr();
+    char *dst_data = reinterpret_cast<char *>(PyArray_DATA(dst));
+    const intptr_t *dst_strides = PyArray_STRIDES(dst);
+    intptr_t out_size = PyArray_DESCR(dst)->elsize / 4;
+    switch (tp.get_type_id()) {
+        case date_type_id:
+            export_elements(ndim, shape.get(), src, src_strides, dst_data, dst_strides,
+                            date_export_kernel());
+            break;
+        case string_type_id: {
+            string_export_kernel kernel;
+            kernel.out_size = out_size;
+            export_elements(ndim, shape.get(), src, src_strides, dst_data, dst_strides, kernel);
+            break;
+        }
+        case fixedstring_type_id: {
+            fixedstring_export_kernel kernel;
+            kernel.in_size = tp.get_data_size();
+            kernel.out_size = out_size;
+            export_elements(ndim, shape.get(), src, src_strides, dst_data, dst_strides, kernel);
+            break;
+        }
+        default:
+            throw runtime_error("internal error: no as_numpy export kernel for dynd type");
+    }
+}
+
+/**
+ * Makes the NumPy unicode dtype which fits every string of 'n', an
+ * array of UTF-8 or ASCII strings.
+ */
+static PyArray_Descr *make_numpy_unicode_dtype_for_copy(const nd::array& n, const intptr_t *src_strides)
+{
+    intptr_t ndim = n.get_ndim();
+    dimvector shape(ndim), no_strides(ndim);
+    n.get_shape(shape.get());
+    for (intptr_t i = 0; i < ndim; ++i) {
+        no_strides[i] = 0;
+    }
+    atomic<intptr_t> max_length(0);
+    string_length_kernel kernel;
+    kernel.max_length = &max_length;
+    {
+        PyAllowThreads_RAII nogil;
+        export_elements(ndim, shape.get(), n.get_readonly_originptr(), src_strides,
+                        NULL, no_strides.get(), kernel);
+    }
+    PyArray_Descr *result = PyArray_DescrNewFromType(NPY_UNICODE);
+    // NumPy doesn't allow zero-sized unicode
+    result->elsize = (int)(4 * max(max_length.load(), (intptr_t)1));
+    return result;
+}
+
 PyObject *pydynd::array_as_numpy(PyObject *n_obj, bool allow_copy)
 {
     if (!WArray_Check(n_obj)) {
@@ -653,8 +958,19 @@ PyObject *pydynd::array_as_numpy(PyObject *n_obj, bool allow_copy)
             ss << " as numpy without making a copy";
             throw dynd::type_error(ss.str());
         }
-        make_numpy_dtype_for_copy(&numpy_dtype,
-                        ndim, n.get_type(), n.get_ndo_meta());
+        // The strides get rebuilt for the copy, but the
+        // specialized kernels need the originals
+        dimvector src_strides(ndim);
+        memcpy(src_strides.get(), strides.get(), ndim * sizeof(intptr_t));
+        bool use_export_kernel = has_export_kernel(n.get_dtype());
+
+        if (n.get_dtype().get_type_id() == string_type_id && use_export_kernel) {
+            // The size of the NumPy unicode dtype depends on the data
+            numpy_dtype.reset((PyObject *)make_numpy_unicode_dtype_for_copy(n, src_strides.get()));
+        } else {
+            make_numpy_dtype_for_copy(&numpy_dtype,
+                            ndim, n.get_type(), n.get_ndo_meta());
+        }
 
         // Rebuild the strides so that the copy follows 'KEEPORDER'
         intptr_t element_size = ((PyArray_Descr *)numpy_dtype.get())->elsize;
@@ -671,10 +987,16 @@ PyObject *pydynd::array_as_numpy(PyObject *n_obj, bool allow_copy)
         // Create a new NumPy array, and copy from the dynd array
         pyobject_ownref result(PyArray_NewFromDescr(&PyArray_Type, (PyArray_Descr *)numpy_dtype.release(),
                         (int)ndim, shape.get(), strides.get(), NULL, 0, NULL));
-        // Create a dynd array view of this result
-        nd::array result_dynd = array_from_numpy_array((PyArrayObject *)result.get(), 0, false);
-        // Copy the values using this view
-        result_dynd.vals() = n;
+        if (use_export_kernel) {
+            PyAllowThreads_RAII nogil;
+            export_with_kernel(n, src_strides.get(), (PyArrayObject *)result.get());
+        } else {
+            // Create a dynd array view of this result
+            nd::array result_dynd = array_from_numpy_array((PyArrayObject *)result.get(), 0, false);
+            // Copy the values using this view
+            PyAllowThreads_RAII nogil;
+            result_dynd.vals() = n;
+        }
         // Return the NumPy array
         return result.release();
     } else {
@@ -5,8 +5,15 @@
 
 #include <Python.h>
 
+#include <vector>
+#include <list>
+#include <map>
+
 #include <dynd/types/strided_dim_type.hpp>
 #include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/bytes_type.hpp>
 #include <dynd/types/cstruct_type.hpp>
 #include <dynd/types/fixedstring_type.hpp>
 #include <dynd/types/byteswap_type.hpp>
@@ -221,6 +228,186 @@ std::string pydynd::make_pep3118_format(intptr_t& out_itemsize, const ndt::type&
     return result.str();
 }
 
+// The number of types whose format strings are cached
+#define DYND_PEP3118_FORMAT_CACHE_CAPACITY 256
+
+namespace {
+    /**
+     * A bounded LRU cache of the PEP 3118 format strings of dynd
+     * types, keyed on the identity of the type. Each entry holds a
+     * reference to its type, so the address can't be reused. The
+     * metadata doesn't need to be part of the key, because the only
+     * layout the formats describe, cstruct field offsets, is part
+     * of the type.
+     *
+     * The buffer protocol is always used with the GIL held, which
+     * serializes access to the cache.
+     */
+    class pep3118_format_cache {
+    public:
+        struct entry {
+            ndt::type tp;
+            string format;
+            intptr_t itemsize;
+        };
+
+    private:
+        typedef list<entry> list_type;
+        typedef map<const base_type *, list_type::iterator> map_type;
+
+        list_type m_entries;
+        map_type m_index;
+        size_t m_capacity;
+        size_t m_hits, m_misses;
+
+        // Non-copyable
+        pep3118_format_cache(const pep3118_format_cache&);
+        pep3118_format_cache& operator=(const pep3118_format_cache&);
+    public:
+        explicit pep3118_format_cache(size_t capacity)
+            : m_capacity(capacity), m_hits(0), m_misses(0)
+        {
+        }
+
+        /**
+         * Returns the format of 'tp', computing and caching it on a miss.
+         * The entry stays valid until the next call.
+         */
+        const entry& get(const ndt::type& tp, const char *metadata)
+        {
+            map_type::iterator it = m_index.find(tp.extended());
+            if (it != m_index.end()) {
+                ++m_hits;
+                // Move the entry to the front as the most recently used
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return *it->second;
+            }
+            ++m_misses;
+            entry e;
+            e.tp = tp;
+            e.format = make_pep3118_format(e.itemsize, tp, metadata);
+            m_entries.push_front(e);
+            m_index[tp.extended()] = m_entries.begin();
+            while (m_entries.size() > m_capacity) {
+                m_index.erase(m_entries.back().tp.extended());
+                m_entries.pop_back();
+            }
+            return m_entries.front();
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_index.clear();
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+        void get_stats(size_t& out_hits, size_t& out_misses, size_t& out_size) const
+        {
+            out_hits = m_hits;
+            out_misses = m_misses;
+            out_size = m_entries.size();
+        }
+
+        size_t get_capacity() const {
+            return m_capacity;
+        }
+    };
+
+    /**
+     * The header of the memory in Py_buffer::internal, which holds the
+     * shape, strides, suboffsets and format. Blocks big enough for
+     * buffers of up to 8 dimensions with a format up to 128 bytes
+     * are kept on a free list when released, so that getting and
+     * releasing a buffer doesn't go to malloc. Like the format cache,
+     * the free list relies on the GIL.
+     */
+    struct buffer_internal_header {
+        buffer_internal_header *next_free;
+        bool pooled;
+    };
+
+    const size_t pooled_internal_size = 3 * 8 * sizeof(Py_ssize_t) + 128;
+    const size_t pooled_internal_max_free = 64;
+
+    buffer_internal_header *free_internals = NULL;
+    size_t free_internals_count = 0;
+} // anonymous namespace
+
+static pep3118_format_cache format_cache(DYND_PEP3118_FORMAT_CACHE_CAPACITY);
+
+/**
+ * Allocates 'size' bytes for the Py_buffer internals, setting
+ * buffer->internal and returning a pointer to the memory.
+ */
+static char *allocate_buffer_internal(Py_buffer *buffer, size_t size)
+{
+    buffer_internal_header *header;
+    if (size <= pooled_internal_size) {
+        if (free_internals != NULL) {
+            header = free_internals;
+            free_internals = header->next_free;
+            --free_internals_count;
+        } else {
+            header = reinterpret_cast<buffer_internal_header *>(
+                            malloc(sizeof(buffer_internal_header) + pooled_internal_size));
+        }
+    } else {
+        header = reinterpret_cast<buffer_internal_header *>(
+                        malloc(sizeof(buffer_internal_header) + size));
+    }
+    if (header == NULL) {
+        throw bad_alloc();
+    }
+    header->next_free = NULL;
+    header->pooled = (size <= pooled_internal_size);
+    buffer->internal = header;
+    return reinterpret_cast<char *>(header + 1);
+}
+
+static void free_buffer_internal(void *internal)
+{
+    buffer_internal_header *header = reinterpret_cast<buffer_internal_header *>(internal);
+    if (header->pooled && free_internals_count < pooled_internal_max_free) {
+        header->next_free = free_internals;
+        free_internals = header;
+        ++free_internals_count;
+    } else {
+        free(header);
+    }
+}
+
+PyObject *pydynd::pep3118_format_cache_info()
+{
+    size_t hits, misses, size;
+    format_cache.get_stats(hits, misses, size);
+    return Py_BuildValue("{s:n,s:n,s:n,s:n}",
+                    "hits", (Py_ssize_t)hits, "misses", (Py_ssize_t)misses,
+                    "size", (Py_ssize_t)size, "capacity", (Py_ssize_t)format_cache.get_capacity());
+}
+
+void pydynd::clear_pep3118_format_cache()
+{
+    format_cache.clear();
+}
+
+/**
+ * Replaces each element pointer with pointers to all the
+ * elements of its next dimension.
+ */
+static void expand_element_pointers(vector<char *>& elements, intptr_t dim_size, intptr_t stride)
+{
+    vector<char *> expanded;
+    expanded.reserve(elements.size() * dim_size);
+    for (size_t i = 0; i < elements.size(); ++i) {
+        for (intptr_t j = 0; j < dim_size; ++j) {
+            expanded.push_back(elements[i] + j * stride);
+        }
+    }
+    elements.swap(expanded);
+}
+
 static void array_getbuffer_pep3118_bytes(const ndt::type& dt, const char *metadata,
                 char *data, Py_buffer *buffer, int flags)
 {
@@ -236,8 +423,7 @@ static void array_getbuffer_pep3118_bytes(const ndt::type& dt, const char *metad
     buffer->shape = &buffer->smalltable[0];
     buffer->strides = &buffer->smalltable[1];
 #else
-    buffer->internal = malloc(2*sizeof(intptr_t));
-    buffer->shape = reinterpret_cast<Py_ssize_t *>(buffer->internal);
+    buffer->shape = reinterpret_cast<Py_ssize_t *>(allocate_buffer_internal(buffer, 2*sizeof(Py_ssize_t)));
     buffer->strides = buffer->shape + 1;
 #endif
     buffer->strides[0] = 1;
@@ -291,41 +477,63 @@ int pydynd::array_getbuffer_pep3118(PyObject *ndo, Py_buffer *buffer, int flags)
             throw dynd::type_error(ss.str());
         }
 
+        // Var dims can only be represented with PIL-style suboffsets
+        int var_dim_count = 0;
+        for (int i = 0; i < buffer->ndim; ++i) {
+            if (dt.get_type_at_dimension(NULL, i).get_type_id() == var_dim_type_id) {
+                ++var_dim_count;
+            }
+        }
+
         // Create the format, and allocate the dynamic memory but Py_buffer needs
         char *uniform_metadata = n.get_ndo_meta();
         ndt::type uniform_tp = dt.get_type_at_dimension(&uniform_metadata, buffer->ndim);
+        const string *format = NULL;
         if ((flags&PyBUF_FORMAT) || uniform_tp.get_data_size() == 0) {
-            // If the array data type doesn't have a fixed size, make_pep3118 fills buffer->itemsize as a side effect
-            string format = make_pep3118_format(buffer->itemsize, uniform_tp, uniform_metadata);
-            if (flags&PyBUF_FORMAT) {
-                buffer->internal = malloc(2*buffer->ndim*sizeof(intptr_t) + format.size() + 1);
-                buffer->shape = reinterpret_cast<Py_ssize_t *>(buffer->internal);
-                buffer->strides = buffer->shape + buffer->ndim;
-                buffer->format = reinterpret_cast<char *>(buffer->strides + buffer->ndim);
-                memcpy(buffer->format, format.c_str(), format.size() + 1);
-            } else {
-                buffer->format = NULL;
-                buffer->internal = malloc(2*buffer->ndim*sizeof(intptr_t));
-                buffer->shape = reinterpret_cast<Py_ssize_t *>(buffer->internal);
-                buffer->strides = buffer->shape + buffer->ndim;
-            }
+            // If the array data type doesn't have a fixed size, the format provides the itemsize
+            const pep3118_format_cache::entry& e = format_cache.get(uniform_tp, uniform_metadata);
+            format = &e.format;
+            buffer->itemsize = e.itemsize;
         } else {
-            buffer->format = NULL;
             buffer->itemsize = uniform_tp.get_data_size();
-            buffer->internal = malloc(2*buffer->ndim*sizeof(intptr_t));
-            buffer->shape = reinterpret_cast<Py_ssize_t *>(buffer->internal);
-            buffer->strides = buffer->shape + buffer->ndim;
+        }
+        // The shape, strides, suboffsets if needed, and format share one allocation
+        int shape_arrays = (var_dim_count > 0) ? 3 : 2;
+        size_t format_size = (flags&PyBUF_FORMAT) ? (format->size() + 1) : 0;
+        buffer->shape = reinterpret_cast<Py_ssize_t *>(allocate_buffer_internal(buffer,
+                        shape_arrays*buffer->ndim*sizeof(Py_ssize_t) + format_size));
+        buffer->strides = buffer->shape + buffer->ndim;
+        if (var_dim_count > 0) {
+            buffer->suboffsets = buffer->strides + buffer->ndim;
+        }
+        if (flags&PyBUF_FORMAT) {
+            buffer->format = reinterpret_cast<char *>(buffer->shape + shape_arrays*buffer->ndim);
+            memcpy(buffer->format, format->c_str(), format_size);
+        } else {
+            buffer->format = NULL;
         }
 
-        // Fill in the shape and strides
+        // Fill in the shape and strides. While var dims remain, the pointers
+        // to all the elements of the current dimension are tracked, to check
+        // that the var dims have a uniform size and follow their data pointers.
         const char *metadata = n.get_ndo_meta();
+        vector<char *> elements;
+        if (var_dim_count > 0) {
+            elements.push_back(preamble->m_data_pointer);
+        }
         for (int i = 0; i < buffer->ndim; ++i) {
+            if (buffer->suboffsets != NULL) {
+                buffer->suboffsets[i] = -1;
+            }
             switch (dt.get_type_id()) {
                 case strided_dim_type_id: {
                     const strided_dim_type *tdt = static_cast<const strided_dim_type *>(dt.extended());
                     const strided_dim_type_metadata *md = reinterpret_cast<const strided_dim_type_metadata *>(metadata);
                     buffer->shape[i] = md->size;
                     buffer->strides[i] = md->stride;
+                    if (var_dim_count > 0) {
+                        expand_element_pointers(elements, md->size, md->stride);
+                    }
                     metadata += sizeof(strided_dim_type_metadata);
                     dt = tdt->get_element_type();
                     break;
@@ -334,6 +542,45 @@ int pydynd::array_getbuffer_pep3118(PyObject *ndo, Py_buffer *buffer, int flags)
                     const fixed_dim_type *tdt = static_cast<const fixed_dim_type *>(dt.extended());
                     buffer->shape[i] = tdt->get_fixed_dim_size();
                     buffer->strides[i] = tdt->get_fixed_stride();
+                    if (var_dim_count > 0) {
+                        expand_element_pointers(elements, buffer->shape[i], buffer->strides[i]);
+                    }
+                    dt = tdt->get_element_type();
+                    break;
+                }
+                case var_dim_type_id: {
+                    const var_dim_type *tdt = static_cast<const var_dim_type *>(dt.extended());
+                    const var_dim_type_metadata *md = reinterpret_cast<const var_dim_type_metadata *>(metadata);
+                    intptr_t dim_size = elements.empty() ? 0 :
+                                    (intptr_t)reinterpret_cast<const var_dim_type_data *>(elements[0])->size;
+                    for (size_t j = 1; j < elements.size(); ++j) {
+                        if ((intptr_t)reinterpret_cast<const var_dim_type_data *>(elements[j])->size != dim_size) {
+                            stringstream ss;
+                            ss << "dynd array of type " << n.get_type() << " has a ragged var dimension,";
+                            ss << " which a PEP 3118 buffer cannot represent";
+                            throw runtime_error(ss.str());
+                        }
+                    }
+                    buffer->shape[i] = dim_size;
+                    buffer->strides[i] = md->stride;
+                    if (i == 0) {
+                        // The outermost dimension is a single var_dim_type_data,
+                        // whose pointer can be followed right away
+                        buffer->buf = reinterpret_cast<const var_dim_type_data *>(elements[0])->begin + md->offset;
+                    } else {
+                        // Consumers follow the pointer at the start of
+                        // each element of the previous dimension
+                        buffer->suboffsets[i - 1] = md->offset;
+                    }
+                    for (size_t j = 0; j < elements.size(); ++j) {
+                        elements[j] = reinterpret_cast<const var_dim_type_data *>(elements[j])->begin + md->offset;
+                    }
+                    if (--var_dim_count > 0) {
+                        expand_element_pointers(elements, dim_size, md->stride);
+                    } else {
+                        elements.clear();
+                    }
+                    metadata += sizeof(var_dim_type_metadata);
                     dt = tdt->get_element_type();
                     break;
                 }
@@ -345,14 +592,38 @@ int pydynd::array_getbuffer_pep3118(PyObject *ndo, Py_buffer *buffer, int flags)
             }
         }
 
+        bool has_suboffsets = false;
+        if (buffer->suboffsets != NULL) {
+            for (int i = 0; i < buffer->ndim; ++i) {
+                if (buffer->suboffsets[i] >= 0) {
+                    has_suboffsets = true;
+                    break;
+                }
+            }
+            if (!has_suboffsets) {
+                buffer->suboffsets = NULL;
+            }
+        }
+        if (has_suboffsets && (flags&PyBUF_INDIRECT) != PyBUF_INDIRECT) {
+            stringstream ss;
+            ss << "dynd type " << n.get_type() << " requires suboffsets, but PEP 3118 request is not INDIRECT";
+            throw dynd::type_error(ss.str());
+        }
+
         // Get the total length of the buffer in bytes
         buffer->len = buffer->itemsize;
         for (int i = 0; i < buffer->ndim; ++i) {
             buffer->len *= buffer->shape[i];
         }
 
-        // Check that any contiguity requirements are satisfied
-        if ((flags&PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS || (flags&PyBUF_STRIDES) != PyBUF_STRIDES) {
+        // Check that any contiguity requirements are satisfied. Each
+        // contiguity flag includes PyBUF_STRIDES, so they're compared
+        // as a whole like CPython does
+        if (has_suboffsets && ((flags&PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS ||
+                        (flags&PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS ||
+                        (flags&PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS)) {
+            throw runtime_error("dynd array with var dimensions is not contiguous as requested for PEP 3118 buffer");
+        } else if ((flags&PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS || (flags&PyBUF_STRIDES) != PyBUF_STRIDES) {
             if (!strides_are_c_contiguous(buffer->ndim, buffer->itemsize, buffer->shape, buffer->strides)) {
                 throw runtime_error("dynd array is not C-contiguous as requested for PEP 3118 buffer");
             }
@@ -376,9 +647,10 @@ int pydynd::array_getbuffer_pep3118(PyObject *ndo, Py_buffer *buffer, int flags)
         Py_DECREF(ndo);
         buffer->obj = NULL;
         if (buffer->internal != NULL) {
-            free(buffer->internal);
+            free_buffer_internal(buffer->internal);
             buffer->internal = NULL;
         }
+        buffer->suboffsets = NULL;
         PyErr_SetString(PyExc_BufferError, e.what());
         return -1;
     }
@@ -388,7 +660,7 @@ int pydynd::array_releasebuffer_pep3118(PyObject *ndo, Py_buffer *buffer)
 {
     try {
         if (buffer->internal != NULL) {
-            free(buffer->internal);
+            free_buffer_internal(buffer->internal);
             buffer->internal = NULL;
         }
         return 0;
@@ -397,3 +669,74 @@ int pydynd::array_releasebuffer_pep3118(PyObject *ndo, Py_buffer *buffer)
         return -1;
     }
 }
+
+PyObject *pydynd::array_as_string_buffers(const nd::array& n)
+{
+    const ndt::type& tp = n.get_type();
+    if (tp.get_ndim() != 1 || (tp.get_type_id() != strided_dim_type_id &&
+                    tp.get_type_id() != fixed_dim_type_id)) {
+        stringstream ss;
+        ss << "nd.as_string_buffers requires a one-dimensional strided array, not " << tp;
+        throw dynd::type_error(ss.str());
+    }
+    const base_uniform_dim_type *budd = static_cast<const base_uniform_dim_type *>(tp.extended());
+    const ndt::type& el_tp = budd->get_element_type();
+    if (el_tp.get_type_id() != string_type_id && el_tp.get_type_id() != bytes_type_id) {
+        stringstream ss;
+        ss << "nd.as_string_buffers requires an array of strings or bytes, not " << tp;
+        throw dynd::type_error(ss.str());
+    }
+    // Strings and bytes share the same data and metadata layout
+    const string_type_metadata *el_md = reinterpret_cast<const string_type_metadata *>(
+                    n.get_ndo_meta() + budd->get_element_metadata_offset());
+    intptr_t size, stride;
+    if (tp.get_type_id() == strided_dim_type_id) {
+        const strided_dim_type_metadata *md = reinterpret_cast<const strided_dim_type_metadata *>(n.get_ndo_meta());
+        size = md->size;
+        stride = md->stride;
+    } else {
+        const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(tp.extended());
+        size = fdt->get_fixed_dim_size();
+        stride = fdt->get_fixed_stride();
+    }
+
+    // The offsets of each string, plus the end of the last one
+    nd::array offsets = nd::empty(size + 1, ndt::make_type<int64_t>());
+    int64_t *offsets_ptr = reinterpret_cast<int64_t *>(offsets.get_readwrite_originptr());
+    const char *src = n.get_readonly_originptr();
+    const string_type_data *first = reinterpret_cast<const string_type_data *>(src);
+    bool contiguous = true;
+    offsets_ptr[0] = 0;
+    for (intptr_t i = 0; i < size; ++i) {
+        const string_type_data *d = reinterpret_cast<const string_type_data *>(src + i * stride);
+        offsets_ptr[i + 1] = offsets_ptr[i] + (d->end - d->begin);
+        if (contiguous && d->begin != first->begin + offsets_ptr[i]) {
+            contiguous = false;
+        }
+    }
+    intptr_t data_size = (intptr_t)offsets_ptr[size];
+
+    nd::array data;
+    if (contiguous && size > 0) {
+        // The strings are already packed one after another, so view them
+        memory_block_ptr data_ref = (el_md->blockref != NULL) ?
+                        memory_block_ptr(el_md->blockref) : n.get_data_memblock();
+        intptr_t byte_stride = 1;
+        data = nd::make_strided_array_from_data(ndt::make_type<uint8_t>(), 1, &data_size, &byte_stride,
+                        nd::read_access_flag | (n.get_access_flags()&nd::immutable_access_flag),
+                        first->begin, DYND_MOVE(data_ref), NULL);
+    } else {
+        data = nd::empty(data_size, ndt::make_type<uint8_t>());
+        char *dst = data.get_readwrite_originptr();
+        for (intptr_t i = 0; i < size; ++i) {
+            const string_type_data *d = reinterpret_cast<const string_type_data *>(src + i * stride);
+            memcpy(dst + offsets_ptr[i], d->begin, d->end - d->begin);
+        }
+        data.flag_as_immutable();
+    }
+    offsets.flag_as_immutable();
+
+    pyobject_ownref offsets_obj(wrap_array(offsets));
+    pyobject_ownref data_obj(wrap_array(data));
+    return PyTuple_Pack(2, offsets_obj.get(), data_obj.get());
+}
@@ -12,6 +12,7 @@
 #include "utility_functions.hpp"
 
 #include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/types/base_struct_type.hpp>
 #include <dynd/types/date_type.hpp>
 #include <dynd/types/datetime_type.hpp>
@@ -32,6 +33,37 @@ struct init_pydatetime {
 init_pydatetime pdt;
 } // anonymous namespace
 
+static PyObject *string_as_pyobject(const ndt::type& d, const char *data, const char *metadata)
+{
+    const char *begin = NULL, *end = NULL;
+    const base_string_type *esd = static_cast<const base_string_type *>(d.extended());
+    esd->get_string_range(&begin, &end, metadata, data);
+    PyObject *result;
+    switch (esd->get_encoding()) {
+        case string_encoding_ascii:
+            // NumPy 'S' arrays are viewed as ascii without validation,
+            // so this has to reject bytes >= 0x80
+            result = PyUnicode_DecodeASCII(begin, end - begin, NULL);
+            break;
+        case string_encoding_utf_8:
+            result = PyUnicode_DecodeUTF8(begin, end - begin, NULL);
+            break;
+        case string_encoding_ucs_2:
+        case string_encoding_utf_16:
+            result = PyUnicode_DecodeUTF16(begin, end - begin, NULL, NULL);
+            break;
+        case string_encoding_utf_32:
+            result = PyUnicode_DecodeUTF32(begin, end - begin, NULL, NULL);
+            break;
+        default:
+            throw dynd::type_error("Unrecognized dynd array string encoding");
+    }
+    if (result == NULL) {
+        throw exception();
+    }
+    return result;
+}
+
 static PyObject* element_as_pyobject(const ndt::type& d, const char *data, const char *metadata)
 {
     switch (d.get_type_id()) {
@@ -95,24 +127,8 @@ static PyObject* element_as_pyobject(const ndt::type& d, const char *data, const
         }
         case fixedstring_type_id:
         case string_type_id:
-        case json_type_id: {
-            const char *begin = NULL, *end = NULL;
-            const base_string_type *esd = static_cast<const base_string_type *>(d.extended());
-            esd->get_string_range(&begin, &end, metadata, data);
-            switch (esd->get_encoding()) {
-                case string_encoding_ascii:
-                    return PyUnicode_DecodeASCII(begin, end - begin, NULL);
-                case string_encoding_utf_8:
-                    return PyUnicode_DecodeUTF8(begin, end - begin, NULL);
-                case string_encoding_ucs_2:
-                case string_encoding_utf_16:
-                    return PyUnicode_DecodeUTF16(begin, end - begin, NULL, NULL);
-                case string_encoding_utf_32:
-                    return PyUnicode_DecodeUTF32(begin, end - begin, NULL, NULL);
-                default:
-                    throw dynd::type_error("Unrecognized dynd array string encoding");
-            }
-        }
+        case json_type_id:
+            return string_as_pyobject(d, data, metadata);
         case date_type_id: {
             const date_type *dd = static_cast<const date_type *>(d.extended());
             int32_t year, month, day;
@@ -146,6 +162,211 @@ static PyObject* element_as_pyobject(const ndt::type& d, const char *data, const
     }
 }
 
+/**
+ * Python int objects for all the int8 and uint8 values, created
+ * on first use and kept for the lifetime of the module.
+ */
+static PyObject *small_int_cache[128 + 256];
+
+static inline PyObject *small_int_as_pyobject(long value)
+{
+    PyObject *&obj = small_int_cache[value + 128];
+    if (obj == NULL) {
+#if PY_VERSION_HEX >= 0x03000000
+        obj = PyLong_FromLong(value);
+#else
+        obj = PyInt_FromLong(value);
+#endif
+        if (obj == NULL) {
+            throw exception();
+        }
+    }
+    Py_INCREF(obj);
+    return obj;
+}
+
+namespace {
+    template<class T>
+    struct builtin_as_pyobject;
+
+    template<>
+    struct builtin_as_pyobject<dynd_bool> {
+        static inline PyObject *make(const char *data) {
+            PyObject *obj = *(const dynd_bool *)data ? Py_True : Py_False;
+            Py_INCREF(obj);
+            return obj;
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<int8_t> {
+        static inline PyObject *make(const char *data) {
+            return small_int_as_pyobject(*(const int8_t *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<uint8_t> {
+        static inline PyObject *make(const char *data) {
+            return small_int_as_pyobject(*(const uint8_t *)data);
+        }
+    };
+
+    template<class T>
+    struct builtin_as_pyobject_long {
+        static inline PyObject *make(const char *data) {
+#if PY_VERSION_HEX >= 0x03000000
+            return PyLong_FromLong(*(const T *)data);
+#else
+            return PyInt_FromLong(*(const T *)data);
+#endif
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<int16_t> : public builtin_as_pyobject_long<int16_t> {};
+    template<>
+    struct builtin_as_pyobject<int32_t> : public builtin_as_pyobject_long<int32_t> {};
+    template<>
+    struct builtin_as_pyobject<uint16_t> : public builtin_as_pyobject_long<uint16_t> {};
+
+    template<>
+    struct builtin_as_pyobject<int64_t> {
+        static inline PyObject *make(const char *data) {
+            return PyLong_FromLongLong(*(const int64_t *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<uint32_t> {
+        static inline PyObject *make(const char *data) {
+            return PyLong_FromUnsignedLong(*(const uint32_t *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<uint64_t> {
+        static inline PyObject *make(const char *data) {
+            return PyLong_FromUnsignedLongLong(*(const uint64_t *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<float> {
+        static inline PyObject *make(const char *data) {
+            return PyFloat_FromDouble(*(const float *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<double> {
+        static inline PyObject *make(const char *data) {
+            return PyFloat_FromDouble(*(const double *)data);
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<complex<float> > {
+        static inline PyObject *make(const char *data) {
+            return PyComplex_FromDoubles(*(const float *)data, *((const float *)data + 1));
+        }
+    };
+
+    template<>
+    struct builtin_as_pyobject<complex<double> > {
+        static inline PyObject *make(const char *data) {
+            return PyComplex_FromDoubles(*(const double *)data, *((const double *)data + 1));
+        }
+    };
+} // anonymous namespace
+
+template<class T>
+static PyObject *strided_builtin_as_pylist(const char *data, intptr_t stride, intptr_t size)
+{
+    pyobject_ownref lst(PyList_New(size));
+    for (intptr_t i = 0; i < size; ++i, data += stride) {
+        PyObject *item = builtin_as_pyobject<T>::make(data);
+        if (item == NULL) {
+            throw exception();
+        }
+        PyList_SET_ITEM(lst.get(), i, item);
+    }
+    return lst.release();
+}
+
+/**
+ * Converts a one-dimensional strided run of a builtin type into a
+ * Python list, with the type dispatch done once for the whole run.
+ * Returns NULL if the type isn't handled.
+ */
+static PyObject *strided_builtin_as_pylist(type_id_t type_id,
+                const char *data, intptr_t stride, intptr_t size)
+{
+    switch (type_id) {
+        case bool_type_id:
+            return strided_builtin_as_pylist<dynd_bool>(data, stride, size);
+        case int8_type_id:
+            return strided_builtin_as_pylist<int8_t>(data, stride, size);
+        case int16_type_id:
+            return strided_builtin_as_pylist<int16_t>(data, stride, size);
+        case int32_type_id:
+            return strided_builtin_as_pylist<int32_t>(data, stride, size);
+        case int64_type_id:
+            return strided_builtin_as_pylist<int64_t>(data, stride, size);
+        case uint8_type_id:
+            return strided_builtin_as_pylist<uint8_t>(data, stride, size);
+        case uint16_type_id:
+            return strided_builtin_as_pylist<uint16_t>(data, stride, size);
+        case uint32_type_id:
+            return strided_builtin_as_pylist<uint32_t>(data, stride, size);
+        case uint64_type_id:
+            return strided_builtin_as_pylist<uint64_t>(data, stride, size);
+        case float32_type_id:
+            return strided_builtin_as_pylist<float>(data, stride, size);
+        case float64_type_id:
+            return strided_builtin_as_pylist<double>(data, stride, size);
+        case complex_float32_type_id:
+            return strided_builtin_as_pylist<complex<float> >(data, stride, size);
+        case complex_float64_type_id:
+            return strided_builtin_as_pylist<complex<double> >(data, stride, size);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * If ``d`` is a strided or fixed dimension of a builtin type, converts
+ * it with strided_builtin_as_pylist, otherwise returns NULL.
+ */
+static PyObject *strided_dim_as_pylist(const ndt::type& d, const char *data, const char *metadata)
+{
+    intptr_t size, stride;
+    switch (d.get_type_id()) {
+        case strided_dim_type_id: {
+            const strided_dim_type_metadata *md =
+                            reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+            size = md->size;
+            stride = md->stride;
+            break;
+        }
+        case fixed_dim_type_id: {
+            const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(d.extended());
+            size = fdt->get_fixed_dim_size();
+            stride = fdt->get_fixed_stride();
+            break;
+        }
+        default:
+            return NULL;
+    }
+    const ndt::type& el_tp = static_cast<const base_uniform_dim_type *>(d.extended())->get_element_type();
+    if (!el_tp.is_builtin()) {
+        return NULL;
+    }
+    return strided_builtin_as_pylist(el_tp.get_type_id(), data, stride, size);
+}
+
+static PyObject *make_lazy_string_sequence(const nd::array& n);
+
 namespace {
     struct array_as_py_data {
         pyobject_ownref result;
@@ -188,6 +409,8 @@ static void nested_array_as_py(const ndt::type& d, char *data, const char *metad
         el.result.reset(element_as_pyobject(d, data, metadata));
     } else if (d.get_kind() == struct_kind) {
         nested_struct_as_py(d, data, metadata, &el);
+    } else if (PyObject *lst = strided_dim_as_pylist(d, data, metadata)) {
+        el.result.reset(lst);
     } else {
         intptr_t size = d.get_dim_size(metadata, data);
         el.result.reset(PyList_New(size));
@@ -203,13 +426,56 @@ static void nested_array_as_py(const ndt::type& d, char *data, const char *metad
     }
 }
 
-PyObject* pydynd::array_as_py(const dynd::nd::array& n)
+PyObject *pydynd::element_as_py(const ndt::type& d, const char *metadata, const char *data)
+{
+    if (d.is_scalar()) {
+        return element_as_pyobject(d, data, metadata);
+    }
+    array_as_py_data result;
+    nested_array_as_py(d, const_cast<char *>(data), metadata, &result);
+    return result.result.release();
+}
+
+PyObject* pydynd::array_as_py(const dynd::nd::array& n, bool lazy_strings)
 {
     // Evaluate the nd::array
-    nd::array nvals = n.eval();
+    nd::array nvals;
+    {
+        PyAllowThreads_RAII nogil;
+        nvals = n.eval();
+    }
+    if (lazy_strings && nvals.get_ndim() > 0 &&
+                    nvals.get_dtype().get_kind() == string_kind) {
+        return make_lazy_string_sequence(nvals);
+    }
     array_as_py_data result;
 
     nested_array_as_py(nvals.get_type(), nvals.get_ndo()->m_data_pointer, nvals.get_ndo_meta(), &result);
     return result.result.release();
 }
 
+
+static PyObject *WLazyStringSequence_Type = NULL;
+
+void pydynd::init_w_lazy_string_sequence_typeobject(PyObject *type)
+{
+    WLazyStringSequence_Type = type;
+}
+
+static PyObject *make_lazy_string_sequence(const nd::array& n)
+{
+    pyobject_ownref n_obj(wrap_array(n));
+    return PyObject_CallFunctionObjArgs(WLazyStringSequence_Type, n_obj.get(), NULL);
+}
+
+PyObject *pydynd::lazy_string_sequence_getitem(const dynd::nd::array& n, intptr_t i)
+{
+    const char *el_metadata = n.get_ndo_meta();
+    const char *el_data = n.get_readonly_originptr();
+    ndt::type el_tp = n.get_type().at_single(i, &el_metadata, &el_data);
+    if (el_tp.get_ndim() == 0) {
+        return string_as_pyobject(el_tp, el_data, el_metadata);
+    } else {
+        return make_lazy_string_sequence(n(i));
+    }
+}
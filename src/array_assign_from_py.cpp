@@ -264,6 +264,296 @@ static void array_assign_from_value(const dynd::ndt::type& dt,
     }
 }
 
+// The number of rows the struct records path converts at a time,
+// one field column after another
+static const intptr_t RECORDS_BATCH_SIZE = 256;
+
+namespace {
+    /**
+     * Converts Python dicts and tuples into a strided array of structs.
+     *
+     * The field names are interned once into a Python dict mapping
+     * them to field indices. The key objects and order of the last
+     * dict seen are cached, so a run of dicts with the same keys in
+     * the same order (as from json.loads, or dict literals) takes a
+     * positional fast path which only compares key pointers.
+     *
+     * Rows are processed in batches, first collecting the value
+     * objects of each row, then converting each field's column with
+     * a converter specialized for its type.
+     */
+    class struct_records_assigner {
+        const ndt::type& m_struct_tp;
+        const char *m_metadata;
+        size_t m_field_count;
+        const ndt::type *m_field_types;
+        const size_t *m_data_offsets;
+        const size_t *m_metadata_offsets;
+        // Maps field names to their indices
+        pyobject_ownref m_name_to_index;
+        // The key objects and field indices of the last dict, in order
+        vector<PyObject *> m_cached_keys;
+        vector<intptr_t> m_cached_order;
+
+        // Non-copyable
+        struct_records_assigner(const struct_records_assigner&);
+        struct_records_assigner& operator=(const struct_records_assigner&);
+
+        void clear_cached_keys() {
+            for (size_t i = 0; i < m_cached_keys.size(); ++i) {
+                Py_DECREF(m_cached_keys[i]);
+            }
+            m_cached_keys.clear();
+            m_cached_order.clear();
+        }
+
+        /**
+         * Looks up the field values of a dict into 'out_values', returning
+         * false if the dict doesn't have exactly the struct's fields.
+         */
+        bool resolve_dict(PyObject *d, PyObject **out_values) {
+            if ((size_t)PyDict_Size(d) != m_field_count) {
+                return false;
+            }
+            PyObject *key, *value;
+            Py_ssize_t pos = 0;
+            size_t j = 0;
+            if (m_cached_keys.size() == m_field_count) {
+                while (PyDict_Next(d, &pos, &key, &value) && key == m_cached_keys[j]) {
+                    out_values[m_cached_order[j++]] = value;
+                }
+                if (j == m_field_count) {
+                    return true;
+                }
+            }
+            // Look up the keys by name, and cache them for the next dict
+            clear_cached_keys();
+            pos = 0;
+            while (PyDict_Next(d, &pos, &key, &value)) {
+                PyObject *index_obj = PyDict_GetItem(m_name_to_index.get(), key);
+                if (index_obj == NULL) {
+                    if (PyErr_Occurred()) {
+                        PyErr_Clear();
+                    }
+                    clear_cached_keys();
+                    return false;
+                }
+                intptr_t i = PyLong_AsSsize_t(index_obj);
+                out_values[i] = value;
+                Py_INCREF(key);
+                m_cached_keys.push_back(key);
+                m_cached_order.push_back(i);
+            }
+            // With as many keys as fields, and every key naming a
+            // distinct field, all the fields are populated
+            return true;
+        }
+
+        /**
+         * Collects the field values of one row, returning false if
+         * it's neither a dict nor a sequence of the right size.
+         */
+        bool resolve_row(PyObject *row, PyObject **out_values) {
+            if (PyDict_Check(row)) {
+                return resolve_dict(row, out_values);
+            } else if (PyTuple_Check(row) || PyList_Check(row)) {
+                if ((size_t)PySequence_Fast_GET_SIZE(row) != m_field_count) {
+                    return false;
+                }
+                PyObject **items = PySequence_Fast_ITEMS(row);
+                for (size_t i = 0; i < m_field_count; ++i) {
+                    out_values[i] = items[i];
+                }
+                return true;
+            }
+            return false;
+        }
+
+        static inline bool assign_bool(char *data, PyObject *obj) {
+            if (obj == Py_True) {
+                *reinterpret_cast<dynd_bool *>(data) = true;
+                return true;
+            } else if (obj == Py_False) {
+                *reinterpret_cast<dynd_bool *>(data) = false;
+                return true;
+            }
+            return false;
+        }
+
+        static inline bool pyint_as_longlong(PyObject *obj, PY_LONG_LONG& out) {
+#if PY_VERSION_HEX < 0x03000000
+            if (PyInt_CheckExact(obj)) {
+                out = PyInt_AS_LONG(obj);
+                return true;
+            }
+#endif
+            if (PyLong_CheckExact(obj)) {
+                int overflow = 0;
+                out = PyLong_AsLongLongAndOverflow(obj, &overflow);
+                // Overflow is reported by the general conversion
+                return overflow == 0 && !(out == -1 && PyErr_Occurred());
+            }
+            return false;
+        }
+
+        static inline bool assign_int32(char *data, PyObject *obj) {
+            PY_LONG_LONG value;
+            if (pyint_as_longlong(obj, value) && value >= INT_MIN && value <= INT_MAX) {
+                *reinterpret_cast<int32_t *>(data) = static_cast<int32_t>(value);
+                return true;
+            }
+            return false;
+        }
+
+        static inline bool assign_int64(char *data, PyObject *obj) {
+            PY_LONG_LONG value;
+            if (pyint_as_longlong(obj, value)) {
+                *reinterpret_cast<int64_t *>(data) = static_cast<int64_t>(value);
+                return true;
+            }
+            return false;
+        }
+
+        static inline bool assign_float64(char *data, PyObject *obj) {
+            if (PyFloat_CheckExact(obj)) {
+                *reinterpret_cast<double *>(data) = PyFloat_AS_DOUBLE(obj);
+                return true;
+            }
+            PY_LONG_LONG value;
+            if (pyint_as_longlong(obj, value)) {
+                *reinterpret_cast<double *>(data) = static_cast<double>(value);
+                return true;
+            }
+            return false;
+        }
+
+        static inline bool assign_string(const ndt::type& tp, const char *metadata,
+                        char *data, PyObject *obj) {
+            if (PyUnicode_CheckExact(obj)) {
+                pyobject_ownref utf8(PyUnicode_AsUTF8String(obj));
+                char *s = NULL;
+                Py_ssize_t len = 0;
+                if (PyBytes_AsStringAndSize(utf8.get(), &s, &len) < 0) {
+                    throw exception();
+                }
+                static_cast<const string_type *>(tp.extended())->set_utf8_string(
+                                metadata, data, assign_error_default, s, s + len);
+                return true;
+#if PY_VERSION_HEX < 0x03000000
+            } else if (PyString_CheckExact(obj)) {
+                char *s = NULL;
+                Py_ssize_t len = 0;
+                if (PyString_AsStringAndSize(obj, &s, &len) < 0) {
+                    throw exception();
+                }
+                static_cast<const string_type *>(tp.extended())->set_utf8_string(
+                                metadata, data, assign_error_default, s, s + len);
+                return true;
+#endif
+            }
+            return false;
+        }
+
+        /**
+         * Converts one field of 'count' rows, whose values are
+         * 'values[r * m_field_count + field]'.
+         */
+        void assign_column(size_t field, char *data, intptr_t stride,
+                        PyObject **values, intptr_t count) {
+            const ndt::type& tp = m_field_types[field];
+            const char *metadata = m_metadata + m_metadata_offsets[field];
+            data += m_data_offsets[field];
+            values += field;
+            for (intptr_t r = 0; r < count; ++r, data += stride, values += m_field_count) {
+                PyObject *obj = *values;
+                bool done;
+                switch (tp.get_type_id()) {
+                    case bool_type_id:
+                        done = assign_bool(data, obj);
+                        break;
+                    case int32_type_id:
+                        done = assign_int32(data, obj);
+                        break;
+                    case int64_type_id:
+                        done = assign_int64(data, obj);
+                        break;
+                    case float64_type_id:
+                        done = assign_float64(data, obj);
+                        break;
+                    case string_type_id:
+                        done = assign_string(tp, metadata, data, obj);
+                        break;
+                    default:
+                        done = false;
+                        break;
+                }
+                if (!done) {
+                    array_assign_from_value(tp, metadata, data, obj);
+                }
+            }
+        }
+
+    public:
+        struct_records_assigner(const ndt::type& struct_tp, const char *metadata)
+            : m_struct_tp(struct_tp), m_metadata(metadata)
+        {
+            const base_struct_type *bsd = static_cast<const base_struct_type *>(struct_tp.extended());
+            m_field_count = bsd->get_field_count();
+            m_field_types = bsd->get_field_types();
+            m_data_offsets = bsd->get_data_offsets(metadata);
+            m_metadata_offsets = bsd->get_metadata_offsets();
+            const string *field_names = bsd->get_field_names();
+            m_name_to_index.reset(PyDict_New());
+            for (size_t i = 0; i < m_field_count; ++i) {
+#if PY_VERSION_HEX >= 0x03000000
+                pyobject_ownref name_obj(PyUnicode_InternFromString(field_names[i].c_str()));
+#else
+                pyobject_ownref name_obj(PyString_InternFromString(field_names[i].c_str()));
+#endif
+                pyobject_ownref index_obj(PyLong_FromSsize_t(i));
+                if (PyDict_SetItem(m_name_to_index.get(), name_obj.get(), index_obj.get()) < 0) {
+                    throw exception();
+                }
+            }
+        }
+
+        ~struct_records_assigner() {
+            clear_cached_keys();
+        }
+
+        void assign(char *dst_data, intptr_t dst_stride, PyObject **rows, intptr_t count) {
+            vector<PyObject *> values(RECORDS_BATCH_SIZE * m_field_count);
+            for (intptr_t batch_begin = 0; batch_begin < count; batch_begin += RECORDS_BATCH_SIZE) {
+                intptr_t batch_count = min(RECORDS_BATCH_SIZE, count - batch_begin);
+                char *batch_data = dst_data + batch_begin * dst_stride;
+                // Gather the field values of the batch's rows. Rows which
+                // aren't records are assigned through the general code,
+                // which also raises any errors.
+                intptr_t resolved = 0;
+                for (intptr_t r = 0; r < batch_count; ++r) {
+                    PyObject *row = rows[batch_begin + r];
+                    if (!resolve_row(row, &values[resolved * m_field_count])) {
+                        // Convert the rows collected so far, to keep them in order
+                        for (size_t f = 0; f < m_field_count; ++f) {
+                            assign_column(f, batch_data + (r - resolved) * dst_stride,
+                                            dst_stride, &values[0], resolved);
+                        }
+                        array_assign_from_value(m_struct_tp, m_metadata,
+                                        batch_data + r * dst_stride, row);
+                        resolved = 0;
+                    } else {
+                        ++resolved;
+                    }
+                }
+                for (size_t f = 0; f < m_field_count; ++f) {
+                    assign_column(f, batch_data + (batch_count - resolved) * dst_stride,
+                                    dst_stride, &values[0], resolved);
+                }
+            }
+        }
+    };
+} // anonymous namespace
+
 static void array_assign_strided_from_pyseq(const dynd::ndt::type& element_dt,
                 const char *element_metadata, char *dst_data, intptr_t dst_stride, size_t dst_size,
                 PyObject *seq, size_t seqsize)
@@ -286,6 +576,11 @@ static void array_assign_strided_from_pyseq(const dynd::ndt::type& element_dt,
         kdp->get_function<unary_strided_operation_t>()(
                         dst_data + dst_stride, dst_stride,
                         dst_data, 0, dst_size - 1, kdp);
+    } else if (element_dt.get_kind() == struct_kind && dst_size > 1) {
+        // Rows of dicts or tuples use the columnar records path
+        pyobject_ownref fast_seq(PySequence_Fast(seq, "expected a sequence"));
+        struct_records_assigner sra(element_dt, element_metadata);
+        sra.assign(dst_data, dst_stride, PySequence_Fast_ITEMS(fast_seq.get()), dst_size);
     } else {
         // Loop through the dst array and assign values
         for (size_t i = 0; i != dst_size; ++i) {
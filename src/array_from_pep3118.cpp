@@ -0,0 +1,451 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <Python.h>
+
+#include <ctype.h>
+#include <vector>
+
+#include <dynd/types/cstruct_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/fixedstring_type.hpp>
+#include <dynd/types/fixedbytes_type.hpp>
+#include <dynd/types/byteswap_type.hpp>
+#include <dynd/types/type_alignment.hpp>
+#include <dynd/memblock/external_memory_block.hpp>
+
+#include "array_from_pep3118.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+namespace {
+    inline bool native_is_little_endian()
+    {
+        union {
+            uint16_t u;
+            char s[2];
+        } vals;
+        vals.u = 1;
+        return vals.s[0] == 1;
+    }
+
+    ndt::type make_int_type(size_t size, bool is_signed)
+    {
+        switch (size) {
+            case 1:
+                return is_signed ? ndt::make_type<int8_t>() : ndt::make_type<uint8_t>();
+            case 2:
+                return is_signed ? ndt::make_type<int16_t>() : ndt::make_type<uint16_t>();
+            case 4:
+                return is_signed ? ndt::make_type<int32_t>() : ndt::make_type<uint32_t>();
+            case 8:
+                return is_signed ? ndt::make_type<int64_t>() : ndt::make_type<uint64_t>();
+            default: {
+                stringstream ss;
+                ss << "no dynd integer type has size " << size;
+                throw dynd::type_error(ss.str());
+            }
+        }
+    }
+
+    /**
+     * A recursive descent parser for the struct module format
+     * strings used by PEP 3118, producing a dynd type.
+     */
+    class pep3118_format_parser {
+        const char *m_format, *m_cur;
+        size_t m_data_alignment;
+        // The byte order, size and alignment mode, one of "@=<>!",
+        // or NumPy's '^' for native sizes without alignment
+        char m_mode;
+
+        void throw_error(const char *msg) const
+        {
+            stringstream ss;
+            ss << msg << " at position " << (m_cur - m_format);
+            ss << " of PEP 3118 format \"" << m_format << "\"";
+            throw dynd::type_error(ss.str());
+        }
+
+        void skip_whitespace()
+        {
+            while (isspace((unsigned char)*m_cur)) {
+                ++m_cur;
+            }
+        }
+
+        bool parse_uint(intptr_t& out_value)
+        {
+            if (!isdigit((unsigned char)*m_cur)) {
+                return false;
+            }
+            intptr_t value = 0;
+            while (isdigit((unsigned char)*m_cur)) {
+                value = 10 * value + (*m_cur - '0');
+                ++m_cur;
+            }
+            out_value = value;
+            return true;
+        }
+
+        bool is_byteswapped() const
+        {
+            switch (m_mode) {
+                case '<':
+                    return !native_is_little_endian();
+                case '>':
+                case '!':
+                    return native_is_little_endian();
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * The size of an integer format character, which depends
+         * on whether the mode uses native or standard sizes.
+         */
+        size_t int_size(char code) const
+        {
+            bool native = (m_mode == '@' || m_mode == '^');
+            switch (code) {
+                case 'b': case 'B':
+                    return 1;
+                case 'h': case 'H':
+                    return 2;
+                case 'i': case 'I':
+                    return native ? sizeof(int) : 4;
+                case 'l': case 'L':
+                    return native ? sizeof(long) : 4;
+                case 'q': case 'Q':
+                    return 8;
+                case 'n': case 'N':
+                    if (!native) {
+                        throw_error("'n' and 'N' are only valid with native sizes");
+                    }
+                    return sizeof(size_t);
+                default:
+                    throw_error("invalid integer format character");
+                    return 0;
+            }
+        }
+
+        /**
+         * Parses a single format character, other than 'x', 's',
+         * 'w' and 'T', into a scalar type.
+         */
+        ndt::type parse_scalar()
+        {
+            char code = *m_cur;
+            ndt::type tp;
+            switch (code) {
+                case '?':
+                    tp = ndt::make_type<dynd_bool>();
+                    break;
+                case 'c':
+                    tp = ndt::make_fixedbytes(1, 1);
+                    break;
+                case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+                    tp = make_int_type(int_size(code), true);
+                    break;
+                case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N':
+                    tp = make_int_type(int_size(code), false);
+                    break;
+                case 'f':
+                    tp = ndt::make_type<float>();
+                    break;
+                case 'd':
+                    tp = ndt::make_type<double>();
+                    break;
+                case 'Z':
+                    ++m_cur;
+                    if (*m_cur == 'f') {
+                        tp = ndt::make_type<complex<float> >();
+                    } else if (*m_cur == 'd') {
+                        tp = ndt::make_type<complex<double> >();
+                    } else {
+                        throw_error("unsupported complex format character");
+                    }
+                    break;
+                default:
+                    throw_error("unsupported format character");
+            }
+            ++m_cur;
+            if (tp.get_data_size() > 1 && is_byteswapped()) {
+                tp = ndt::make_byteswap(tp);
+            }
+            return tp;
+        }
+
+        /** Parses the name following a field, if it has one */
+        string parse_field_name()
+        {
+            skip_whitespace();
+            if (*m_cur != ':') {
+                return string();
+            }
+            const char *name_begin = ++m_cur;
+            while (*m_cur != ':') {
+                if (*m_cur == '\0') {
+                    throw_error("unterminated field name");
+                }
+                ++m_cur;
+            }
+            return string(name_begin, m_cur++);
+        }
+
+    public:
+        pep3118_format_parser(const char *format, size_t data_alignment)
+            : m_format(format), m_cur(format), m_data_alignment(data_alignment), m_mode('@')
+        {
+        }
+
+        /**
+         * Parses a sequence of fields ending with 'terminator', which
+         * becomes a cstruct. At the top level, a single unnamed field
+         * becomes just the field's type.
+         */
+        ndt::type parse_fields(char terminator, bool top_level)
+        {
+            vector<ndt::type> field_types;
+            vector<string> field_names;
+            vector<size_t> field_offsets;
+            size_t offset = 0;
+
+            for (;;) {
+                skip_whitespace();
+                char c = *m_cur;
+                if (c == terminator) {
+                    break;
+                } else if (c == '\0') {
+                    throw_error("unexpected end of the format");
+                } else if (c == '@' || c == '^' || c == '=' || c == '<' || c == '>' || c == '!') {
+                    m_mode = c;
+                    ++m_cur;
+                    continue;
+                }
+
+                // An optional subarray shape, like "(2,3)"
+                vector<intptr_t> shape;
+                if (c == '(') {
+                    ++m_cur;
+                    for (;;) {
+                        intptr_t dim_size;
+                        skip_whitespace();
+                        if (!parse_uint(dim_size)) {
+                            throw_error("expected a subarray dimension size");
+                        }
+                        shape.push_back(dim_size);
+                        skip_whitespace();
+                        if (*m_cur == ')') {
+                            ++m_cur;
+                            break;
+                        } else if (*m_cur != ',') {
+                            throw_error("expected ',' or ')' in subarray shape");
+                        }
+                        ++m_cur;
+                    }
+                }
+
+                // An optional repeat count, or string length
+                intptr_t count = 1;
+                parse_uint(count);
+
+                ndt::type tp;
+                switch (*m_cur) {
+                    case 'x':
+                        // Padding bytes
+                        if (!shape.empty()) {
+                            throw_error("padding may not have a subarray shape");
+                        }
+                        ++m_cur;
+                        offset += count;
+                        continue;
+                    case 's':
+                        ++m_cur;
+                        tp = ndt::make_fixedstring(count, string_encoding_ascii);
+                        count = 1;
+                        break;
+                    case 'w':
+                        if (is_byteswapped()) {
+                            throw_error("non-native byte order UCS-4 strings are not supported");
+                        }
+                        ++m_cur;
+                        tp = ndt::make_fixedstring(count, string_encoding_utf_32);
+                        count = 1;
+                        break;
+                    case 'T': {
+                        ++m_cur;
+                        if (*m_cur != '{') {
+                            throw_error("expected '{' after 'T'");
+                        }
+                        ++m_cur;
+                        // A byte order set inside the struct only applies there
+                        char saved_mode = m_mode;
+                        tp = parse_fields('}', false);
+                        m_mode = saved_mode;
+                        ++m_cur;
+                        break;
+                    }
+                    default:
+                        tp = parse_scalar();
+                        break;
+                }
+
+                // A repeat count becomes the innermost subarray dimension
+                if (count != 1) {
+                    shape.push_back(count);
+                }
+                if (!shape.empty()) {
+                    tp = ndt::make_fixed_dim(shape.size(), &shape[0], tp, NULL);
+                }
+
+                // Native mode aligns each field like a C struct would
+                size_t alignment = tp.get_data_alignment();
+                if (m_mode == '@') {
+                    offset = (offset + alignment - 1) & ~(alignment - 1);
+                }
+                if (!offset_is_aligned(offset | m_data_alignment, alignment)) {
+                    tp = make_unaligned(tp);
+                }
+
+                field_types.push_back(tp);
+                field_names.push_back(parse_field_name());
+                field_offsets.push_back(offset);
+                offset += tp.get_data_size();
+            }
+
+            if (field_types.empty()) {
+                throw_error("expected at least one field");
+            }
+            if (top_level && field_types.size() == 1 && field_names[0].empty() &&
+                            offset == field_types[0].get_data_size()) {
+                return field_types[0];
+            }
+
+            // Unnamed fields get NumPy's default names
+            for (size_t i = 0; i < field_names.size(); ++i) {
+                if (field_names[i].empty()) {
+                    stringstream ss;
+                    ss << "f" << i;
+                    field_names[i] = ss.str();
+                }
+            }
+            if (!is_cstruct_compatible_offsets(field_types.size(), &field_types[0],
+                            &field_offsets[0], offset)) {
+                throw_error("struct layout is not supported by dynd");
+            }
+            return ndt::make_cstruct(field_types.size(), &field_types[0], &field_names[0]);
+        }
+    };
+
+    /** Releases and frees a heap allocated Py_buffer */
+    void py_buffer_release_function(void *ptr)
+    {
+        if (ptr != NULL) {
+            // The exporter may be released from any thread,
+            // so make sure we're holding the GIL
+            PyGILState_STATE gstate;
+            gstate = PyGILState_Ensure();
+            PyBuffer_Release(reinterpret_cast<Py_buffer *>(ptr));
+            PyGILState_Release(gstate);
+            delete reinterpret_cast<Py_buffer *>(ptr);
+        }
+    }
+
+    size_t get_alignment_of(const Py_buffer *buffer)
+    {
+        uintptr_t align_bits = reinterpret_cast<uintptr_t>(buffer->buf);
+        if (buffer->strides != NULL) {
+            for (int i = 0; i < buffer->ndim; ++i) {
+                align_bits |= (uintptr_t)buffer->strides[i];
+            }
+        }
+        // The maximum alignment of any dynd type is 16
+        size_t alignment = 1;
+        while (alignment < 16 && (align_bits & alignment) == 0) {
+            alignment <<= 1;
+        }
+        return alignment;
+    }
+} // anonymous namespace
+
+ndt::type pydynd::pep3118_type_from_format(const char *format, size_t data_alignment)
+{
+    pep3118_format_parser parser(format, data_alignment);
+    return parser.parse_fields('\0', true);
+}
+
+bool pydynd::is_pep3118_exporter(PyObject *obj)
+{
+    return PyObject_CheckBuffer(obj) && !PyBytes_Check(obj) && !PyUnicode_Check(obj);
+}
+
+nd::array pydynd::array_from_pep3118(PyObject *obj, uint32_t access_flags, bool always_copy)
+{
+    if (!always_copy && (access_flags&nd::immutable_access_flag)) {
+        throw runtime_error("cannot view a python buffer as immutable");
+    }
+
+    // The memory block owns the Py_buffer, releasing it when the
+    // last array viewing the buffer goes away
+    Py_buffer *buffer = new Py_buffer;
+    int flags = (!always_copy && (access_flags&nd::write_access_flag)) ?
+                    PyBUF_RECORDS : PyBUF_RECORDS_RO;
+    if (PyObject_GetBuffer(obj, buffer, flags) < 0) {
+        delete buffer;
+        throw exception();
+    }
+    memory_block_ptr memblock = make_external_memory_block(buffer, &py_buffer_release_function);
+
+    if (buffer->suboffsets != NULL) {
+        for (int i = 0; i < buffer->ndim; ++i) {
+            if (buffer->suboffsets[i] >= 0) {
+                throw runtime_error("cannot view a python buffer with suboffsets as a dynd array");
+            }
+        }
+    }
+    if (!always_copy && (access_flags&nd::write_access_flag) && buffer->readonly) {
+        throw runtime_error("cannot view a readonly python buffer as readwrite");
+    }
+
+    // A NULL format means unsigned bytes
+    const char *format = (buffer->format != NULL) ? buffer->format : "B";
+    ndt::type tp = pep3118_type_from_format(format, get_alignment_of(buffer));
+    if (tp.get_data_size() != (size_t)buffer->itemsize) {
+        stringstream ss;
+        ss << "PEP 3118 buffer has itemsize " << buffer->itemsize << ", but its format \"";
+        ss << format << "\" converts to dynd type " << tp;
+        ss << " of size " << tp.get_data_size();
+        throw dynd::type_error(ss.str());
+    }
+
+    // Exporters may leave out the strides of C-contiguous data
+    int ndim = buffer->ndim;
+    dimvector shape(ndim), strides(ndim);
+    intptr_t stride = buffer->itemsize;
+    for (int i = ndim - 1; i >= 0; --i) {
+        shape[i] = buffer->shape[i];
+        strides[i] = (buffer->strides != NULL) ? buffer->strides[i] : stride;
+        stride *= shape[i];
+    }
+
+    nd::array result = nd::make_strided_array_from_data(tp, ndim, shape.get(), strides.get(),
+                    nd::read_access_flag | (buffer->readonly ? 0 : nd::write_access_flag),
+                    reinterpret_cast<char *>(buffer->buf), DYND_MOVE(memblock), NULL);
+
+    if (always_copy) {
+        return result.eval_copy(access_flags);
+    } else {
+        if (access_flags != 0) {
+            // Use the requested access flags
+            result.get_ndo()->m_flags = access_flags;
+        }
+        return result;
+    }
+}
@@ -6,6 +6,9 @@
 #include <Python.h>
 #include <datetime.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include <dynd/types/string_type.hpp>
 #include <dynd/types/bytes_type.hpp>
 #include <dynd/types/strided_dim_type.hpp>
@@ -19,20 +22,27 @@
 #include <dynd/memblock/pod_memory_block.hpp>
 #include <dynd/type_promotion.hpp>
 #include <dynd/exceptions.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
 
 #include "array_from_py.hpp"
 #include "array_from_py_typededuction.hpp"
 #include "array_from_py_dynamic.hpp"
 #include "array_assign_from_py.hpp"
+#include "array_from_pep3118.hpp"
 #include "array_functions.hpp"
 #include "type_functions.hpp"
 #include "utility_functions.hpp"
 #include "numpy_interop.hpp"
+#include "parallel_for.hpp"
 
 using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
+// List sizes, in elements, below which filling in parallel isn't worth it
+static const intptr_t PARALLEL_FILL_MIN_COUNT = 1 << 18;
+static const intptr_t PARALLEL_FILL_MIN_CHUNK = 1 << 16;
+
 // Initialize the pydatetime API
 namespace {
 struct init_pydatetime {
@@ -263,8 +273,300 @@ static void fill_array_from_pylist(const ndt::type& tp, const char *metadata, ch
     }
 }
 
+/**
+ * The builtin types which the speculative list ingestion handles,
+ * ordered so that each one can hold any value of the ones before it.
+ * The index into this array is the "rank" of a Python scalar.
+ */
+static const type_id_t speculative_type_ids[] = {
+    bool_type_id,
+    int32_type_id,
+    int64_type_id,
+    float64_type_id,
+    complex_float64_type_id
+};
+
+/**
+ * Returns the speculative rank of a Python scalar, matching what
+ * deduce_ndt_type_from_pyobject would produce for it, or -1 if the
+ * object is not one the speculative path handles.
+ */
+static inline int pyscalar_speculative_rank(PyObject *obj)
+{
+    if (PyFloat_CheckExact(obj)) {
+        return 3;
+    } else if (PyBool_Check(obj)) {
+        return 0;
+#if PY_VERSION_HEX < 0x03000000
+    } else if (PyInt_CheckExact(obj)) {
+# if SIZEOF_LONG > SIZEOF_INT
+        long value = PyInt_AS_LONG(obj);
+        return (value >= INT_MIN && value <= INT_MAX) ? 1 : 2;
+# else
+        return 1;
+# endif
+#endif // PY_VERSION_HEX < 0x03000000
+    } else if (PyLong_CheckExact(obj)) {
+        int overflow = 0;
+        PY_LONG_LONG value = PyLong_AsLongLongAndOverflow(obj, &overflow);
+        if (overflow != 0) {
+            // Let the two-pass code produce its usual error
+            return -1;
+        }
+        return (value >= INT_MIN && value <= INT_MAX) ? 1 : 2;
+    } else if (PyComplex_CheckExact(obj)) {
+        return 4;
+    }
+    return -1;
+}
+
+namespace {
+    struct speculative_fill_state {
+        // The shape guessed from the first element of each nested list
+        vector<intptr_t> shape;
+        // The speculated element type, and its rank
+        int rank;
+        ndt::type tp;
+        // The C-contiguous destination array
+        nd::array arr;
+        char *origin;
+        intptr_t stride;
+        // How many elements have been written so far
+        intptr_t index;
+    };
+} // anonymous namespace
+
+/**
+ * Converts elements of an innermost list starting at ``i``, stopping at
+ * the first one whose rank is not covered by ``Rank``. Returns the index
+ * where it stopped.
+ */
+template<convert_one_pyscalar_function_t ConvertOneFn, int Rank>
+static Py_ssize_t speculative_fill_run(speculative_fill_state& st, PyObject *obj, Py_ssize_t i)
+{
+    Py_ssize_t size = PyList_GET_SIZE(obj), begin = i;
+    intptr_t stride = st.stride;
+    char *data = st.origin + st.index * stride;
+    for (; i < size; ++i, data += stride) {
+        PyObject *item = PyList_GET_ITEM(obj, i);
+        int rank = pyscalar_speculative_rank(item);
+        if (rank < 0 || rank > Rank) {
+            break;
+        }
+        ConvertOneFn(st.tp, NULL, data, item);
+    }
+    st.index += i - begin;
+    return i;
+}
+
+/**
+ * Promotes the speculative destination to the type of the given rank,
+ * copying the elements written so far with an assignment kernel in
+ * the same way copy_to_promoted_nd_arr does for the dynamic conversion.
+ * Returns false if type promotion doesn't agree with the rank ordering,
+ * in which case the speculation is abandoned.
+ */
+static bool promote_speculative_fill(speculative_fill_state& st, int rank)
+{
+    ndt::type tp = promote_types_arithmetic(
+                    ndt::type(speculative_type_ids[rank]), st.tp);
+    if (tp.get_type_id() != speculative_type_ids[rank]) {
+        return false;
+    }
+    nd::array arr = nd::make_strided_array(tp, (int)st.shape.size(), &st.shape[0],
+                    nd::read_access_flag|nd::write_access_flag, NULL);
+    char *origin = arr.get_readwrite_originptr();
+    intptr_t stride = tp.get_data_size();
+    if (st.index > 0) {
+        assignment_strided_ckernel_builder k;
+        make_assignment_kernel(&k, 0, tp, NULL, st.tp, NULL,
+                        kernel_request_strided,
+                        assign_error_none, &eval::default_eval_context);
+        k(origin, stride, st.origin, st.stride, st.index);
+    }
+    st.rank = rank;
+    st.tp.swap(tp);
+    st.arr.swap(arr);
+    st.origin = origin;
+    st.stride = stride;
+    return true;
+}
+
+static bool speculative_fill_innermost(speculative_fill_state& st, PyObject *obj)
+{
+    Py_ssize_t size = PyList_GET_SIZE(obj), i = 0;
+    for (;;) {
+        switch (st.rank) {
+            case 0:
+                i = speculative_fill_run<convert_one_pyscalar_bool, 0>(st, obj, i);
+                break;
+            case 1:
+                i = speculative_fill_run<convert_one_pyscalar_int32, 1>(st, obj, i);
+                break;
+            case 2:
+                i = speculative_fill_run<convert_one_pyscalar_int64, 2>(st, obj, i);
+                break;
+            case 3:
+                i = speculative_fill_run<convert_one_pyscalar_float64, 3>(st, obj, i);
+                break;
+            default:
+                i = speculative_fill_run<convert_one_pyscalar_cdouble, 4>(st, obj, i);
+                break;
+        }
+        if (i == size) {
+            return true;
+        }
+        // Either promote and keep going, or give up on an unknown object
+        int rank = pyscalar_speculative_rank(PyList_GET_ITEM(obj, i));
+        if (rank < 0 || !promote_speculative_fill(st, rank)) {
+            return false;
+        }
+    }
+}
+
+static bool speculative_fill(speculative_fill_state& st, PyObject *obj, size_t current_axis)
+{
+    if (current_axis + 1 == st.shape.size()) {
+        return speculative_fill_innermost(st, obj);
+    }
+
+    Py_ssize_t size = PyList_GET_SIZE(obj);
+    intptr_t child_size = st.shape[current_axis + 1];
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        PyObject *item = PyList_GET_ITEM(obj, i);
+        if (!PyList_Check(item) || PyList_GET_SIZE(item) != child_size ||
+                        !speculative_fill(st, item, current_axis + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Fills float64 values from an element of a rectangular nested list
+ * without using the Python API, so it can run on threads which don't
+ * hold the GIL while the thread which called into dynd holds it, keeping
+ * the lists from being modified. Only exact Python floats (and on Python 2,
+ * exact ints) are accepted, reading their value directly out of the object.
+ * Returns false on anything else, leaving it to the serial code.
+ *
+ * \param obj  The element, a scalar if ``ndim`` is 0, a list otherwise.
+ * \param shape  The shape the element must have.
+ * \param ndim  The number of dimensions the element must have.
+ * \param data  The output pointer, advanced past the values filled.
+ */
+static bool parallel_fill_float64(PyObject *obj, const intptr_t *shape,
+                size_t ndim, double *&data)
+{
+    if (ndim == 0) {
+        if (PyFloat_CheckExact(obj)) {
+            *data++ = PyFloat_AS_DOUBLE(obj);
+            return true;
+#if PY_VERSION_HEX < 0x03000000
+        } else if (PyInt_CheckExact(obj)) {
+            *data++ = (double)PyInt_AS_LONG(obj);
+            return true;
+#endif
+        }
+        return false;
+    }
+
+    if (!PyList_CheckExact(obj) || PyList_GET_SIZE(obj) != shape[0]) {
+        return false;
+    }
+    for (Py_ssize_t i = 0, size = PyList_GET_SIZE(obj); i < size; ++i) {
+        if (!parallel_fill_float64(PyList_GET_ITEM(obj, i), shape + 1, ndim - 1, data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Splits the outermost dimension of a speculated float64 fill into
+ * chunks, filling them concurrently. Returns false if any chunk ran
+ * into a value it couldn't handle, in which case the serial
+ * speculative fill redoes the whole array.
+ */
+static bool parallel_speculative_fill(speculative_fill_state& st, PyObject *obj)
+{
+    size_t ndim = st.shape.size();
+    intptr_t inner_count = 1;
+    for (size_t i = 1; i < ndim; ++i) {
+        inner_count *= st.shape[i];
+    }
+    double *origin = reinterpret_cast<double *>(st.origin);
+    const intptr_t *inner_shape = &st.shape[0] + 1;
+    atomic<bool> ok(true);
+    parallel_for(st.shape[0], max(PARALLEL_FILL_MIN_CHUNK / inner_count, (intptr_t)1),
+                    [&](intptr_t begin, intptr_t end) {
+        double *data = origin + begin * inner_count;
+        for (intptr_t i = begin; i < end; ++i) {
+            if (!parallel_fill_float64(PyList_GET_ITEM(obj, i), inner_shape, ndim - 1, data)) {
+                ok.store(false);
+                return;
+            }
+        }
+    });
+    return ok.load();
+}
+
+/**
+ * Converts a rectangular nested list of Python numbers in a single pass,
+ * guessing the shape and type from the first element and promoting
+ * the partially filled result when a later element disagrees. Returns
+ * a NULL array if the guess doesn't work out, e.g. for ragged lists or
+ * other kinds of objects, and the caller falls back to the deduce-then-fill
+ * conversion.
+ */
+static nd::array array_from_pylist_speculative(PyObject *obj)
+{
+    speculative_fill_state st;
+    PyObject *first = obj;
+    while (PyList_Check(first)) {
+        Py_ssize_t size = PyList_GET_SIZE(first);
+        if (size == 0) {
+            return nd::array();
+        }
+        st.shape.push_back(size);
+        first = PyList_GET_ITEM(first, 0);
+    }
+    st.rank = pyscalar_speculative_rank(first);
+    if (st.rank < 0) {
+        return nd::array();
+    }
+
+    st.tp = ndt::type(speculative_type_ids[st.rank]);
+    st.arr = nd::make_strided_array(st.tp, (int)st.shape.size(), &st.shape[0],
+                    nd::read_access_flag|nd::write_access_flag, NULL);
+    st.origin = st.arr.get_readwrite_originptr();
+    st.stride = st.tp.get_data_size();
+    st.index = 0;
+    // With multiple threads enabled, large float lists get filled in parallel
+    if (st.rank == 3 && get_num_threads() > 1) {
+        intptr_t count = 1;
+        for (size_t i = 0; i < st.shape.size(); ++i) {
+            count *= st.shape[i];
+        }
+        if (count >= PARALLEL_FILL_MIN_COUNT && parallel_speculative_fill(st, obj)) {
+            return st.arr;
+        }
+    }
+    if (!speculative_fill(st, obj, 0)) {
+        return nd::array();
+    }
+    return st.arr;
+}
+
 static dynd::nd::array array_from_pylist(PyObject *obj)
 {
+    // Most lists are rectangular and contain Python numbers, try
+    // converting those in a single pass first
+    nd::array spec_result = array_from_pylist_speculative(obj);
+    if (spec_result.get_ndo() != NULL) {
+        return spec_result;
+    }
+
     // TODO: Add ability to specify access flags (e.g. immutable)
     // Do a pass through all the data to deduce its type and shape
     vector<intptr_t> shape;
@@ -394,6 +696,16 @@ dynd::nd::array pydynd::array_from_py(PyObject *obj, uint32_t access_flags, bool
     }
 #endif // DYND_NUMPY_INTEROP
 
+    // Objects exporting the buffer protocol are viewed (or copied)
+    // directly from their memory. If dynd can't represent the buffer's
+    // format, they go through the generic conversions below.
+    if (is_pep3118_exporter(obj)) {
+        try {
+            return array_from_pep3118(obj, access_flags, always_copy);
+        } catch (const dynd::type_error&) {
+        }
+    }
+
     nd::array result;
 
     if (PyBool_Check(obj)) {
@@ -1215,3 +1215,226 @@ dynd::nd::array pydynd::array_from_py_dynamic(PyObject *obj)
     }
     return arr;
 }
+
+// The element capacity of the first chunk of an array_builder, and
+// the capacity at which chunks stop doubling in size
+static const intptr_t ARRAY_BUILDER_INITIAL_CAPACITY = 1024;
+static const intptr_t ARRAY_BUILDER_MAX_CAPACITY = 1 << 20;
+
+/**
+ * Assigns a Python scalar to an element using the specialized
+ * assignment functions above, for the types they handle exactly.
+ * Returns false if the value or the type isn't handled.
+ */
+static bool array_builder_scalar_assign(const ndt::type& tp, const char *metadata,
+                char *data, PyObject *obj)
+{
+    switch (tp.get_type_id()) {
+        case bool_type_id:
+            return bool_assign(data, obj);
+        case int32_type_id:
+        case int64_type_id:
+            // int_assign accepts bools as ints, but type deduction doesn't
+            return !PyBool_Check(obj) && int_assign(tp, data, obj);
+        case float64_type_id:
+            return real_assign(data, obj);
+        case complex_float64_type_id:
+            return complex_assign(data, obj);
+        case string_type_id:
+            return string_assign(tp, metadata, data, obj);
+#if PY_VERSION_HEX >= 0x03000000
+        case bytes_type_id:
+            return bytes_assign(tp, metadata, data, obj);
+#endif
+        default:
+            return false;
+    }
+}
+
+array_builder::array_builder(const ndt::type& dtype)
+    : m_deduce_dtype(dtype.get_type_id() == uninitialized_type_id),
+      m_dtype(dtype), m_size(0)
+{
+    if (dtype.get_ndim() > 0 && dtype.get_type_id() != fixed_dim_type_id &&
+                    dtype.get_type_id() != var_dim_type_id) {
+        stringstream ss;
+        ss << "nd.array_builder requires dimensions in its dtype to be fixed or var, not " << dtype;
+        throw type_error(ss.str());
+    }
+}
+
+array_builder::chunk& array_builder::get_writable_chunk()
+{
+    if (!m_chunks.empty()) {
+        chunk& c = m_chunks.back();
+        if (c.size < c.capacity && c.dtype == m_dtype) {
+            return c;
+        }
+    }
+    // Start a new chunk, growing geometrically
+    intptr_t capacity = ARRAY_BUILDER_INITIAL_CAPACITY;
+    if (!m_chunks.empty()) {
+        capacity = min(m_chunks.back().capacity * 2, ARRAY_BUILDER_MAX_CAPACITY);
+    }
+    m_chunks.push_back(chunk());
+    chunk& c = m_chunks.back();
+    c.dtype = m_dtype;
+    c.arr = nd::empty(capacity, m_dtype);
+    c.size = 0;
+    c.capacity = capacity;
+    c.stride = reinterpret_cast<const strided_dim_type_metadata *>(c.arr.get_ndo_meta())->stride;
+    c.data = c.arr.get_readwrite_originptr();
+    c.el_metadata = c.arr.get_ndo_meta() + sizeof(strided_dim_type_metadata);
+    return c;
+}
+
+void array_builder::promote_dtype(PyObject *obj)
+{
+    ndt::type tp = deduce_ndt_type_from_pyobject(obj);
+    if (tp.get_ndim() > 0 || tp.get_kind() == void_kind) {
+        stringstream ss;
+        ss << "nd.array_builder can only deduce a dtype from scalar values, ";
+        ss << "provide a dtype to build from values like ";
+        pyobject_ownref repr(PyObject_Repr(obj));
+        ss << pystring_as_string(repr.get());
+        throw type_error(ss.str());
+    }
+    if (m_dtype.get_type_id() == uninitialized_type_id) {
+        m_dtype = tp;
+    } else {
+        ndt::type promoted = promote_types_arithmetic(m_dtype, tp);
+        if (promoted != m_dtype) {
+            m_dtype = promoted;
+            // An empty chunk of the old dtype can be dropped, otherwise
+            // it's left as is, and converted once by finish()
+            if (!m_chunks.empty() && m_chunks.back().size == 0) {
+                m_chunks.pop_back();
+            }
+        }
+    }
+}
+
+void array_builder::append(PyObject *obj)
+{
+    if (m_dtype.get_type_id() == uninitialized_type_id) {
+        promote_dtype(obj);
+    }
+    chunk *c = &get_writable_chunk();
+    char *data = c->data + c->size * c->stride;
+    if (!array_builder_scalar_assign(m_dtype, c->el_metadata, data, obj)) {
+        if (m_deduce_dtype) {
+            ndt::type old_dtype = m_dtype;
+            promote_dtype(obj);
+            if (m_dtype != old_dtype) {
+                c = &get_writable_chunk();
+                data = c->data + c->size * c->stride;
+            }
+        }
+        array_broadcast_assign_from_py(m_dtype, c->el_metadata, data, obj);
+    }
+    ++c->size;
+    ++m_size;
+}
+
+void array_builder::extend(PyObject *iterable)
+{
+    if (PyList_Check(iterable) || PyTuple_Check(iterable)) {
+        Py_ssize_t size = PySequence_Fast_GET_SIZE(iterable);
+        PyObject **items = PySequence_Fast_ITEMS(iterable);
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            append(items[i]);
+        }
+        return;
+    }
+
+    pyobject_ownref iter(PyObject_GetIter(iterable));
+    PyObject *item;
+    while ((item = PyIter_Next(iter.get())) != NULL) {
+        pyobject_ownref item_ref(item);
+        append(item);
+    }
+    if (PyErr_Occurred()) {
+        throw exception();
+    }
+}
+
+nd::array array_builder::finish()
+{
+    nd::array result;
+    if (m_dtype.get_type_id() == uninitialized_type_id) {
+        // No values, so produce the same as nd.array([])
+        pyobject_ownref empty_list(PyList_New(0));
+        result = array_from_py(empty_list.get(), 0, false);
+    } else {
+        for (size_t i = 0; i < m_chunks.size(); ++i) {
+            const nd::array& arr = m_chunks[i].arr;
+            if (!arr.get_type().is_builtin()) {
+                arr.get_type().extended()->metadata_finalize_buffers(arr.get_ndo_meta());
+            }
+        }
+        if (m_chunks.size() == 1 && m_chunks[0].dtype == m_dtype) {
+            // A single chunk is viewed, not copied
+            result = m_chunks[0].arr(irange(0, m_chunks[0].size));
+        } else {
+            result = nd::empty(m_size, m_dtype);
+            intptr_t offset = 0;
+            for (size_t i = 0; i < m_chunks.size(); ++i) {
+                const chunk& c = m_chunks[i];
+                result(irange(offset, offset + c.size)).vals() = c.arr(irange(0, c.size));
+                offset += c.size;
+            }
+        }
+    }
+
+    // Reset to an empty builder, keeping a dtype that was provided
+    m_chunks.clear();
+    m_size = 0;
+    if (m_deduce_dtype) {
+        m_dtype = ndt::type();
+    }
+    result.flag_as_immutable();
+    return result;
+}
+
+array_builder *pydynd::make_array_builder(PyObject *dtype)
+{
+    if (dtype == Py_None) {
+        return new array_builder(ndt::type());
+    } else {
+        return new array_builder(make_ndt_type_from_pyobject(dtype));
+    }
+}
+
+void pydynd::delete_array_builder(array_builder *builder)
+{
+    delete builder;
+}
+
+void pydynd::array_builder_append(array_builder *builder, PyObject *obj)
+{
+    builder->append(obj);
+}
+
+void pydynd::array_builder_extend(array_builder *builder, PyObject *iterable)
+{
+    builder->extend(iterable);
+}
+
+dynd::nd::array pydynd::array_builder_finish(array_builder *builder)
+{
+    return builder->finish();
+}
+
+intptr_t pydynd::array_builder_size(const array_builder *builder)
+{
+    return builder->size();
+}
+
+PyObject *pydynd::array_builder_get_dtype(const array_builder *builder)
+{
+    if (builder->get_dtype().get_type_id() == uninitialized_type_id) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return wrap_ndt_type(builder->get_dtype());
+}
@@ -9,6 +9,11 @@
 #include "type_functions.hpp"
 #include "utility_functions.hpp"
 #include "numpy_interop.hpp"
+#include "parallel_for.hpp"
+#include "array_gather_scatter.hpp"
+#include "array_from_pep3118.hpp"
+
+#include <algorithm>
 
 #include <dynd/types/string_type.hpp>
 #include <dynd/types/base_uniform_dim_type.hpp>
@@ -19,11 +24,19 @@
 #include <dynd/types/base_bytes_type.hpp>
 #include <dynd/types/struct_type.hpp>
 #include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/groupby_type.hpp>
+#include <dynd/json_parser.hpp>
+#include <dynd/json_formatter.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
 
 using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
+// Element counts below which evaluating in parallel isn't worth it
+static const intptr_t PARALLEL_EVAL_MIN_COUNT = 1 << 14;
+
 PyTypeObject *pydynd::WArray_Type;
 
 void pydynd::init_w_array_typeobject(PyObject *type)
@@ -300,7 +313,11 @@ dynd::nd::array pydynd::array_view(PyObject *obj, PyObject *access)
         return array_from_numpy_array((PyArrayObject *)obj, access_flags, false);
     }
 
-    // TODO: add python buffer protocol support here
+    // If it exposes the python buffer protocol
+    if (is_pep3118_exporter(obj)) {
+        return array_from_pep3118(obj, access_flags, false);
+    }
+
     stringstream ss;
     pyobject_ownref obj_tp(PyObject_Repr((PyObject *)Py_TYPE(obj)));
     ss << "object of type " << pystring_as_string(obj_tp.get());
@@ -352,9 +369,18 @@ dynd::nd::array pydynd::array_asarray(PyObject *obj, PyObject *access)
         }
     }
 
-    // If it's a numpy array
+    // If it's a numpy array, or exposes the python buffer protocol
+    // with a format dynd understands, start from a view of it
+    nd::array result;
     if (PyArray_Check(obj)) {
-        nd::array result = array_from_numpy_array((PyArrayObject *)obj, access_flags, false);
+        result = array_from_numpy_array((PyArrayObject *)obj, access_flags, false);
+    } else if ((access_flags&nd::immutable_access_flag) == 0 && is_pep3118_exporter(obj)) {
+        try {
+            result = array_from_pep3118(obj, 0, false);
+        } catch (const dynd::type_error&) {
+        }
+    }
+    if (result.get_ndo() != NULL) {
         if (access_flags == 0) {
             // Always return it as a view if no specific access flags are specified
             return result;
@@ -379,13 +405,87 @@ dynd::nd::array pydynd::array_asarray(PyObject *obj, PyObject *access)
         }
     }
 
-    // TODO: Check for the python buffer protocol.
-
     return array_from_py(obj, access_flags, true);
 }
 
-dynd::nd::array pydynd::array_eval(const dynd::nd::array& n)
+/**
+ * Evaluates an expression array whose leading dimension is strided
+ * or fixed by splitting that dimension into one chunk per thread,
+ * each of which instantiates its own strided assignment ckernel.
+ * Returns a NULL array if the array isn't suitable, or is too small
+ * for this to be worth it.
+ *
+ * The result must be POD with only strided or fixed dimensions,
+ * because destinations like strings and var dims allocate from a
+ * memory block shared by all the threads, which isn't thread-safe.
+ */
+static nd::array parallel_eval(const nd::array& n, int num_threads)
+{
+    intptr_t ndim = n.get_ndim();
+    if (num_threads <= 1 || ndim == 0 ||
+                    n.get_dtype().get_kind() != expression_kind) {
+        return nd::array();
+    }
+    if (!n.get_dtype().value_type().is_pod()) {
+        return nd::array();
+    }
+    for (intptr_t i = 0; i < ndim; ++i) {
+        type_id_t dim_type_id = n.get_type().get_type_at_dimension(NULL, i).get_type_id();
+        if (dim_type_id != strided_dim_type_id && dim_type_id != fixed_dim_type_id) {
+            return nd::array();
+        }
+    }
+    dimvector shape(ndim);
+    n.get_shape(shape.get());
+    intptr_t size = shape[0], inner_count = 1;
+    for (intptr_t i = 1; i < ndim; ++i) {
+        // Var dimensions report a negative size
+        if (shape[i] >= 0) {
+            inner_count *= shape[i];
+        }
+    }
+    if (size * inner_count < 2 * PARALLEL_EVAL_MIN_COUNT) {
+        return nd::array();
+    }
+
+    nd::array result = nd::empty_like(n, n.get_dtype().value_type());
+    dimvector src_strides(ndim), dst_strides(ndim);
+    n.get_strides(src_strides.get());
+    result.get_strides(dst_strides.get());
+    intptr_t src_stride = src_strides[0], dst_stride = dst_strides[0];
+    const char *src_el_metadata = n.get_ndo_meta();
+    const char *dst_el_metadata = result.get_ndo_meta();
+    ndt::type src_el_tp = n.get_type().at_single(0, &src_el_metadata);
+    ndt::type dst_el_tp = result.get_type().at_single(0, &dst_el_metadata);
+    const char *src_data = n.get_readonly_originptr();
+    char *dst_data = result.get_readwrite_originptr();
+
+    intptr_t min_chunk = max(PARALLEL_EVAL_MIN_COUNT / inner_count,
+                    (size + num_threads - 1) / num_threads);
+    parallel_for(size, min_chunk, [&](intptr_t begin, intptr_t end) {
+        assignment_strided_ckernel_builder k;
+        make_assignment_kernel(&k, 0, dst_el_tp, dst_el_metadata,
+                        src_el_tp, src_el_metadata,
+                        kernel_request_strided, assign_error_default,
+                        &eval::default_eval_context);
+        k(dst_data + begin * dst_stride, dst_stride,
+                        src_data + begin * src_stride, src_stride, end - begin);
+    }, num_threads);
+    return result;
+}
+
+dynd::nd::array pydynd::array_eval(const dynd::nd::array& n, int num_threads)
 {
+    if (num_threads < 0) {
+        throw runtime_error("the number of threads must be nonnegative");
+    } else if (num_threads == 0) {
+        num_threads = get_num_threads();
+    }
+    PyAllowThreads_RAII nogil;
+    nd::array result = parallel_eval(n, num_threads);
+    if (result.get_ndo() != NULL) {
+        return result;
+    }
     return n.eval();
 }
 
@@ -393,9 +493,43 @@ dynd::nd::array pydynd::array_eval_copy(const dynd::nd::array& n,
                 PyObject* access, const eval::eval_context *ectx)
 {
     uint32_t access_flags = pyarg_creation_access_flags(access);
+    PyAllowThreads_RAII nogil;
     return n.eval_copy(access_flags, ectx);
 }
 
+dynd::nd::array pydynd::array_groupby(const dynd::nd::array& data,
+                const dynd::nd::array& by, const dynd::ndt::type& groups)
+{
+    PyAllowThreads_RAII nogil;
+    return nd::groupby(data, by, groups);
+}
+
+dynd::nd::array pydynd::array_groupby(const dynd::nd::array& data,
+                const dynd::nd::array& by)
+{
+    PyAllowThreads_RAII nogil;
+    return nd::groupby(data, by);
+}
+
+dynd::nd::array pydynd::array_parse_json(const dynd::ndt::type& tp,
+                const dynd::nd::array& json)
+{
+    PyAllowThreads_RAII nogil;
+    return parse_json(tp, json);
+}
+
+void pydynd::array_parse_json(dynd::nd::array& out, const dynd::nd::array& json)
+{
+    PyAllowThreads_RAII nogil;
+    parse_json(out, json);
+}
+
+dynd::nd::array pydynd::array_format_json(const dynd::nd::array& n)
+{
+    PyAllowThreads_RAII nogil;
+    return format_json(n);
+}
+
 dynd::nd::array pydynd::array_zeros(const dynd::ndt::type& d, PyObject *access)
 {
     uint32_t access_flags = pyarg_creation_access_flags(access);
@@ -569,6 +703,26 @@ bool pydynd::array_contains(const dynd::nd::array& n, PyObject *x)
         return false;
     }
 
+    // For strided dimensions, loop directly so the search can stop at the first match
+    intptr_t dim_size = -1, stride = 0;
+    if (dt.get_type_id() == strided_dim_type_id) {
+        const strided_dim_type_metadata *md = reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+        dim_size = md->size;
+        stride = md->stride;
+    } else if (dt.get_type_id() == fixed_dim_type_id) {
+        const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(dt.extended());
+        dim_size = fdt->get_fixed_dim_size();
+        stride = fdt->get_fixed_stride();
+    }
+    if (dim_size >= 0) {
+        for (intptr_t i = 0; i < dim_size; ++i, data += stride) {
+            if (k(x_data, data)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     contains_data aux;
     aux.x_data = x_data;
     aux.k = &k;
@@ -623,10 +777,124 @@ static void pyobject_as_irange_array(intptr_t& out_size, shortvector<irange>& ou
     }
 }
 
+namespace {
+    inline bool pyint_as_intptr(PyObject *obj, intptr_t& out_value)
+    {
+#if PY_VERSION_HEX < 0x03000000
+        if (PyInt_CheckExact(obj)) {
+            out_value = PyInt_AS_LONG(obj);
+            return true;
+        }
+#endif
+        if (PyLong_CheckExact(obj)) {
+            out_value = PyLong_AsSsize_t(obj);
+            if (out_value == -1 && PyErr_Occurred()) {
+                // Let the general indexing code report the overflow
+                PyErr_Clear();
+                return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Resolves a subscript which is an integer, or a tuple of integers,
+     * by stepping through strided and fixed dimensions using the metadata
+     * directly, without building an irange array or an intermediate
+     * nd::array. Returns false if the subscript doesn't have that form or
+     * is out of bounds, in which case the general indexing code handles it.
+     */
+    bool resolve_integer_subscript(const nd::array& n, PyObject *subscript,
+                    const ndt::type *&out_tp, const char *&out_metadata, char *&out_data)
+    {
+        Py_ssize_t nindex = 1;
+        PyObject **indices = &subscript;
+        if (PyTuple_Check(subscript)) {
+            nindex = PyTuple_GET_SIZE(subscript);
+            indices = &PyTuple_GET_ITEM(subscript, 0);
+        }
+        if (nindex == 0 || nindex > (Py_ssize_t)n.get_ndim()) {
+            return false;
+        }
+
+        const ndt::type *tp = &n.get_type();
+        const char *metadata = n.get_ndo_meta();
+        char *data = n.get_ndo()->m_data_pointer;
+        for (Py_ssize_t k = 0; k < nindex; ++k) {
+            intptr_t i, dim_size, stride;
+            if (!pyint_as_intptr(indices[k], i)) {
+                return false;
+            }
+            switch (tp->get_type_id()) {
+                case strided_dim_type_id: {
+                    const strided_dim_type_metadata *md =
+                                    reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+                    dim_size = md->size;
+                    stride = md->stride;
+                    break;
+                }
+                case fixed_dim_type_id: {
+                    const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(tp->extended());
+                    dim_size = fdt->get_fixed_dim_size();
+                    stride = fdt->get_fixed_stride();
+                    break;
+                }
+                default:
+                    return false;
+            }
+            if (i < 0) {
+                i += dim_size;
+            }
+            if (i < 0 || i >= dim_size) {
+                return false;
+            }
+            const base_uniform_dim_type *budd = static_cast<const base_uniform_dim_type *>(tp->extended());
+            data += i * stride;
+            metadata += budd->get_element_metadata_offset();
+            tp = &budd->get_element_type();
+        }
+        out_tp = tp;
+        out_metadata = metadata;
+        out_data = data;
+        return true;
+    }
+
+    /**
+     * Makes an array viewing the element of 'n' at 'tp/metadata/data'.
+     */
+    nd::array make_element_view(const nd::array& n, const ndt::type& tp,
+                    const char *metadata, char *data)
+    {
+        nd::array result(make_array_memory_block(tp.get_metadata_size()));
+        result.get_ndo()->m_type = ndt::type(tp).release();
+        result.get_ndo()->m_data_pointer = data;
+        result.get_ndo()->m_data_reference = n.get_ndo()->m_data_reference;
+        if (result.get_ndo()->m_data_reference == NULL) {
+            result.get_ndo()->m_data_reference = n.get_memblock().get();
+        }
+        memory_block_incref(result.get_ndo()->m_data_reference);
+        result.get_ndo()->m_flags = n.get_ndo()->m_flags;
+        if (!tp.is_builtin() && tp.get_metadata_size() > 0) {
+            tp.extended()->metadata_copy_construct(result.get_ndo_meta(), metadata,
+                            n.get_memblock().get());
+        }
+        return result;
+    }
+} // anonymous namespace
+
 dynd::nd::array pydynd::array_getitem(const dynd::nd::array& n, PyObject *subscript)
 {
+    nd::array result;
+    const ndt::type *el_tp;
+    const char *el_metadata;
+    char *el_data;
     if (subscript == Py_Ellipsis) {
         return n.at_array(0, NULL);
+    } else if (resolve_integer_subscript(n, subscript, el_tp, el_metadata, el_data)) {
+        return make_element_view(n, *el_tp, el_metadata, el_data);
+    } else if (array_gather(n, subscript, result)) {
+        return result;
     } else {
         // Convert the pyobject into an array of iranges
         intptr_t size;
@@ -640,25 +908,17 @@ dynd::nd::array pydynd::array_getitem(const dynd::nd::array& n, PyObject *subscr
 
 void pydynd::array_setitem(const dynd::nd::array& n, PyObject *subscript, PyObject *value)
 {
+    const ndt::type *el_tp;
+    const char *el_metadata;
+    char *el_data;
     if (subscript == Py_Ellipsis) {
         array_broadcast_assign_from_py(n, value);
-#if PY_VERSION_HEX < 0x03000000
-    } else if (PyInt_Check(subscript)) {
-        long i = PyInt_AS_LONG(subscript);
-        const char *metadata = n.get_ndo_meta();
-        char *data = n.get_readwrite_originptr();
-        ndt::type d = n.get_type().at_single(i, &metadata, const_cast<const char **>(&data));
-        array_broadcast_assign_from_py(d, metadata, data, value);
-#endif // PY_VERSION_HEX < 0x03000000
-    } else if (PyLong_Check(subscript)) {
-        intptr_t i = PyLong_AsSsize_t(subscript);
-        if (i == -1 && PyErr_Occurred()) {
-            throw runtime_error("error converting int value");
-        }
-        const char *metadata = n.get_ndo_meta();
-        char *data = n.get_readwrite_originptr();
-        ndt::type d = n.get_type().at_single(i, &metadata, const_cast<const char **>(&data));
-        array_broadcast_assign_from_py(d, metadata, data, value);
+    } else if (resolve_integer_subscript(n, subscript, el_tp, el_metadata, el_data)) {
+        // Checks that the array is writable
+        n.get_readwrite_originptr();
+        array_broadcast_assign_from_py(*el_tp, el_metadata, el_data, value);
+    } else if (array_scatter(n, subscript, value)) {
+        return;
     } else {
         intptr_t size;
         shortvector<irange> indices;
@@ -667,6 +927,41 @@ void pydynd::array_setitem(const dynd::nd::array& n, PyObject *subscript, PyObje
     }
 }
 
+PyObject *pydynd::array_item(const dynd::nd::array& n, PyObject *args)
+{
+    const ndt::type *el_tp;
+    const char *el_metadata;
+    char *el_data;
+    Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+    if (nargs == 0) {
+        // Like NumPy, a.item() requires exactly one element
+        if (n.get_ndim() > 0) {
+            dimvector shape(n.get_ndim());
+            n.get_shape(shape.get());
+            for (size_t i = 0; i < n.get_ndim(); ++i) {
+                if (shape[i] != 1) {
+                    throw runtime_error("nd.array.item() with no arguments requires an array of size 1");
+                }
+            }
+            pyobject_ownref zeros(PyTuple_New(n.get_ndim()));
+            for (size_t i = 0; i < n.get_ndim(); ++i) {
+                PyTuple_SET_ITEM(zeros.get(), i, PyLong_FromLong(0));
+            }
+            return array_item(n, zeros.get());
+        }
+        return array_as_py(n);
+    }
+    PyObject *subscript = (nargs == 1) ? PyTuple_GET_ITEM(args, 0) : args;
+    if (resolve_integer_subscript(n, subscript, el_tp, el_metadata, el_data) &&
+                    !el_tp->is_expression()) {
+        // Checks that the array is readable
+        n.get_readonly_originptr();
+        return element_as_py(*el_tp, el_metadata, el_data);
+    } else {
+        return array_as_py(array_getitem(n, subscript));
+    }
+}
+
 nd::array pydynd::array_range(PyObject *start, PyObject *stop, PyObject *step, PyObject *dt)
 {
     nd::array start_nd, stop_nd, step_nd;
@@ -0,0 +1,273 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <Python.h>
+
+#include <vector>
+
+#include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
+#include <dynd/kernels/assignment_kernels.hpp>
+#include <dynd/memblock/array_memory_block.hpp>
+
+#include "array_gather_scatter.hpp"
+#include "array_functions.hpp"
+#include "array_from_py.hpp"
+#include "array_assign_from_py.hpp"
+#include "numpy_interop.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+#if defined(__GNUC__)
+# define PYDYND_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+# define PYDYND_PREFETCH(ptr)
+#endif
+
+// How many elements ahead the gather/scatter loops prefetch, and
+// the index count from which they start doing so
+static const intptr_t GATHER_PREFETCH_DISTANCE = 8;
+static const intptr_t GATHER_PREFETCH_MIN_COUNT = 4096;
+
+namespace {
+    /**
+     * The leading dimension of an array, as a pointer to its first
+     * element, a size and a stride, along with its element type.
+     */
+    struct leading_dim {
+        char *data;
+        intptr_t size, stride;
+        const ndt::type *el_tp;
+        const char *el_metadata;
+
+        leading_dim(const nd::array& n, char *origin) {
+            const ndt::type& tp = n.get_type();
+            const char *metadata = n.get_ndo_meta();
+            switch (tp.get_type_id()) {
+                case strided_dim_type_id: {
+                    const strided_dim_type_metadata *md =
+                                    reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+                    data = origin;
+                    size = md->size;
+                    stride = md->stride;
+                    break;
+                }
+                case fixed_dim_type_id: {
+                    const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(tp.extended());
+                    data = origin;
+                    size = fdt->get_fixed_dim_size();
+                    stride = fdt->get_fixed_stride();
+                    break;
+                }
+                case var_dim_type_id: {
+                    const var_dim_type_metadata *md =
+                                    reinterpret_cast<const var_dim_type_metadata *>(metadata);
+                    const var_dim_type_data *d = reinterpret_cast<const var_dim_type_data *>(origin);
+                    data = d->begin + md->offset;
+                    size = d->size;
+                    stride = md->stride;
+                    break;
+                }
+                default: {
+                    stringstream ss;
+                    ss << "cannot index dynd type " << tp << " with an array of integers or booleans";
+                    throw type_error(ss.str());
+                }
+            }
+            const base_uniform_dim_type *budd = static_cast<const base_uniform_dim_type *>(tp.extended());
+            el_tp = &budd->get_element_type();
+            el_metadata = metadata + budd->get_element_metadata_offset();
+        }
+    };
+
+    /**
+     * Converts 'subscript' into a one-dimensional array of integers or
+     * booleans, returning false if it isn't one.
+     */
+    bool subscript_as_index_array(PyObject *subscript, nd::array& out)
+    {
+        if (WArray_Check(subscript)) {
+            out = ((WArray *)subscript)->v;
+        } else if (PyList_Check(subscript)
+#if DYND_NUMPY_INTEROP
+                        || PyArray_Check(subscript)
+#endif // DYND_NUMPY_INTEROP
+                        ) {
+            out = array_from_py(subscript, 0, false);
+        } else {
+            return false;
+        }
+        if (out.get_ndim() != 1) {
+            return false;
+        }
+        switch (out.get_dtype().value_type().get_kind()) {
+            case bool_kind:
+            case int_kind:
+            case uint_kind:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Produces the list of element indices selected by 'idx'
+     * in a dimension of size 'dim_size'.
+     */
+    void get_selected_indices(const nd::array& idx, intptr_t dim_size,
+                    vector<intptr_t>& out_indices)
+    {
+        dimvector shape(1);
+        idx.get_shape(shape.get());
+        intptr_t count = shape[0];
+        if (idx.get_dtype().value_type().get_kind() == bool_kind) {
+            if (count != dim_size) {
+                stringstream ss;
+                ss << "boolean mask of size " << count;
+                ss << " does not match the indexed dimension of size " << dim_size;
+                throw broadcast_error(ss.str());
+            }
+            nd::array mask = nd::empty(count, ndt::make_type<dynd_bool>());
+            mask.vals() = idx;
+            const dynd_bool *m = reinterpret_cast<const dynd_bool *>(mask.get_readonly_originptr());
+            out_indices.clear();
+            for (intptr_t i = 0; i < count; ++i) {
+                if (m[i]) {
+                    out_indices.push_back(i);
+                }
+            }
+        } else {
+            nd::array ints = nd::empty(count, ndt::make_type<intptr_t>());
+            ints.vals() = idx;
+            const intptr_t *v = reinterpret_cast<const intptr_t *>(ints.get_readonly_originptr());
+            out_indices.resize(count);
+            for (intptr_t i = 0; i < count; ++i) {
+                intptr_t j = v[i];
+                if (j < 0) {
+                    j += dim_size;
+                }
+                if (j < 0 || j >= dim_size) {
+                    throw index_out_of_bounds(v[i], dim_size);
+                }
+                out_indices[i] = j;
+            }
+        }
+    }
+
+    /**
+     * Allocates an array like 'n', but with a strided leading dimension
+     * of size 'count' and a canonical element type.
+     */
+    nd::array make_selection_array(const nd::array& n, const ndt::type& el_tp, intptr_t count)
+    {
+        ndt::type tp = ndt::make_strided_dim(el_tp.get_canonical_type());
+        size_t ndim = n.get_ndim();
+        dimvector shape(ndim);
+        n.get_shape(shape.get());
+        shape[0] = count;
+        nd::array result(make_array_memory_block(tp, (int)ndim, shape.get()));
+        result.get_ndo()->m_flags = nd::read_access_flag | nd::write_access_flag;
+        return result;
+    }
+
+    /**
+     * Copies elements through a single-element assignment kernel, with
+     * either the source or the destination addressed by index.
+     */
+    template<bool Gather>
+    void indexed_copy(ckernel_prefix *kdp, char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    const intptr_t *indices, intptr_t count)
+    {
+        unary_single_operation_t fn = kdp->get_function<unary_single_operation_t>();
+        intptr_t i = 0;
+        if (count >= GATHER_PREFETCH_MIN_COUNT) {
+            // Large index sets are typically random access, so
+            // prefetch the indexed elements a few iterations ahead
+            for (; i < count - GATHER_PREFETCH_DISTANCE; ++i) {
+                intptr_t ahead = indices[i + GATHER_PREFETCH_DISTANCE];
+                if (Gather) {
+                    PYDYND_PREFETCH(src + ahead * src_stride);
+                    fn(dst + i * dst_stride, src + indices[i] * src_stride, kdp);
+                } else {
+                    PYDYND_PREFETCH(dst + ahead * dst_stride);
+                    fn(dst + indices[i] * dst_stride, src + i * src_stride, kdp);
+                }
+            }
+        }
+        for (; i < count; ++i) {
+            if (Gather) {
+                fn(dst + i * dst_stride, src + indices[i] * src_stride, kdp);
+            } else {
+                fn(dst + indices[i] * dst_stride, src + i * src_stride, kdp);
+            }
+        }
+    }
+} // anonymous namespace
+
+bool pydynd::array_gather(const dynd::nd::array& n, PyObject *subscript,
+                dynd::nd::array& out_result)
+{
+    nd::array idx;
+    if (n.get_ndim() == 0 || !subscript_as_index_array(subscript, idx)) {
+        return false;
+    }
+    leading_dim src(n, const_cast<char *>(n.get_readonly_originptr()));
+    vector<intptr_t> indices;
+    get_selected_indices(idx, src.size, indices);
+    intptr_t count = (intptr_t)indices.size();
+
+    nd::array result = make_selection_array(n, *src.el_tp, count);
+    const strided_dim_type_metadata *dst_md =
+                    reinterpret_cast<const strided_dim_type_metadata *>(result.get_ndo_meta());
+    const char *dst_el_metadata = result.get_ndo_meta() + sizeof(strided_dim_type_metadata);
+    const ndt::type& dst_el_tp =
+                    static_cast<const strided_dim_type *>(result.get_type().extended())->get_element_type();
+
+    if (count > 0) {
+        assignment_ckernel_builder k;
+        make_assignment_kernel(&k, 0, dst_el_tp, dst_el_metadata,
+                        *src.el_tp, src.el_metadata, kernel_request_single,
+                        assign_error_default, &eval::default_eval_context);
+        indexed_copy<true>(k.get(), result.get_readwrite_originptr(), dst_md->stride,
+                        src.data, src.stride, &indices[0], count);
+    }
+    out_result = result;
+    return true;
+}
+
+bool pydynd::array_scatter(const dynd::nd::array& n, PyObject *subscript, PyObject *value)
+{
+    nd::array idx;
+    if (n.get_ndim() == 0 || !subscript_as_index_array(subscript, idx)) {
+        return false;
+    }
+    leading_dim dst(n, n.get_readwrite_originptr());
+    vector<intptr_t> indices;
+    get_selected_indices(idx, dst.size, indices);
+    intptr_t count = (intptr_t)indices.size();
+
+    // Convert the value to the selection's shape, then scatter it
+    nd::array values = make_selection_array(n, *dst.el_tp, count);
+    array_broadcast_assign_from_py(values, value);
+    const strided_dim_type_metadata *src_md =
+                    reinterpret_cast<const strided_dim_type_metadata *>(values.get_ndo_meta());
+    const char *src_el_metadata = values.get_ndo_meta() + sizeof(strided_dim_type_metadata);
+    const ndt::type& src_el_tp =
+                    static_cast<const strided_dim_type *>(values.get_type().extended())->get_element_type();
+
+    if (count > 0) {
+        assignment_ckernel_builder k;
+        make_assignment_kernel(&k, 0, *dst.el_tp, dst.el_metadata,
+                        src_el_tp, src_el_metadata, kernel_request_single,
+                        assign_error_default, &eval::default_eval_context);
+        indexed_copy<false>(k.get(), dst.data, dst.stride,
+                        values.get_readonly_originptr(), src_md->stride, &indices[0], count);
+    }
+    return true;
+}
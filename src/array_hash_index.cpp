@@ -0,0 +1,298 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <Python.h>
+#include <datetime.h>
+
+#include "array_hash_index.hpp"
+#include "array_functions.hpp"
+#include "array_from_py.hpp"
+#include "utility_functions.hpp"
+
+#include <dynd/types/string_type.hpp>
+#include <dynd/types/date_type.hpp>
+#include <dynd/types/strided_dim_type.hpp>
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+// Initialize the pydatetime API
+namespace {
+struct init_pydatetime {
+    init_pydatetime() {
+        PyDateTime_IMPORT;
+    }
+};
+init_pydatetime pdt;
+} // anonymous namespace
+
+static ndt::type canonical_key_type(array_hash_index::key_kind_t kind)
+{
+    switch (kind) {
+        case array_hash_index::int_keys:
+            return ndt::make_type<int64_t>();
+        case array_hash_index::string_keys:
+            return ndt::make_string(string_encoding_utf_8);
+        case array_hash_index::date_keys:
+            return ndt::make_date();
+    }
+    throw runtime_error("internal error: unrecognized array_hash_index key kind");
+}
+
+bool array_hash_index::get_key_kind(const ndt::type& tp, key_kind_t& out_kind)
+{
+    switch (tp.get_type_id()) {
+        case int8_type_id:
+        case int16_type_id:
+        case int32_type_id:
+        case int64_type_id:
+        case uint8_type_id:
+        case uint16_type_id:
+        case uint32_type_id:
+            out_kind = int_keys;
+            return true;
+        case string_type_id:
+        case fixedstring_type_id:
+            out_kind = string_keys;
+            return true;
+        case date_type_id:
+            out_kind = date_keys;
+            return true;
+        default:
+            return false;
+    }
+}
+
+array_hash_index::array_hash_index(const nd::array& n)
+    : m_array(n)
+{
+    if (n.get_ndim() != 1) {
+        stringstream ss;
+        ss << "can only build a hash index of a one-dimensional array, not of type " << n.get_type();
+        throw type_error(ss.str());
+    }
+    if (!get_key_kind(n.get_dtype().value_type(), m_key_kind)) {
+        stringstream ss;
+        ss << "cannot build a hash index of elements of type " << n.get_dtype();
+        throw type_error(ss.str());
+    }
+
+    // Copy the values into a contiguous array of the canonical type
+    dimvector shape(1);
+    n.get_shape(shape.get());
+    nd::array tmp = nd::empty(shape[0], canonical_key_type(m_key_kind));
+    tmp.vals() = n;
+    const char *data = tmp.get_readonly_originptr();
+    intptr_t size = shape[0];
+    intptr_t stride = reinterpret_cast<const strided_dim_type_metadata *>(tmp.get_ndo_meta())->stride;
+
+    switch (m_key_kind) {
+        case int_keys:
+            m_int_keys.rehash(size);
+            for (intptr_t i = 0; i < size; ++i, data += stride) {
+                m_int_keys.insert(*reinterpret_cast<const int64_t *>(data));
+            }
+            break;
+        case string_keys:
+            m_string_keys.rehash(size);
+            for (intptr_t i = 0; i < size; ++i, data += stride) {
+                const string_type_data *d = reinterpret_cast<const string_type_data *>(data);
+                m_string_keys.insert(string(d->begin, d->end));
+            }
+            break;
+        case date_keys:
+            m_int_keys.rehash(size);
+            for (intptr_t i = 0; i < size; ++i, data += stride) {
+                m_int_keys.insert(*reinterpret_cast<const int32_t *>(data));
+            }
+            break;
+    }
+}
+
+int array_hash_index::contains(PyObject *x) const
+{
+    switch (m_key_kind) {
+        case int_keys: {
+            // Booleans and floats go through the generic comparison
+            if (PyBool_Check(x) || !PyIndex_Check(x)) {
+                return -1;
+            }
+            pyobject_ownref idx(PyNumber_Index(x));
+            int overflow = 0;
+            PY_LONG_LONG value = PyLong_AsLongLongAndOverflow(idx.get(), &overflow);
+            if (overflow != 0) {
+                // Too big to be any of the values
+                return 0;
+            }
+            if (value == -1 && PyErr_Occurred()) {
+                throw exception();
+            }
+            return m_int_keys.count(value) ? 1 : 0;
+        }
+        case string_keys:
+#if PY_VERSION_HEX < 0x03000000
+            if (!PyUnicode_Check(x) && !PyString_Check(x)) {
+#else
+            if (!PyUnicode_Check(x)) {
+#endif
+                return -1;
+            }
+            return m_string_keys.count(pystring_as_string(x)) ? 1 : 0;
+        case date_keys: {
+            if (!PyDate_Check(x) || PyDateTime_Check(x)) {
+                return -1;
+            }
+            nd::array d = array_from_py(x, 0, false);
+            if (d.get_type().get_type_id() != date_type_id) {
+                return -1;
+            }
+            int32_t days = *reinterpret_cast<const int32_t *>(d.get_readonly_originptr());
+            return m_int_keys.count(days) ? 1 : 0;
+        }
+    }
+    return -1;
+}
+
+nd::array array_hash_index::isin(const nd::array& a) const
+{
+    size_t ndim = a.get_ndim();
+    dimvector shape(ndim);
+    a.get_shape(shape.get());
+    intptr_t count = 1;
+    for (size_t i = 0; i < ndim; ++i) {
+        if (shape[i] < 0) {
+            stringstream ss;
+            ss << "nd.isin requires an array with strided or fixed dimensions, not " << a.get_type();
+            throw type_error(ss.str());
+        }
+        count *= shape[i];
+    }
+
+    nd::array result = nd::make_strided_array(ndt::make_type<dynd_bool>(), (int)ndim, shape.get(),
+                    nd::read_access_flag|nd::write_access_flag, NULL);
+    dynd_bool *out = reinterpret_cast<dynd_bool *>(result.get_readwrite_originptr());
+
+    key_kind_t a_kind;
+    if (!get_key_kind(a.get_dtype().value_type(), a_kind)) {
+        stringstream ss;
+        ss << "nd.isin does not support elements of type " << a.get_dtype();
+        throw type_error(ss.str());
+    }
+    if (a_kind != m_key_kind) {
+        // Values of a different kind never compare equal
+        memset(out, 0, count * sizeof(dynd_bool));
+        return result;
+    }
+
+    // Copy 'a' into a C-contiguous array of the canonical type
+    ndt::type key_tp = canonical_key_type(m_key_kind);
+    nd::array tmp = nd::make_strided_array(key_tp, (int)ndim, shape.get(),
+                    nd::read_access_flag|nd::write_access_flag, NULL);
+    tmp.vals() = a;
+    const char *data = tmp.get_readonly_originptr();
+
+    switch (m_key_kind) {
+        case int_keys: {
+            const int64_t *values = reinterpret_cast<const int64_t *>(data);
+            for (intptr_t i = 0; i < count; ++i) {
+                out[i] = m_int_keys.count(values[i]) != 0;
+            }
+            break;
+        }
+        case string_keys: {
+            const string_type_data *values = reinterpret_cast<const string_type_data *>(data);
+            string key;
+            for (intptr_t i = 0; i < count; ++i) {
+                key.assign(values[i].begin, values[i].end);
+                out[i] = m_string_keys.count(key) != 0;
+            }
+            break;
+        }
+        case date_keys: {
+            const int32_t *values = reinterpret_cast<const int32_t *>(data);
+            for (intptr_t i = 0; i < count; ++i) {
+                out[i] = m_int_keys.count(values[i]) != 0;
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+static bool can_auto_index(const nd::array& n)
+{
+    if (n.get_ndo() == NULL || n.get_ndim() != 1 ||
+                    (n.get_access_flags() & nd::immutable_access_flag) == 0) {
+        return false;
+    }
+    array_hash_index::key_kind_t kind;
+    if (!array_hash_index::get_key_kind(n.get_dtype().value_type(), kind)) {
+        return false;
+    }
+    dimvector shape(1);
+    n.get_shape(shape.get());
+    return shape[0] >= array_hash_index_auto_min_size;
+}
+
+bool pydynd::warray_contains(PyObject *self, PyObject *x)
+{
+    WArray *w = (WArray *)self;
+    const nd::array& n = w->v;
+    if (w->index != NULL && w->index->get_array().get_ndo() != n.get_ndo()) {
+        delete w->index;
+        w->index = NULL;
+    }
+    if (w->index == NULL) {
+        if (!can_auto_index(n)) {
+            return array_contains(n, x);
+        }
+        w->index = new array_hash_index(n);
+    }
+    int found = w->index->contains(x);
+    return found >= 0 ? (found != 0) : array_contains(n, x);
+}
+
+array_hash_index *pydynd::build_array_hash_index(const nd::array& n)
+{
+    return new array_hash_index(n);
+}
+
+void pydynd::delete_array_hash_index(array_hash_index *index)
+{
+    delete index;
+}
+
+static inline void check_index(const array_hash_index *index)
+{
+    if (index == NULL) {
+        throw runtime_error("the array index is not initialized, use nd.build_index to create one");
+    }
+}
+
+bool pydynd::array_hash_index_contains(const array_hash_index *index, PyObject *x)
+{
+    check_index(index);
+    int found = index->contains(x);
+    return found >= 0 ? (found != 0) : array_contains(index->get_array(), x);
+}
+
+intptr_t pydynd::array_hash_index_size(const array_hash_index *index)
+{
+    check_index(index);
+    return index->size();
+}
+
+nd::array pydynd::array_hash_index_isin(const array_hash_index *index, const nd::array& a)
+{
+    check_index(index);
+    return index->isin(a);
+}
+
+nd::array pydynd::array_isin(const nd::array& a, PyObject *values)
+{
+    array_hash_index index(array_from_py(values, 0, false));
+    return index.isin(a);
+}
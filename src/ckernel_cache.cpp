@@ -0,0 +1,393 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "ckernel_cache.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+// The number of instantiated ckernels which are cached
+#define DYND_CKERNEL_CACHE_CAPACITY 256
+
+namespace {
+    /**
+     * An instantiated ckernel shared between the cache and the
+     * forwarding ckernels, freed when the last of them lets go.
+     */
+    struct shared_ckernel {
+        atomic<intptr_t> refcount;
+        ckernel_builder ckb;
+        // The metadata the ckernel was instantiated with, which
+        // it may hold pointers into
+        string metadata;
+
+        shared_ckernel() : refcount(1) {}
+    };
+
+    inline void shared_ckernel_incref(shared_ckernel *sck)
+    {
+        ++sck->refcount;
+    }
+
+    inline void shared_ckernel_decref(shared_ckernel *sck)
+    {
+        if (--sck->refcount == 0) {
+            delete sck;
+        }
+    }
+
+    /**
+     * Releases the references to evicted ckernels. Their destructors
+     * may acquire the GIL, so this is done after the cache's lock is
+     * released.
+     */
+    void release_evicted(vector<shared_ckernel *>& evicted)
+    {
+        for (size_t i = 0; i != evicted.size(); ++i) {
+            shared_ckernel_decref(evicted[i]);
+        }
+    }
+
+    /**
+     * A bounded LRU cache of instantiated ckernels. The key is the
+     * id of the cached ckernel_deferred, which is never reused, the
+     * id of the instantiating thread, the kernel request type, and
+     * the bytes of the metadata.
+     *
+     * ckernel_deferreds may be instantiated without the GIL, so the
+     * cache has its own lock. It is not held while instantiating,
+     * or while releasing evicted ckernels.
+     */
+    class ckernel_cache {
+        typedef pair<string, shared_ckernel *> entry;
+        typedef list<entry> list_type;
+        typedef map<string, list_type::iterator> map_type;
+
+        mutex m_mutex;
+        list_type m_entries;
+        map_type m_index;
+        size_t m_capacity;
+        size_t m_hits, m_misses, m_bypasses;
+
+        // Non-copyable
+        ckernel_cache(const ckernel_cache&);
+        ckernel_cache& operator=(const ckernel_cache&);
+
+        void pop_back(vector<shared_ckernel *>& out_evicted)
+        {
+            m_index.erase(m_entries.back().first);
+            out_evicted.push_back(m_entries.back().second);
+            m_entries.pop_back();
+        }
+    public:
+        explicit ckernel_cache(size_t capacity)
+            : m_capacity(capacity), m_hits(0), m_misses(0), m_bypasses(0)
+        {
+        }
+
+        /**
+         * Returns a new reference to the cached ckernel for 'key',
+         * or NULL after counting a miss.
+         */
+        shared_ckernel *find(const string& key)
+        {
+            lock_guard<mutex> lock(m_mutex);
+            map_type::iterator it = m_index.find(key);
+            if (it == m_index.end()) {
+                ++m_misses;
+                return NULL;
+            }
+            ++m_hits;
+            // Move the entry to the front as the most recently used
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            shared_ckernel_incref(it->second->second);
+            return it->second->second;
+        }
+
+        /**
+         * Adds 'sck' for 'key', taking a new reference to it. If another
+         * thread added the key first, the existing entry is kept.
+         */
+        void insert(const string& key, shared_ckernel *sck)
+        {
+            vector<shared_ckernel *> evicted;
+            {
+                lock_guard<mutex> lock(m_mutex);
+                if (m_index.find(key) != m_index.end()) {
+                    return;
+                }
+                shared_ckernel_incref(sck);
+                m_entries.push_front(entry(key, sck));
+                m_index[key] = m_entries.begin();
+                while (m_entries.size() > m_capacity) {
+                    pop_back(evicted);
+                }
+            }
+            release_evicted(evicted);
+        }
+
+        /**
+         * Removes all the entries whose keys start with 'prefix'.
+         */
+        void erase_prefix(const string& prefix)
+        {
+            vector<shared_ckernel *> evicted;
+            {
+                lock_guard<mutex> lock(m_mutex);
+                map_type::iterator it = m_index.lower_bound(prefix);
+                while (it != m_index.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+                    evicted.push_back(it->second->second);
+                    m_entries.erase(it->second);
+                    m_index.erase(it++);
+                }
+            }
+            release_evicted(evicted);
+        }
+
+        void count_bypass()
+        {
+            lock_guard<mutex> lock(m_mutex);
+            ++m_bypasses;
+        }
+
+        void clear()
+        {
+            vector<shared_ckernel *> evicted;
+            {
+                lock_guard<mutex> lock(m_mutex);
+                while (!m_entries.empty()) {
+                    pop_back(evicted);
+                }
+                m_hits = 0;
+                m_misses = 0;
+                m_bypasses = 0;
+            }
+            release_evicted(evicted);
+        }
+
+        void get_stats(size_t& out_hits, size_t& out_misses, size_t& out_bypasses, size_t& out_size)
+        {
+            lock_guard<mutex> lock(m_mutex);
+            out_hits = m_hits;
+            out_misses = m_misses;
+            out_bypasses = m_bypasses;
+            out_size = m_entries.size();
+        }
+
+        size_t get_capacity() const {
+            return m_capacity;
+        }
+    };
+
+    ckernel_cache instantiation_cache(DYND_CKERNEL_CACHE_CAPACITY);
+    atomic<uint64_t> next_cached_ckd_id(0);
+    atomic<uint64_t> next_thread_id(0);
+
+    /**
+     * Returns an id for the calling thread, which is never reused
+     * by another thread.
+     */
+    uint64_t get_thread_id()
+    {
+        static thread_local uint64_t id = next_thread_id++;
+        return id;
+    }
+
+    struct cached_deferred_data {
+        nd::array ckd;
+        // The prefix of this ckernel_deferred's cache keys
+        string key_prefix;
+    };
+
+    void delete_cached_deferred_data(void *self_data_ptr)
+    {
+        cached_deferred_data *data = reinterpret_cast<cached_deferred_data *>(self_data_ptr);
+        // Nothing else can instantiate these entries
+        instantiation_cache.erase_prefix(data->key_prefix);
+        delete data;
+    }
+
+    struct forwarding_ckernel {
+        ckernel_prefix base;
+        shared_ckernel *sck;
+    };
+
+    void delete_forwarding_ckernel(ckernel_prefix *self_data_ptr)
+    {
+        shared_ckernel_decref(reinterpret_cast<forwarding_ckernel *>(self_data_ptr)->sck);
+    }
+
+    void forward_unary_single(char *dst, const char *src, ckernel_prefix *ckp)
+    {
+        ckernel_prefix *child = reinterpret_cast<forwarding_ckernel *>(ckp)->sck->ckb.get();
+        child->get_function<unary_single_operation_t>()(dst, src, child);
+    }
+
+    void forward_unary_strided(char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    size_t count, ckernel_prefix *ckp)
+    {
+        ckernel_prefix *child = reinterpret_cast<forwarding_ckernel *>(ckp)->sck->ckb.get();
+        child->get_function<unary_strided_operation_t>()(dst, dst_stride, src, src_stride, count, child);
+    }
+
+    void forward_expr_single(char *dst, const char * const *src, ckernel_prefix *ckp)
+    {
+        ckernel_prefix *child = reinterpret_cast<forwarding_ckernel *>(ckp)->sck->ckb.get();
+        child->get_function<expr_single_operation_t>()(dst, src, child);
+    }
+
+    void forward_expr_strided(char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride,
+                    size_t count, ckernel_prefix *ckp)
+    {
+        ckernel_prefix *child = reinterpret_cast<forwarding_ckernel *>(ckp)->sck->ckb.get();
+        child->get_function<expr_strided_operation_t>()(dst, dst_stride, src, src_stride, count, child);
+    }
+
+    /**
+     * Returns true if the metadata of 'tp' is only sizes and strides,
+     * so that its bytes fully describe the layout.
+     */
+    bool has_plain_metadata(const ndt::type& tp)
+    {
+        const ndt::type *t = &tp;
+        while (t->get_type_id() == strided_dim_type_id || t->get_type_id() == fixed_dim_type_id) {
+            t = &static_cast<const base_uniform_dim_type *>(t->extended())->get_element_type();
+        }
+        return t->get_metadata_size() == 0;
+    }
+
+    intptr_t instantiate_cached(void *self_data_ptr,
+                    dynd::ckernel_builder *out_ckb, intptr_t ckb_offset,
+                    const char *const* dynd_metadata, uint32_t kerntype)
+    {
+        cached_deferred_data *data = reinterpret_cast<cached_deferred_data *>(self_data_ptr);
+        const ckernel_deferred *ckd =
+                        reinterpret_cast<const ckernel_deferred *>(data->ckd.get_readonly_originptr());
+        intptr_t nargs = ckd->data_types_size;
+
+        // Build the key, checking that the metadata can be part of it.
+        // Kernels like fused or buffered elwise_map ones use their own
+        // data as scratch space while running, so each thread gets
+        // its own instances
+        string key = data->key_prefix;
+        uint64_t thread_id = get_thread_id();
+        key.append(reinterpret_cast<const char *>(&thread_id), sizeof(thread_id));
+        key.append(reinterpret_cast<const char *>(&kerntype), sizeof(kerntype));
+        size_t metadata_start = key.size();
+        vector<size_t> metadata_offsets(nargs);
+        for (intptr_t i = 0; i < nargs; ++i) {
+            const ndt::type& tp = ckd->data_dynd_types[i];
+            if (!has_plain_metadata(tp)) {
+                instantiation_cache.count_bypass();
+                return ckd->instantiate_func(ckd->data_ptr, out_ckb, ckb_offset,
+                                dynd_metadata, kerntype);
+            }
+            metadata_offsets[i] = key.size() - metadata_start;
+            if (tp.get_metadata_size() > 0) {
+                key.append(dynd_metadata[i], tp.get_metadata_size());
+            }
+        }
+
+        shared_ckernel *sck = instantiation_cache.find(key);
+        if (sck == NULL) {
+            sck = new shared_ckernel;
+            try {
+                // Instantiate with a copy of the metadata the cached
+                // ckernel owns, in case the ckernel points into it
+                sck->metadata = key.substr(metadata_start);
+                vector<const char *> child_metadata(nargs);
+                for (intptr_t i = 0; i < nargs; ++i) {
+                    child_metadata[i] = sck->metadata.data() + metadata_offsets[i];
+                }
+                ckd->instantiate_func(ckd->data_ptr, &sck->ckb, 0,
+                                nargs > 0 ? &child_metadata[0] : NULL, kerntype);
+                instantiation_cache.insert(key, sck);
+            } catch(...) {
+                shared_ckernel_decref(sck);
+                throw;
+            }
+        }
+
+        intptr_t ckb_end = ckb_offset + sizeof(forwarding_ckernel);
+        try {
+            out_ckb->ensure_capacity_leaf(ckb_end);
+        } catch(...) {
+            shared_ckernel_decref(sck);
+            throw;
+        }
+        forwarding_ckernel *e = out_ckb->get_at<forwarding_ckernel>(ckb_offset);
+        e->sck = sck;
+        e->base.destructor = &delete_forwarding_ckernel;
+        bool is_expr = (ckd->ckernel_funcproto == expr_operation_funcproto);
+        if (kerntype == kernel_request_single) {
+            if (is_expr) {
+                e->base.set_function<expr_single_operation_t>(&forward_expr_single);
+            } else {
+                e->base.set_function<unary_single_operation_t>(&forward_unary_single);
+            }
+        } else {
+            if (is_expr) {
+                e->base.set_function<expr_strided_operation_t>(&forward_expr_strided);
+            } else {
+                e->base.set_function<unary_strided_operation_t>(&forward_unary_strided);
+            }
+        }
+        return ckb_end;
+    }
+} // anonymous namespace
+
+void pydynd::make_cached_ckernel_deferred(ckernel_deferred *out_ckd, const nd::array& ckd)
+{
+    const ckernel_deferred *ckd_ptr = reinterpret_cast<const ckernel_deferred *>(ckd.get_readonly_originptr());
+    if (ckd_ptr->instantiate_func == NULL) {
+        throw runtime_error("cannot cache a NULL ckernel_deferred");
+    }
+    if (ckd_ptr->ckernel_funcproto != unary_operation_funcproto &&
+                    ckd_ptr->ckernel_funcproto != expr_operation_funcproto) {
+        throw type_error("only unary and expr ckernel_deferreds can be cached");
+    }
+    cached_deferred_data *data = new cached_deferred_data;
+    data->ckd = ckd;
+    uint64_t id = next_cached_ckd_id++;
+    data->key_prefix.assign(reinterpret_cast<const char *>(&id), sizeof(id));
+    out_ckd->data_ptr = data;
+    out_ckd->free_func = &delete_cached_deferred_data;
+    out_ckd->instantiate_func = &instantiate_cached;
+    out_ckd->ckernel_funcproto = ckd_ptr->ckernel_funcproto;
+    out_ckd->data_types_size = ckd_ptr->data_types_size;
+    // The types are owned by the wrapped ckernel_deferred, which 'data' holds on to
+    out_ckd->data_dynd_types = ckd_ptr->data_dynd_types;
+}
+
+PyObject *pydynd::ckernel_cache_info()
+{
+    size_t hits, misses, bypasses, size;
+    instantiation_cache.get_stats(hits, misses, bypasses, size);
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}",
+                    "hits", (Py_ssize_t)hits, "misses", (Py_ssize_t)misses,
+                    "bypasses", (Py_ssize_t)bypasses, "size", (Py_ssize_t)size,
+                    "capacity", (Py_ssize_t)instantiation_cache.get_capacity());
+}
+
+void pydynd::clear_ckernel_cache()
+{
+    instantiation_cache.clear();
+}
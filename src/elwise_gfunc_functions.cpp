@@ -6,114 +6,324 @@
 #include <Python.h>
 
 #include <algorithm>
+#include <sstream>
 
-#include <dynd/memblock/external_memory_block.hpp>
+#include <dynd/shape_tools.hpp>
+#include <dynd/shortvector.hpp>
+#include <dynd/typed_data_assign.hpp>
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/kernels/lift_ckernel_deferred.hpp>
+#include <dynd/types/ckernel_deferred_type.hpp>
+#include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/var_dim_type.hpp>
 
 #include "elwise_gfunc_functions.hpp"
 #include "array_functions.hpp"
+#include "array_from_py.hpp"
 #include "utility_functions.hpp"
-#include "ctypes_interop.hpp"
 
 using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
-static void create_elwise_gfunc_kernel_from_ctypes(dynd::codegen_cache& cgcache, PyCFuncPtrObject *cfunc, dynd::gfunc::elwise_kernel& out_kernel)
+// The number of argument type tuples each gfunc remembers
+#define DYND_ELWISE_GFUNC_DISPATCH_CACHE_CAPACITY 32
+
+static const ckernel_deferred *get_ckd(const nd::array& ckd)
 {
-#if 0 // TODO reenable
-    ndt::type& returntype = out_kernel.m_returntype;
-    vector<ndt::type> &paramtypes = out_kernel.m_paramtypes;
-    get_ctypes_signature(cfunc, returntype, paramtypes);
+    return reinterpret_cast<const ckernel_deferred *>(ckd.get_readonly_originptr());
+}
 
-    if (returntype.get_type_id() == void_type_id) {
-        // TODO: May want support for this later, e.g. for print or other output functions
-        throw std::runtime_error("Cannot construct a gfunc kernel from a ctypes function which returns void");
+void elwise_gfunc::add_kernel(PyObject *ckd_obj)
+{
+    const ckernel_deferred *ckd = pyarg_ckernel_deferred_ro(ckd_obj, "kernel");
+    if (ckd->instantiate_func == NULL) {
+        throw runtime_error("cannot add a NULL ckernel_deferred to a gfunc");
+    }
+    if (ckd->ckernel_funcproto != unary_operation_funcproto &&
+                    ckd->ckernel_funcproto != expr_operation_funcproto) {
+        stringstream ss;
+        ss << m_name << ": only unary and expr ckernel_deferreds can be gfunc kernels";
+        throw type_error(ss.str());
+    }
+    if (ckd->data_types_size < 2) {
+        stringstream ss;
+        ss << m_name << ": gfunc kernels must take at least one input";
+        throw type_error(ss.str());
     }
+    for (intptr_t i = 0; i < ckd->data_types_size; ++i) {
+        if (ckd->data_dynd_types[i].get_ndim() != 0) {
+            stringstream ss;
+            ss << m_name << ": gfunc kernels must be scalar, but got a kernel with type ";
+            ss << ckd->data_dynd_types[i];
+            throw type_error(ss.str());
+        }
+    }
+    m_kernels.push_back(((WArray *)ckd_obj)->v);
+    // A new kernel may change how argument types resolve
+    m_dispatch_cache.clear();
+}
 
-    memory_block_ptr ctypes_memblock = make_external_memory_block(cfunc, &py_decref_function);
-    Py_INCREF(cfunc);
+elwise_gfunc::dispatch_entry elwise_gfunc::resolve(const vector<ndt::type>& arg_types) const
+{
+    intptr_t nargs = (intptr_t)arg_types.size();
+    vector<ndt::type> arg_dtypes(nargs);
+    for (intptr_t i = 0; i < nargs; ++i) {
+        arg_dtypes[i] = arg_types[i].get_dtype().value_type();
+    }
 
-    if (paramtypes.size() == 1) {
-        cgcache.codegen_unary_function_adapter(returntype, paramtypes[0], get_ctypes_calling_convention(cfunc),
-                            *(void **)cfunc->b_ptr, ctypes_memblock.get(), out_kernel.m_unary_kernel);
-    } else if (paramtypes.size() == 2) {
-        cgcache.codegen_binary_function_adapter(returntype, paramtypes[0], paramtypes[1], get_ctypes_calling_convention(cfunc),
-                            *(void **)cfunc->b_ptr, ctypes_memblock.get(), out_kernel.m_binary_kernel);
-    } else {
-        std::stringstream ss;
-        ss << "gfunc kernels with " << paramtypes.size() << "parameters are not yet supported";
-        throw std::runtime_error(ss.str());
+    // Like NumPy's type resolution, an exact match wins, and
+    // otherwise the first kernel all the arguments convert
+    // to without loss is chosen
+    const nd::array *match = NULL;
+    for (size_t k = 0; k < m_kernels.size() && match == NULL; ++k) {
+        const ckernel_deferred *ckd = get_ckd(m_kernels[k]);
+        if (ckd->data_types_size != nargs + 1) {
+            continue;
+        }
+        intptr_t i = 0;
+        while (i < nargs && ckd->data_dynd_types[i + 1] == arg_dtypes[i]) {
+            ++i;
+        }
+        if (i == nargs) {
+            match = &m_kernels[k];
+        }
+    }
+    for (size_t k = 0; k < m_kernels.size() && match == NULL; ++k) {
+        const ckernel_deferred *ckd = get_ckd(m_kernels[k]);
+        if (ckd->data_types_size != nargs + 1) {
+            continue;
+        }
+        intptr_t i = 0;
+        while (i < nargs && is_lossless_assignment(ckd->data_dynd_types[i + 1], arg_dtypes[i])) {
+            ++i;
+        }
+        if (i == nargs) {
+            match = &m_kernels[k];
+        }
+    }
+    if (match == NULL) {
+        stringstream ss;
+        ss << m_name << ": could not find a gfunc kernel matching input argument types (";
+        for (intptr_t i = 0; i < nargs; ++i) {
+            ss << arg_dtypes[i];
+            if (i != nargs - 1) {
+                ss << ", ";
+            }
+        }
+        ss << ")";
+        throw type_error(ss.str());
     }
-#endif // TODO reenable
+
+    const ckernel_deferred *ckd = get_ckd(*match);
+    dispatch_entry e;
+    e.arg_types = arg_types;
+    e.convert_dtypes.resize(nargs);
+    for (intptr_t i = 0; i < nargs; ++i) {
+        // Expression dtypes get evaluated too
+        if (arg_types[i].get_dtype() != ckd->data_dynd_types[i + 1]) {
+            e.convert_dtypes[i] = ckd->data_dynd_types[i + 1];
+        }
+    }
+    e.dst_dtype = ckd->data_dynd_types[0];
+    e.ckd = *match;
+    return e;
 }
 
-void pydynd::elwise_gfunc_add_kernel(dynd::gfunc::elwise& gf, dynd::codegen_cache& cgcache, PyObject *kernel)
+elwise_gfunc::dispatch_entry elwise_gfunc::get_dispatch(const vector<ndt::type>& arg_types)
 {
-#if 0 // TODO reenable
-    if (PyObject_IsSubclass((PyObject *)Py_TYPE(kernel), ctypes.PyCFuncPtrType_Type)) {
-        gfunc::elwise_kernel egk;
-
-        create_elwise_gfunc_kernel_from_ctypes(cgcache, (PyCFuncPtrObject *)kernel, egk);
-        gf.add_kernel(egk);
+    list<dispatch_entry>::iterator it = m_dispatch_cache.begin(), it_end = m_dispatch_cache.end();
+    for (; it != it_end; ++it) {
+        if (it->arg_types == arg_types) {
+            ++m_hits;
+            // Move the entry to the front as the most recently used
+            m_dispatch_cache.splice(m_dispatch_cache.begin(), m_dispatch_cache, it);
+            return m_dispatch_cache.front();
+        }
+    }
+    ++m_misses;
+    m_dispatch_cache.push_front(resolve(arg_types));
+    if (m_dispatch_cache.size() > DYND_ELWISE_GFUNC_DISPATCH_CACHE_CAPACITY) {
+        m_dispatch_cache.pop_back();
+    }
+    return m_dispatch_cache.front();
+}
 
-        return;
+void elwise_gfunc::set_lifted(const vector<ndt::type>& arg_types,
+                const ndt::type& lifted_dst_type, const nd::array& lifted_ckd)
+{
+    list<dispatch_entry>::iterator it = m_dispatch_cache.begin(), it_end = m_dispatch_cache.end();
+    for (; it != it_end; ++it) {
+        if (it->arg_types == arg_types) {
+            it->lifted_dst_type = lifted_dst_type;
+            it->lifted_ckd = lifted_ckd;
+            return;
+        }
     }
+}
 
-    throw std::runtime_error("Object could not be used as a gfunc kernel");
-#endif // TODO reenable
+void elwise_gfunc::clear_dispatch_cache()
+{
+    m_dispatch_cache.clear();
+    m_hits = 0;
+    m_misses = 0;
 }
 
-PyObject *pydynd::elwise_gfunc_call(dynd::gfunc::elwise& gf, PyObject *args, PyObject *kwargs)
+PyObject *elwise_gfunc::dispatch_cache_info() const
 {
-#if 0 // TODO reenable
-    Py_ssize_t nargs = PySequence_Size(args);
+    return Py_BuildValue("{s:n,s:n,s:n,s:n}",
+                    "hits", (Py_ssize_t)m_hits, "misses", (Py_ssize_t)m_misses,
+                    "size", (Py_ssize_t)m_dispatch_cache.size(),
+                    "capacity", (Py_ssize_t)DYND_ELWISE_GFUNC_DISPATCH_CACHE_CAPACITY);
+}
 
-    // Convert the args into nd::arrays, and get the value types
+/**
+ * Allocates the output of a gfunc call, with the shape the
+ * arguments broadcast to.
+ */
+static nd::array make_broadcast_result(const ndt::type& dst_dtype, const vector<nd::array>& args)
+{
+    intptr_t undim = 0;
+    for (size_t i = 0; i != args.size(); ++i) {
+        undim = max(undim, (intptr_t)args[i].get_ndim());
+    }
+    dimvector result_shape(undim), tmp_shape(undim);
+    for (intptr_t j = 0; j != undim; ++j) {
+        result_shape[j] = 1;
+    }
+    for (size_t i = 0; i != args.size(); ++i) {
+        intptr_t undim_i = args[i].get_ndim();
+        if (undim_i > 0) {
+            args[i].get_shape(tmp_shape.get());
+            incremental_broadcast(undim, result_shape.get(), undim_i, tmp_shape.get());
+        }
+    }
+    bool has_var = false;
+    for (intptr_t j = 0; j != undim; ++j) {
+        has_var = has_var || (result_shape[j] < 0);
+    }
+    if (!has_var) {
+        return nd::make_strided_array(dst_dtype, undim, result_shape.get(),
+                        nd::read_access_flag|nd::write_access_flag, NULL);
+    }
+    // With var dimensions, the sizes known up front go in fixed
+    // dims, and the lifted kernel allocates the var dims
+    ndt::type result_tp = dst_dtype;
+    for (intptr_t j = undim - 1; j >= 0; --j) {
+        if (result_shape[j] < 0) {
+            result_tp = ndt::make_var_dim(result_tp);
+        } else {
+            result_tp = ndt::make_fixed_dim(result_shape[j], result_tp);
+        }
+    }
+    return nd::empty(result_tp);
+}
+
+PyObject *pydynd::elwise_gfunc_call(elwise_gfunc& gf, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t nargs = pysequence_size(args);
+
+    // Convert the args into nd::arrays, and get their types
     vector<nd::array> array_args(nargs);
-    vector<ndt::type> argtypes(nargs);
+    vector<ndt::type> arg_types(nargs);
     for (Py_ssize_t i = 0; i < nargs; ++i) {
         pyobject_ownref arg_obj(PySequence_GetItem(args, i));
-        array_init_from_pyobject(array_args[i], arg_obj);
-        argtypes[i] = array_args[i].get_type().value_type();
+        if (WArray_Check(arg_obj.get())) {
+            array_args[i] = ((WArray *)arg_obj.get())->v;
+        } else {
+            array_args[i] = array_from_py(arg_obj.get(), 0, false);
+        }
+        arg_types[i] = array_args[i].get_type();
     }
 
-    const gfunc::elwise_kernel *egk;
-    egk = gf.find_matching_kernel(argtypes);
+    PyObject *out_obj = NULL;
+    if (kwargs != NULL && kwargs != Py_None) {
+        out_obj = PyDict_GetItemString(kwargs, "out");
+        if (PyDict_Size(kwargs) != (out_obj != NULL ? 1 : 0)) {
+            stringstream ss;
+            ss << gf.get_name() << ": the only keyword argument accepted is 'out'";
+            throw runtime_error(ss.str());
+        }
+        if (out_obj == Py_None) {
+            out_obj = NULL;
+        }
+        if (out_obj != NULL && !WArray_Check(out_obj)) {
+            stringstream ss;
+            ss << gf.get_name() << ": 'out' must be an nd.array";
+            throw runtime_error(ss.str());
+        }
+    }
 
-    if (egk == NULL) {
-        std::stringstream ss;
-        ss << gf.get_name() << ": could not find a gfunc kernel matching input argument types (";
+    elwise_gfunc::dispatch_entry e = gf.get_dispatch(arg_types);
+    for (Py_ssize_t i = 0; i < nargs; ++i) {
+        if (e.convert_dtypes[i].get_type_id() != uninitialized_type_id) {
+            array_args[i] = array_args[i].ucast(e.convert_dtypes[i]).eval();
+        }
+    }
+
+    nd::array result;
+    if (out_obj != NULL) {
+        result = ((WArray *)out_obj)->v;
+    } else {
+        result = make_broadcast_result(e.dst_dtype, array_args);
+    }
+
+    // Lift the kernel to the argument dimensions, unless
+    // this entry was already lifted for this output type
+    if (e.lifted_ckd.is_empty() || e.lifted_dst_type != result.get_type()) {
+        vector<ndt::type> lifted_types(nargs + 1);
+        lifted_types[0] = result.get_type();
         for (Py_ssize_t i = 0; i < nargs; ++i) {
-            ss << argtypes[i];
-            if (i != nargs - 1) {
+            lifted_types[i + 1] = array_args[i].get_type();
+        }
+        nd::array lifted_ckd = nd::empty(ndt::make_ckernel_deferred());
+        lift_ckernel_deferred(reinterpret_cast<ckernel_deferred *>(lifted_ckd.get_readwrite_originptr()),
+                        e.ckd, lifted_types);
+        e.lifted_ckd = lifted_ckd;
+        e.lifted_dst_type = result.get_type();
+        gf.set_lifted(arg_types, e.lifted_dst_type, e.lifted_ckd);
+    }
+
+    // Instantiate the lifted kernel and call it
+    const ckernel_deferred *lifted = get_ckd(e.lifted_ckd);
+    shortvector<const char *> dynd_metadata(nargs + 1);
+    shortvector<const char *> src(nargs);
+    dynd_metadata[0] = result.get_ndo_meta();
+    for (Py_ssize_t i = 0; i < nargs; ++i) {
+        dynd_metadata[i + 1] = array_args[i].get_ndo_meta();
+        src[i] = array_args[i].get_readonly_originptr();
+    }
+    ckernel_builder ckb;
+    lifted->instantiate_func(lifted->data_ptr, &ckb, 0, dynd_metadata.get(), kernel_request_single);
+    ckernel_prefix *ckp = ckb.get();
+    if (lifted->ckernel_funcproto == expr_operation_funcproto) {
+        ckp->get_function<expr_single_operation_t>()(result.get_readwrite_originptr(),
+                        src.get(), ckp);
+    } else {
+        ckp->get_function<unary_single_operation_t>()(result.get_readwrite_originptr(),
+                        src[0], ckp);
+    }
+    return wrap_array(result);
+}
+
+std::string pydynd::elwise_gfunc_debug_print(const elwise_gfunc& gf)
+{
+    stringstream ss;
+    ss << "------ elwise_gfunc " << gf.get_name() << "\n";
+    const vector<nd::array>& kernels = gf.get_kernels();
+    for (size_t k = 0; k < kernels.size(); ++k) {
+        const ckernel_deferred *ckd = get_ckd(kernels[k]);
+        ss << " (";
+        for (intptr_t i = 1; i < ckd->data_types_size; ++i) {
+            ss << ckd->data_dynd_types[i];
+            if (i != ckd->data_types_size - 1) {
                 ss << ", ";
             }
         }
-        ss << ")";
-        throw std::runtime_error(ss.str());
-    }
-
-    PyErr_SetString(PyExc_TypeError, "pydynd::elwise_gfunc_call isn't implemented presently");
-    return NULL;
-    /*
-    if (nargs == 1) {
-        nd::array result(make_elwise_unary_kernel_node_copy_kernel(
-                    egk->m_returntype, array_args[0].get_node(), egk->m_unary_kernel));
-        pyobject_ownref result_obj(WArray_Type->tp_alloc(WArray_Type, 0));
-        ((WArray *)result_obj.get())->v.swap(result);
-        return result_obj.release();
-    } else if (nargs == 2) {
-        nd::array result(make_elwise_binary_kernel_node_copy_kernel(
-                    egk->m_returntype, array_args[0].get_node(), array_args[1].get_node(), egk->m_binary_kernel));
-        pyobject_ownref result_obj(WArray_Type->tp_alloc(WArray_Type, 0));
-        ((WArray *)result_obj.get())->v.swap(result);
-        return result_obj.release();
-    } else {
-        PyErr_SetString(PyExc_TypeError, "Elementwise gfuncs only support 1 or 2 arguments presently");
-        return NULL;
+        ss << ") -> " << ckd->data_dynd_types[0] << "\n";
     }
-    */
-#endif // TODO reenable
-        PyErr_SetString(PyExc_TypeError, "Elementwise gfuncs disabled presently");
-        return NULL;
+    ss << "------\n";
+    return ss.str();
 }
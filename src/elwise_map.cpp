@@ -6,25 +6,502 @@
 #include <Python.h>
 
 #include <iostream>
+#include <algorithm>
 
 #include <dynd/types/expr_type.hpp>
 #include <dynd/types/unary_expr_type.hpp>
 #include <dynd/types/strided_dim_type.hpp>
 #include <dynd/types/var_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
 #include <dynd/kernels/expr_kernel_generator.hpp>
 #include <dynd/kernels/elwise_expr_kernels.hpp>
 #include <dynd/shape_tools.hpp>
+#include <dynd/shortvector.hpp>
 
 #include "utility_functions.hpp"
 #include "elwise_map.hpp"
 #include "array_functions.hpp"
 #include "type_functions.hpp"
+#include "numpy_interop.hpp"
 
 using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
 namespace {
+    /**
+     * Puts the shell arrays in a tuple, for passing to the callable.
+     */
+    PyObject *make_args_tuple(WArray **ndo, size_t count)
+    {
+        pyobject_ownref args(PyTuple_New(count));
+        for (size_t i = 0; i != count; ++i) {
+            Py_INCREF(ndo[i]);
+            PyTuple_SET_ITEM(args.get(), i, (PyObject *)ndo[i]);
+        }
+        return args.release();
+    }
+
+    void throw_held_reference_error(size_t i, const char *what)
+    {
+        stringstream ss;
+        ss << "The elwise_map callable function held onto a reference to the " << what;
+        if (i == 0) {
+            ss << "dst";
+        } else {
+            ss << "src_" << i-1 << "";
+        }
+        ss << " argument, this is disallowed";
+        throw runtime_error(ss.str());
+    }
+
+    void verify_postcall_consistency(PyObject *res, WArray **ndo, size_t count)
+    {
+        // Verify that nothing was returned
+        if (res != Py_None) {
+            throw runtime_error("Python callable for elwise_map must not return a value, got an object");
+        }
+        // Verify that no reference to a temporary array was kept
+        for (size_t i = 0; i != count; ++i) {
+            if (Py_REFCNT(ndo[i]) != 1) {
+                throw_held_reference_error(i, "");
+            } else if (ndo[i]->v.get_ndo()->m_memblockdata.m_use_count != 1) {
+                throw_held_reference_error(i, "data underlying the ");
+            }
+        }
+    }
+
+#if DYND_NUMPY_INTEROP
+    /**
+     * Calls the callable with one-dimensional NumPy arrays which
+     * are zero-copy views of the strided runs of the operands. The
+     * views don't own their data, so the callable must not keep any
+     * reference to them. Operand 0 is the dst, which is writable.
+     */
+    void call_with_numpy_views(PyObject *callable, PyArray_Descr **descrs,
+                    size_t src_count, char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride,
+                    intptr_t count)
+    {
+        pyobject_ownref args(PyTuple_New(src_count + 1));
+        npy_intp dim = count;
+        for (size_t i = 0; i != src_count + 1; ++i) {
+            npy_intp stride = (i == 0) ? dst_stride : src_stride[i - 1];
+            char *data = (i == 0) ? dst : const_cast<char *>(src[i - 1]);
+            Py_INCREF(descrs[i]);
+            pyobject_ownref view(PyArray_NewFromDescr(&PyArray_Type, descrs[i],
+                            1, &dim, &stride, data,
+                            (i == 0) ? NPY_ARRAY_WRITEABLE : 0, NULL));
+            PyTuple_SET_ITEM(args.get(), i, view.release());
+        }
+        pyobject_ownref res(PyObject_Call(callable, args.get(), NULL));
+        // Verify that nothing was returned
+        if (res.get() != Py_None) {
+            throw runtime_error("Python callable for elwise_map must not return a value, got an object");
+        }
+        // Verify that no reference to a view, or a view of a view, was kept
+        for (size_t i = 0; i != src_count + 1; ++i) {
+            if (Py_REFCNT(args.get()) != 1 || Py_REFCNT(PyTuple_GET_ITEM(args.get(), i)) != 1) {
+                throw_held_reference_error(i, "");
+            }
+        }
+    }
+#endif // DYND_NUMPY_INTEROP
+
+    /**
+     * Creates the NumPy dtypes for the operands of a kernel which
+     * calls the callable with NumPy views.
+     */
+    void make_numpy_descrs(PyObject **out_descrs,
+                    const ndt::type& dst_tp, const char *dst_metadata,
+                    size_t src_count, const ndt::type *src_tp, const char **src_metadata)
+    {
+#if DYND_NUMPY_INTEROP
+        out_descrs[0] = (PyObject *)numpy_dtype_from_ndt_type(dst_tp, dst_metadata);
+        for (size_t i = 0; i != src_count; ++i) {
+            out_descrs[i + 1] = (PyObject *)numpy_dtype_from_ndt_type(src_tp[i], src_metadata[i]);
+        }
+#else
+        throw runtime_error("elwise_map with NumPy views requires NumPy interop");
+#endif
+    }
+
+    /**
+     * Creates a one-dimensional shell WArray, whose data pointer
+     * and strided_dim metadata are replaced for each call of a kernel.
+     */
+    WArray *make_shell_warray(const ndt::type& el_tp, const char *el_metadata,
+                    uint64_t access_flags)
+    {
+        ndt::type dt = ndt::make_strided_dim(el_tp);
+        nd::array n(make_array_memory_block(dt.get_metadata_size()));
+        n.get_ndo()->m_type = dt.release();
+        n.get_ndo()->m_flags = access_flags;
+        strided_dim_type_metadata *md =
+                        reinterpret_cast<strided_dim_type_metadata *>(n.get_ndo_meta());
+        md->size = 1;
+        md->stride = 0;
+        if (el_tp.get_metadata_size() > 0) {
+            el_tp.extended()->metadata_copy_construct(
+                            n.get_ndo_meta() + sizeof(strided_dim_type_metadata),
+                            el_metadata, NULL);
+        }
+        return (WArray *)wrap_array(DYND_MOVE(n));
+    }
+
+    /**
+     * Copies 'count' elements of size 'element_size' between
+     * strided runs.
+     */
+    inline void strided_copy(char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    intptr_t count, size_t element_size)
+    {
+        if (dst_stride == (intptr_t)element_size && src_stride == (intptr_t)element_size) {
+            memcpy(dst, src, count * element_size);
+        } else {
+            for (intptr_t i = 0; i < count; ++i,
+                            dst += dst_stride, src += src_stride) {
+                memcpy(dst, src, element_size);
+            }
+        }
+    }
+
+    /**
+     * Gets the shape and strides of the leading strided and fixed
+     * dimensions of 'tp', down to the element type 'el_tp'. Returns
+     * false if there's any other kind of dimension in the way.
+     */
+    bool get_leading_strided_dims(const ndt::type& tp, const char *metadata,
+                    const ndt::type& el_tp,
+                    vector<intptr_t>& out_shape, vector<intptr_t>& out_strides)
+    {
+        ndt::type t = tp;
+        while (t != el_tp) {
+            switch (t.get_type_id()) {
+                case strided_dim_type_id: {
+                    const strided_dim_type_metadata *md =
+                                    reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+                    out_shape.push_back(md->size);
+                    out_strides.push_back(md->stride);
+                    metadata += sizeof(strided_dim_type_metadata);
+                    break;
+                }
+                case fixed_dim_type_id: {
+                    const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(t.extended());
+                    out_shape.push_back(fdt->get_fixed_dim_size());
+                    out_strides.push_back(fdt->get_fixed_stride());
+                    break;
+                }
+                default:
+                    return false;
+            }
+            t = static_cast<const base_uniform_dim_type *>(t.extended())->get_element_type();
+        }
+        return true;
+    }
+
+    /**
+     * State of the buffered elwise_map kernel. Instead of calling
+     * the Python callable for every innermost strided run, it gathers
+     * the src elements of all the leading dimensions into contiguous
+     * staging buffers, calls the callable once per block of
+     * 'block_size' elements, and scatters the dst elements back.
+     *
+     * Operand 0 is the dst, operands 1 through src_count are the srcs.
+     */
+    struct buffered_expr_state {
+        struct dst_segment {
+            char *data;
+            intptr_t count;
+        };
+
+        size_t src_count;
+        intptr_t block_size;
+        PyObject *callable;
+        // The shape of the dst
+        vector<intptr_t> shape;
+        // The strides of each operand, broadcast to the dst shape
+        vector<vector<intptr_t> > strides;
+        vector<size_t> element_size;
+        vector<vector<char> > buffers;
+        vector<WArray *> shells;
+        // If not empty, the callable is given NumPy views of the
+        // staging buffers instead of the shells
+        vector<PyObject *> descrs;
+        // Where the dst elements of the block being gathered go
+        vector<dst_segment> pending;
+
+        buffered_expr_state()
+            : src_count(0), block_size(0), callable(NULL)
+        {
+        }
+
+        ~buffered_expr_state()
+        {
+            Py_XDECREF(callable);
+            for (size_t i = 0; i != shells.size(); ++i) {
+                Py_XDECREF(shells[i]);
+            }
+            for (size_t i = 0; i != descrs.size(); ++i) {
+                Py_XDECREF(descrs[i]);
+            }
+        }
+
+        void call_block(intptr_t count)
+        {
+            if (!descrs.empty()) {
+#if DYND_NUMPY_INTEROP
+                shortvector<const char *> src(src_count);
+                shortvector<intptr_t> src_stride(src_count);
+                for (size_t i = 0; i != src_count; ++i) {
+                    src[i] = &buffers[i + 1][0];
+                    src_stride[i] = element_size[i + 1];
+                }
+                call_with_numpy_views(callable, reinterpret_cast<PyArray_Descr **>(&descrs[0]),
+                                src_count, &buffers[0][0], element_size[0],
+                                src.get(), src_stride.get(), count);
+#endif
+            } else {
+                call_shells(count);
+            }
+
+            // Scatter the results back to the dst
+            intptr_t dst_stride = strides[0].back();
+            const char *buf = &buffers[0][0];
+            for (size_t j = 0; j != pending.size(); ++j) {
+                strided_copy(pending[j].data, dst_stride, buf, element_size[0],
+                                pending[j].count, element_size[0]);
+                buf += pending[j].count * element_size[0];
+            }
+            pending.clear();
+        }
+
+        void call_shells(intptr_t count)
+        {
+            for (size_t i = 0; i != src_count + 1; ++i) {
+                shells[i]->v.get_ndo()->m_data_pointer = &buffers[i][0];
+                strided_dim_type_metadata *md =
+                                reinterpret_cast<strided_dim_type_metadata *>(shells[i]->v.get_ndo_meta());
+                md->size = count;
+                md->stride = element_size[i];
+            }
+            pyobject_ownref args(make_args_tuple(&shells[0], src_count + 1));
+            pyobject_ownref res(PyObject_Call(callable, args.get(), NULL));
+            args.clear();
+            verify_postcall_consistency(res.get(), &shells[0], src_count + 1);
+        }
+
+        void run(char *dst, const char * const *src)
+        {
+            intptr_t ndim = (intptr_t)shape.size();
+            for (intptr_t j = 0; j != ndim; ++j) {
+                if (shape[j] == 0) {
+                    return;
+                }
+            }
+            // If the callable raises, forget the gathered segments
+            // so the next call doesn't scatter stale results to them
+            struct pending_guard {
+                vector<dst_segment>& segments;
+                ~pending_guard() {
+                    segments.clear();
+                }
+            } guard = {pending};
+            intptr_t inner_size = shape[ndim - 1];
+            vector<intptr_t> index(ndim - 1, 0);
+            vector<const char *> run_data(src_count + 1);
+            intptr_t filled = 0;
+            for (;;) {
+                // The start of the current innermost run of each operand
+                for (size_t i = 0; i != src_count + 1; ++i) {
+                    const char *data = (i == 0) ? dst : src[i - 1];
+                    for (intptr_t j = 0; j != ndim - 1; ++j) {
+                        data += index[j] * strides[i][j];
+                    }
+                    run_data[i] = data;
+                }
+                intptr_t done = 0;
+                while (done < inner_size) {
+                    intptr_t count = min(inner_size - done, block_size - filled);
+                    for (size_t i = 1; i != src_count + 1; ++i) {
+                        intptr_t stride = strides[i][ndim - 1];
+                        strided_copy(&buffers[i][0] + filled * element_size[i], element_size[i],
+                                        run_data[i] + done * stride, stride,
+                                        count, element_size[i]);
+                    }
+                    dst_segment seg;
+                    seg.data = const_cast<char *>(run_data[0]) + done * strides[0][ndim - 1];
+                    seg.count = count;
+                    pending.push_back(seg);
+                    filled += count;
+                    done += count;
+                    if (filled == block_size) {
+                        call_block(filled);
+                        filled = 0;
+                    }
+                }
+                // Advance to the next innermost run
+                intptr_t j = ndim - 2;
+                while (j >= 0 && ++index[j] == shape[j]) {
+                    index[j] = 0;
+                    --j;
+                }
+                if (j < 0) {
+                    break;
+                }
+            }
+            if (filled > 0) {
+                call_block(filled);
+            }
+        }
+    };
+
+    struct pyobject_buffered_expr_kernel_extra {
+        typedef pyobject_buffered_expr_kernel_extra extra_type;
+
+        ckernel_prefix base;
+        buffered_expr_state *state;
+
+        static void single_unary(char *dst, const char *src,
+                        ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            e->state->run(dst, &src);
+        }
+
+        static void single(char *dst, const char * const *src,
+                        ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            e->state->run(dst, src);
+        }
+
+        static void strided_unary(char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    size_t count, ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            for (size_t i = 0; i != count; ++i,
+                            dst += dst_stride, src += src_stride) {
+                e->state->run(dst, &src);
+            }
+        }
+
+        static void strided(char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride,
+                    size_t count, ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            size_t src_count = e->state->src_count;
+            shortvector<const char *> src_loop(src_count, src);
+            for (size_t i = 0; i != count; ++i, dst += dst_stride) {
+                e->state->run(dst, src_loop.get());
+                for (size_t j = 0; j != src_count; ++j) {
+                    src_loop[j] += src_stride[j];
+                }
+            }
+        }
+
+        static void destruct(ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            delete e->state;
+        }
+    };
+} // anonymous namespace
+
+namespace {
+    /**
+     * The elwise_map kernel which gives the callable NumPy views
+     * of the strided runs it's called with, instead of shell WArrays.
+     */
+    struct pyobject_numpy_expr_kernel_extra {
+        typedef pyobject_numpy_expr_kernel_extra extra_type;
+
+        ckernel_prefix base;
+        size_t src_count;
+        PyObject *callable;
+        // After this are 1 + src_count NumPy dtypes of the operands
+
+        inline void call(char *dst, intptr_t dst_stride,
+                        const char * const *src, const intptr_t *src_stride,
+                        size_t count)
+        {
+#if DYND_NUMPY_INTEROP
+            PyArray_Descr **descrs = reinterpret_cast<PyArray_Descr **>(this + 1);
+            call_with_numpy_views(callable, descrs, src_count, dst, dst_stride,
+                            src, src_stride, count);
+#endif
+        }
+
+        static void single_unary(char *dst, const char *src,
+                        ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            intptr_t src_stride = 0;
+            e->call(dst, 0, &src, &src_stride, 1);
+        }
+
+        static void single(char *dst, const char * const *src,
+                        ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            shortvector<intptr_t> src_stride(e->src_count);
+            for (size_t i = 0; i != e->src_count; ++i) {
+                src_stride[i] = 0;
+            }
+            e->call(dst, 0, src, src_stride.get(), 1);
+        }
+
+        static void strided_unary(char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    size_t count, ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            e->call(dst, dst_stride, &src, &src_stride, count);
+        }
+
+        static void strided(char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride,
+                    size_t count, ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            e->call(dst, dst_stride, src, src_stride, count);
+        }
+
+        static void destruct(ckernel_prefix *extra)
+        {
+            PyGILState_RAII pgs;
+
+            extra_type *e = reinterpret_cast<extra_type *>(extra);
+            PyObject **descrs = reinterpret_cast<PyObject **>(e + 1);
+            size_t src_count = e->src_count;
+            Py_XDECREF(e->callable);
+            for (size_t i = 0; i != src_count + 1; ++i) {
+                Py_XDECREF(descrs[i]);
+            }
+        }
+    };
+
     struct pyobject_expr_kernel_extra {
         typedef pyobject_expr_kernel_extra extra_type;
 
@@ -46,13 +523,7 @@ namespace {
                 ndo[i+1]->v.get_ndo()->m_data_pointer = const_cast<char *>(src[i]);
             }
 
-            // Put all the arrays in a tuple
-            pyobject_ownref args(PyTuple_New(src_count + 1));
-            for (size_t i = 0; i != src_count + 1; ++i) {
-                Py_INCREF(ndo[i]);
-                PyTuple_SET_ITEM(args.get(), i, (PyObject *)ndo[i]);
-            }
-            return args.release();
+            return make_args_tuple(ndo, src_count + 1);
         }
 
         inline PyObject *set_data_pointers(char *dst, intptr_t dst_stride,
@@ -73,46 +544,13 @@ namespace {
                 md->stride = src_stride[i];
             }
 
-            // Put all the arrays in a tuple
-            pyobject_ownref args(PyTuple_New(src_count + 1));
-            for (size_t i = 0; i != src_count + 1; ++i) {
-                Py_INCREF(ndo[i]);
-                PyTuple_SET_ITEM(args.get(), i, (PyObject *)ndo[i]);
-            }
-            return args.release();
+            return make_args_tuple(ndo, src_count + 1);
         }
 
         inline void verify_postcall_consistency(PyObject *res)
         {
             WArray **ndo = reinterpret_cast<WArray **>(this + 1);
-            // Verify that nothing was returned
-            if (res != Py_None) {
-                throw runtime_error("Python callable for elwise_map must not return a value, got an object");
-            }
-            // Verify that no reference to a temporary array was kept
-            for (size_t i = 0; i != src_count + 1; ++i) {
-                if (Py_REFCNT(ndo[i]) != 1) {
-                    stringstream ss;
-                    ss << "The elwise_map callable function held onto a reference to the ";
-                    if (i == 0) {
-                        ss << "dst";
-                    } else {
-                        ss << "src_" << i-1 << "";
-                    }
-                    ss << " argument, this is disallowed";
-                    throw runtime_error(ss.str());
-                } else if (ndo[i]->v.get_ndo()->m_memblockdata.m_use_count != 1) {
-                    stringstream ss;
-                    ss << "The elwise_map callable function held onto a reference to the data underlying the ";
-                    if (i == 0) {
-                        ss << "dst";
-                    } else {
-                        ss << "src_" << i-1 << "";
-                    }
-                    ss << " argument, this is disallowed";
-                    throw runtime_error(ss.str());
-                }
-            }
+            ::verify_postcall_consistency(res, ndo, src_count + 1);
         }
 
         static void single_unary(char *dst, const char *src,
@@ -190,23 +628,138 @@ class pyobject_elwise_expr_kernel_generator : public expr_kernel_generator {
     pyobject_ownref m_callable;
     ndt::type m_dst_tp;
     vector<ndt::type> m_src_tp;
+    // If nonzero, the number of elements per call of the buffered kernel
+    intptr_t m_block_size;
+    // If true, the callable gets NumPy views instead of dynd arrays
+    bool m_numpy_views;
+
+    /**
+     * Creates the state for a buffered kernel, or returns NULL if the
+     * dimensions aren't all strided or the element types don't support
+     * copying through staging buffers.
+     */
+    buffered_expr_state *make_buffered_state(
+                const ndt::type& dst_tp, const char *dst_metadata,
+                size_t src_count, const ndt::type *src_tp, const char **src_metadata) const
+    {
+        // The staging buffers are copied bytewise
+        if (!m_dst_tp.is_pod() || m_dst_tp.get_metadata_size() > 0) {
+            return NULL;
+        }
+        for (size_t i = 0; i != src_count; ++i) {
+            if (!m_src_tp[i].is_pod() || m_src_tp[i].get_metadata_size() > 0) {
+                return NULL;
+            }
+        }
+        vector<intptr_t> shape, dst_strides;
+        if (!get_leading_strided_dims(dst_tp, dst_metadata, m_dst_tp, shape, dst_strides) ||
+                        shape.empty()) {
+            return NULL;
+        }
+        intptr_t ndim = (intptr_t)shape.size();
+        vector<vector<intptr_t> > strides(src_count + 1);
+        strides[0].swap(dst_strides);
+        for (size_t i = 0; i != src_count; ++i) {
+            vector<intptr_t> src_shape, src_strides;
+            if (!get_leading_strided_dims(src_tp[i], src_metadata[i], m_src_tp[i],
+                            src_shape, src_strides) || (intptr_t)src_shape.size() > ndim) {
+                return NULL;
+            }
+            // Broadcast the src strides to the dst shape
+            intptr_t offset = ndim - (intptr_t)src_shape.size();
+            strides[i + 1].resize(ndim, 0);
+            for (intptr_t j = 0; j != (intptr_t)src_shape.size(); ++j) {
+                if (src_shape[j] == shape[j + offset]) {
+                    strides[i + 1][j + offset] = src_strides[j];
+                } else if (src_shape[j] != 1) {
+                    return NULL;
+                }
+            }
+        }
+
+        buffered_expr_state *st = new buffered_expr_state;
+        st->src_count = src_count;
+        st->block_size = m_block_size;
+        st->shape.swap(shape);
+        st->strides.swap(strides);
+        st->element_size.resize(src_count + 1);
+        st->buffers.resize(src_count + 1);
+        st->element_size[0] = m_dst_tp.get_data_size();
+        for (size_t i = 0; i != src_count; ++i) {
+            st->element_size[i + 1] = m_src_tp[i].get_data_size();
+        }
+        for (size_t i = 0; i != src_count + 1; ++i) {
+            st->buffers[i].resize(max<size_t>(1, m_block_size * st->element_size[i]));
+        }
+        return st;
+    }
+
+    size_t make_numpy_expr_kernel(
+                ckernel_builder *out, size_t offset_out,
+                const ndt::type& dst_tp, const char *dst_metadata,
+                size_t src_count, const ndt::type *src_tp, const char **src_metadata,
+                kernel_request_t kernreq) const
+    {
+        size_t extra_size = sizeof(pyobject_numpy_expr_kernel_extra) +
+                        (src_count + 1) * sizeof(PyObject *);
+        out->ensure_capacity_leaf(offset_out + extra_size);
+        pyobject_numpy_expr_kernel_extra *e = out->get_at<pyobject_numpy_expr_kernel_extra>(offset_out);
+        PyObject **descrs = reinterpret_cast<PyObject **>(e + 1);
+        switch (kernreq) {
+            case kernel_request_single:
+                if (src_count == 1) {
+                    e->base.set_function<unary_single_operation_t>(&pyobject_numpy_expr_kernel_extra::single_unary);
+                } else {
+                    e->base.set_function<expr_single_operation_t>(&pyobject_numpy_expr_kernel_extra::single);
+                }
+                break;
+            case kernel_request_strided:
+                if (src_count == 1) {
+                    e->base.set_function<unary_strided_operation_t>(&pyobject_numpy_expr_kernel_extra::strided_unary);
+                } else {
+                    e->base.set_function<expr_strided_operation_t>(&pyobject_numpy_expr_kernel_extra::strided);
+                }
+                break;
+            default: {
+                stringstream ss;
+                ss << "pyobject_elwise_expr_kernel_generator: unrecognized request " << (int)kernreq;
+                throw runtime_error(ss.str());
+            }
+        }
+        for (size_t i = 0; i != src_count + 1; ++i) {
+            descrs[i] = NULL;
+        }
+        e->base.destructor = &pyobject_numpy_expr_kernel_extra::destruct;
+        e->src_count = src_count;
+        e->callable = m_callable.get();
+        Py_INCREF(e->callable);
+        make_numpy_descrs(descrs, dst_tp, dst_metadata, src_count, src_tp, src_metadata);
+        return offset_out + extra_size;
+    }
 public:
     pyobject_elwise_expr_kernel_generator(PyObject *callable,
-                    const ndt::type& dst_tp, const std::vector<ndt::type>& src_tp)
+                    const ndt::type& dst_tp, const std::vector<ndt::type>& src_tp,
+                    intptr_t block_size = 0, bool numpy_views = false)
         : expr_kernel_generator(true), m_callable(callable, true),
-                        m_dst_tp(dst_tp), m_src_tp(src_tp)
+                        m_dst_tp(dst_tp), m_src_tp(src_tp), m_block_size(block_size),
+                        m_numpy_views(numpy_views)
     {
     }
 
     pyobject_elwise_expr_kernel_generator(PyObject *callable,
-                    const ndt::type& dst_tp, const ndt::type& src_tp)
+                    const ndt::type& dst_tp, const ndt::type& src_tp,
+                    bool numpy_views = false)
         : expr_kernel_generator(true), m_callable(callable, true),
-                        m_dst_tp(dst_tp), m_src_tp(1)
+                        m_dst_tp(dst_tp), m_src_tp(1), m_block_size(0),
+                        m_numpy_views(numpy_views)
     {
         m_src_tp[0] = src_tp;
     }
 
     virtual ~pyobject_elwise_expr_kernel_generator() {
+        // The last reference to the type may go away while the GIL is released
+        PyGILState_RAII pgs;
+        m_callable.clear();
     }
 
     size_t make_expr_kernel(
@@ -230,6 +783,68 @@ public:
                 }
             }
         }
+        // In buffered mode, handle all the leading dimensions at once
+        // if they're strided, so the callable sees large blocks
+        if (require_elwise && m_block_size > 0) {
+            PyGILState_RAII pgs;
+
+            buffered_expr_state *st = make_buffered_state(dst_tp, dst_metadata,
+                            src_count, src_tp, src_metadata);
+            if (st != NULL) {
+                size_t extra_size = sizeof(pyobject_buffered_expr_kernel_extra);
+                try {
+                    out->ensure_capacity_leaf(offset_out + extra_size);
+                } catch(...) {
+                    delete st;
+                    throw;
+                }
+                pyobject_buffered_expr_kernel_extra *e =
+                                out->get_at<pyobject_buffered_expr_kernel_extra>(offset_out);
+                e->state = st;
+                e->base.destructor = &pyobject_buffered_expr_kernel_extra::destruct;
+                st->callable = m_callable.get();
+                Py_INCREF(st->callable);
+                switch (kernreq) {
+                    case kernel_request_single:
+                        if (src_count == 1) {
+                            e->base.set_function<unary_single_operation_t>(
+                                            &pyobject_buffered_expr_kernel_extra::single_unary);
+                        } else {
+                            e->base.set_function<expr_single_operation_t>(
+                                            &pyobject_buffered_expr_kernel_extra::single);
+                        }
+                        break;
+                    case kernel_request_strided:
+                        if (src_count == 1) {
+                            e->base.set_function<unary_strided_operation_t>(
+                                            &pyobject_buffered_expr_kernel_extra::strided_unary);
+                        } else {
+                            e->base.set_function<expr_strided_operation_t>(
+                                            &pyobject_buffered_expr_kernel_extra::strided);
+                        }
+                        break;
+                    default: {
+                        stringstream ss;
+                        ss << "pyobject_elwise_expr_kernel_generator: unrecognized request " << (int)kernreq;
+                        throw runtime_error(ss.str());
+                    }
+                }
+                if (m_numpy_views) {
+                    st->descrs.resize(src_count + 1, NULL);
+                    vector<const char *> src_el_metadata(src_count, NULL);
+                    make_numpy_descrs(&st->descrs[0], m_dst_tp, NULL,
+                                    src_count, &m_src_tp[0], &src_el_metadata[0]);
+                } else {
+                    // Create the shell WArrays, pointed at the staging buffers for each call
+                    st->shells.push_back(make_shell_warray(m_dst_tp, NULL, nd::write_access_flag));
+                    for (size_t i = 0; i != src_count; ++i) {
+                        st->shells.push_back(make_shell_warray(m_src_tp[i], NULL, nd::read_access_flag));
+                    }
+                }
+                return offset_out + extra_size;
+            }
+        }
+
         // If the types don't match the ones for this generator,
         // call the elementwise dimension handler to handle one dimension
         // or handle input/output buffering, giving 'this' as the next
@@ -242,6 +857,15 @@ public:
                             this);
         }
 
+        // Kernels may be instantiated while the GIL is released,
+        // and creating the shell arrays uses the Python API
+        PyGILState_RAII pgs;
+
+        if (m_numpy_views) {
+            return make_numpy_expr_kernel(out, offset_out, dst_tp, dst_metadata,
+                            src_count, src_tp, src_metadata, kernreq);
+        }
+
         size_t extra_size = sizeof(pyobject_expr_kernel_extra) +
                         (src_count + 1) * sizeof(WArray *);
         out->ensure_capacity_leaf(offset_out + extra_size);
@@ -275,34 +899,9 @@ public:
         e->callable = m_callable.get();
         Py_INCREF(e->callable);
         // Create shell WArrays which are used to give the kernel data to Python
-        strided_dim_type_metadata *md;
-        ndt::type dt = ndt::make_strided_dim(dst_tp);
-        nd::array n(make_array_memory_block(dt.get_metadata_size()));
-        n.get_ndo()->m_type = dt.release();
-        n.get_ndo()->m_flags = nd::write_access_flag;
-        md = reinterpret_cast<strided_dim_type_metadata *>(n.get_ndo_meta());
-        md->size = 1;
-        md->stride = 0;
-        if (dst_tp.get_metadata_size() > 0) {
-            dst_tp.extended()->metadata_copy_construct(
-                            n.get_ndo_meta() + sizeof(strided_dim_type_metadata),
-                            dst_metadata, NULL);
-        }
-        ndo[0] = (WArray *)wrap_array(DYND_MOVE(n));
+        ndo[0] = make_shell_warray(dst_tp, dst_metadata, nd::write_access_flag);
         for (size_t i = 0; i != src_count; ++i) {
-            dt = ndt::make_strided_dim(src_tp[i]);
-            n.set(make_array_memory_block(dt.get_metadata_size()));
-            n.get_ndo()->m_type = dt.release();
-            n.get_ndo()->m_flags = nd::read_access_flag;
-            md = reinterpret_cast<strided_dim_type_metadata *>(n.get_ndo_meta());
-            md->size = 1;
-            md->stride = 0;
-            if (src_tp[i].get_metadata_size() > 0) {
-                src_tp[i].extended()->metadata_copy_construct(
-                                n.get_ndo_meta() + sizeof(strided_dim_type_metadata),
-                                src_metadata[i], NULL);
-            }
-            ndo[i+1] = (WArray *)wrap_array(DYND_MOVE(n));
+            ndo[i+1] = make_shell_warray(src_tp[i], src_metadata[i], nd::read_access_flag);
         }
 
         return offset_out + extra_size;
@@ -329,7 +928,7 @@ public:
 };
 
 static PyObject *unary_elwise_map(PyObject *n_obj, PyObject *callable,
-                PyObject *dst_type, PyObject *src_type)
+                PyObject *dst_type, PyObject *src_type, bool numpy_views)
 {
     nd::array n = array_from_py(n_obj, 0, false);
     if (n.get_ndo() == NULL) {
@@ -349,13 +948,15 @@ static PyObject *unary_elwise_map(PyObject *n_obj, PyObject *callable,
     }
 
     ndt::type edt = ndt::make_unary_expr(dst_tp, src_tp,
-                    new pyobject_elwise_expr_kernel_generator(callable, dst_tp, src_tp.value_type()));
+                    new pyobject_elwise_expr_kernel_generator(callable, dst_tp, src_tp.value_type(),
+                                    numpy_views));
     nd::array result = n.replace_dtype(edt, src_tp.get_ndim());
     return wrap_array(result);
 }
 
 static PyObject *general_elwise_map(PyObject *n_list, PyObject *callable,
-                PyObject *dst_type, PyObject *src_type_list)
+                PyObject *dst_type, PyObject *src_type_list, intptr_t block_size,
+                bool numpy_views)
 {
     vector<nd::array> n(PyList_Size(n_list));
     for (size_t i = 0; i != n.size(); ++i) {
@@ -422,13 +1023,15 @@ static PyObject *general_elwise_map(PyObject *n_list, PyObject *callable,
     // we can swap it in as the type
     ndt::type edt = ndt::make_expr(result_vdt,
                     result.get_type(),
-                    new pyobject_elwise_expr_kernel_generator(callable, dst_tp, src_tp));
+                    new pyobject_elwise_expr_kernel_generator(callable, dst_tp, src_tp,
+                                    block_size, numpy_views));
     edt.swap(result.get_ndo()->m_type);
     return wrap_array(DYND_MOVE(result));
 }
 
 PyObject *pydynd::elwise_map(PyObject *n_obj, PyObject *callable,
-                PyObject *dst_type, PyObject *src_type)
+                PyObject *dst_type, PyObject *src_type, intptr_t block_size,
+                bool numpy_views)
 {
     if (!PyList_Check(n_obj)) {
         PyErr_SetString(PyExc_TypeError, "First parameter to elwise_map, 'n', "
@@ -442,10 +1045,19 @@ PyObject *pydynd::elwise_map(PyObject *n_obj, PyObject *callable,
             return NULL;
         }
     }
-    if (PyList_Size(n_obj) == 1) {
+    if (block_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "The block size for elwise_map "
+                        "must be nonnegative");
+        return NULL;
+    }
+    // The buffered kernel is created by the general expr type, which
+    // sees all the dimensions at once
+    if (PyList_Size(n_obj) == 1 && block_size == 0) {
         return unary_elwise_map(PyList_GET_ITEM(n_obj, 0), callable, dst_type,
-                        src_type == Py_None ? Py_None : PyList_GET_ITEM(src_type, 0));
+                        src_type == Py_None ? Py_None : PyList_GET_ITEM(src_type, 0),
+                        numpy_views);
     } else {
-        return general_elwise_map(n_obj, callable, dst_type, src_type);
+        return general_elwise_map(n_obj, callable, dst_type, src_type,
+                        block_size, numpy_views);
     }
 }
@@ -0,0 +1,269 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <sstream>
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/shortvector.hpp>
+
+#include "fuse_ckernel_deferred.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+// The bytes of intermediate values per tile, half of a
+// typical 32KB L1 data cache so the inputs and output fit too
+static const intptr_t FUSE_TILE_BYTES = 16384;
+// The alignment of each intermediate scratch buffer
+static const intptr_t FUSE_BUFFER_ALIGNMENT = 16;
+
+namespace {
+    struct fused_deferred_data {
+        vector<nd::array> stages;
+        // The types of the fused ckernel_deferred, "out, in"
+        vector<ndt::type> data_types;
+    };
+
+    void delete_fused_deferred_data(void *self_data_ptr)
+    {
+        delete reinterpret_cast<fused_deferred_data *>(self_data_ptr);
+    }
+
+    struct fused_ckernel {
+        ckernel_prefix base;
+        intptr_t stage_count, first_stage_nsrc;
+        // One strided ckernel per stage
+        ckernel_builder *stage_ckbs;
+        bool *stage_is_expr;
+        // The number of elements per tile
+        intptr_t tile_size;
+        // The scratch buffers, holding a tile of each intermediate
+        char *scratch;
+        intptr_t *buffer_offsets;
+        intptr_t *buffer_strides;
+    };
+
+    void delete_fused_ckernel(ckernel_prefix *self_data_ptr)
+    {
+        fused_ckernel *e = reinterpret_cast<fused_ckernel *>(self_data_ptr);
+        delete[] e->stage_ckbs;
+        delete[] e->stage_is_expr;
+        free(e->scratch);
+        delete[] e->buffer_offsets;
+        delete[] e->buffer_strides;
+    }
+
+    inline void call_stage(const fused_ckernel *e, intptr_t k, char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride, size_t count)
+    {
+        ckernel_prefix *child = e->stage_ckbs[k].get();
+        if (e->stage_is_expr[k]) {
+            child->get_function<expr_strided_operation_t>()(dst, dst_stride,
+                            src, src_stride, count, child);
+        } else {
+            child->get_function<unary_strided_operation_t>()(dst, dst_stride,
+                            src[0], src_stride[0], count, child);
+        }
+    }
+
+    void fused_expr_strided(char *dst, intptr_t dst_stride,
+                    const char * const *src, const intptr_t *src_stride,
+                    size_t count, ckernel_prefix *ckp)
+    {
+        fused_ckernel *e = reinterpret_cast<fused_ckernel *>(ckp);
+        intptr_t last = e->stage_count - 1, nsrc = e->first_stage_nsrc;
+        shortvector<const char *> tile_src(nsrc);
+        for (size_t pos = 0; pos < count; pos += e->tile_size) {
+            size_t tile_count = min((size_t)e->tile_size, count - pos);
+            for (intptr_t i = 0; i < nsrc; ++i) {
+                tile_src[i] = src[i] + pos * src_stride[i];
+            }
+            char *tile_dst = dst + pos * dst_stride;
+            // The first stage reads the inputs, the others the
+            // previous stage's scratch buffer
+            if (last == 0) {
+                call_stage(e, 0, tile_dst, dst_stride, tile_src.get(), src_stride, tile_count);
+                continue;
+            }
+            call_stage(e, 0, e->scratch + e->buffer_offsets[0], e->buffer_strides[0],
+                            tile_src.get(), src_stride, tile_count);
+            for (intptr_t k = 1; k <= last; ++k) {
+                const char *stage_src = e->scratch + e->buffer_offsets[k - 1];
+                if (k == last) {
+                    call_stage(e, k, tile_dst, dst_stride,
+                                    &stage_src, &e->buffer_strides[k - 1], tile_count);
+                } else {
+                    call_stage(e, k, e->scratch + e->buffer_offsets[k], e->buffer_strides[k],
+                                    &stage_src, &e->buffer_strides[k - 1], tile_count);
+                }
+            }
+        }
+    }
+
+    void fused_expr_single(char *dst, const char * const *src, ckernel_prefix *ckp)
+    {
+        fused_ckernel *e = reinterpret_cast<fused_ckernel *>(ckp);
+        shortvector<intptr_t> src_stride(e->first_stage_nsrc);
+        for (intptr_t i = 0; i < e->first_stage_nsrc; ++i) {
+            src_stride[i] = 0;
+        }
+        fused_expr_strided(dst, 0, src, src_stride.get(), 1, ckp);
+    }
+
+    void fused_unary_strided(char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride,
+                    size_t count, ckernel_prefix *ckp)
+    {
+        fused_expr_strided(dst, dst_stride, &src, &src_stride, count, ckp);
+    }
+
+    void fused_unary_single(char *dst, const char *src, ckernel_prefix *ckp)
+    {
+        intptr_t src_stride = 0;
+        fused_expr_strided(dst, 0, &src, &src_stride, 1, ckp);
+    }
+
+    intptr_t instantiate_fused(void *self_data_ptr,
+                    dynd::ckernel_builder *out_ckb, intptr_t ckb_offset,
+                    const char *const* dynd_metadata, uint32_t kerntype)
+    {
+        fused_deferred_data *data = reinterpret_cast<fused_deferred_data *>(self_data_ptr);
+        intptr_t stage_count = (intptr_t)data->stages.size();
+        const ckernel_deferred *first =
+                        reinterpret_cast<const ckernel_deferred *>(data->stages[0].get_readonly_originptr());
+        bool is_expr = (first->ckernel_funcproto == expr_operation_funcproto);
+
+        intptr_t ckb_end = ckb_offset + sizeof(fused_ckernel);
+        out_ckb->ensure_capacity_leaf(ckb_end);
+        fused_ckernel *e = out_ckb->get_at<fused_ckernel>(ckb_offset);
+        e->stage_ckbs = NULL;
+        e->stage_is_expr = NULL;
+        e->scratch = NULL;
+        e->buffer_offsets = NULL;
+        e->buffer_strides = NULL;
+        e->base.destructor = &delete_fused_ckernel;
+        if (kerntype == kernel_request_single) {
+            if (is_expr) {
+                e->base.set_function<expr_single_operation_t>(&fused_expr_single);
+            } else {
+                e->base.set_function<unary_single_operation_t>(&fused_unary_single);
+            }
+        } else if (kerntype == kernel_request_strided) {
+            if (is_expr) {
+                e->base.set_function<expr_strided_operation_t>(&fused_expr_strided);
+            } else {
+                e->base.set_function<unary_strided_operation_t>(&fused_unary_strided);
+            }
+        } else {
+            throw runtime_error("unsupported kernel request in instantiate_fused");
+        }
+        e->stage_count = stage_count;
+        e->first_stage_nsrc = first->data_types_size - 1;
+
+        // Lay out a tile of each intermediate in the scratch memory
+        e->buffer_offsets = new intptr_t[stage_count];
+        e->buffer_strides = new intptr_t[stage_count];
+        intptr_t tile_element_bytes = 0;
+        for (intptr_t k = 0; k < stage_count - 1; ++k) {
+            const ckernel_deferred *stage =
+                            reinterpret_cast<const ckernel_deferred *>(data->stages[k].get_readonly_originptr());
+            e->buffer_strides[k] = stage->data_dynd_types[0].get_data_size();
+            tile_element_bytes += e->buffer_strides[k];
+        }
+        e->tile_size = max(FUSE_TILE_BYTES / max(tile_element_bytes, (intptr_t)1), (intptr_t)1);
+        intptr_t scratch_size = 0;
+        for (intptr_t k = 0; k < stage_count - 1; ++k) {
+            e->buffer_offsets[k] = scratch_size;
+            scratch_size += (e->tile_size * e->buffer_strides[k] + FUSE_BUFFER_ALIGNMENT - 1) &
+                            ~(FUSE_BUFFER_ALIGNMENT - 1);
+        }
+        if (scratch_size > 0) {
+            // malloc's alignment covers FUSE_BUFFER_ALIGNMENT
+            e->scratch = reinterpret_cast<char *>(malloc(scratch_size));
+            if (e->scratch == NULL) {
+                throw bad_alloc();
+            }
+        }
+
+        // Instantiate each stage as a strided ckernel. The
+        // intermediates have no metadata, so they get NULL.
+        e->stage_is_expr = new bool[stage_count];
+        e->stage_ckbs = new ckernel_builder[stage_count];
+        for (intptr_t k = 0; k < stage_count; ++k) {
+            const ckernel_deferred *stage =
+                            reinterpret_cast<const ckernel_deferred *>(data->stages[k].get_readonly_originptr());
+            e->stage_is_expr[k] = (stage->ckernel_funcproto == expr_operation_funcproto);
+            shortvector<const char *> stage_metadata(stage->data_types_size);
+            stage_metadata[0] = (k == stage_count - 1) ? dynd_metadata[0] : NULL;
+            for (intptr_t i = 1; i < stage->data_types_size; ++i) {
+                stage_metadata[i] = (k == 0) ? dynd_metadata[i] : NULL;
+            }
+            stage->instantiate_func(stage->data_ptr, &e->stage_ckbs[k], 0,
+                            stage_metadata.get(), kernel_request_strided);
+        }
+        return ckb_end;
+    }
+} // anonymous namespace
+
+void pydynd::fuse_ckernel_deferreds(ckernel_deferred *out_ckd,
+                const vector<nd::array>& stages)
+{
+    if (stages.empty()) {
+        throw runtime_error("fusing ckernel_deferreds requires at least one stage");
+    }
+    vector<const ckernel_deferred *> ckds(stages.size());
+    for (size_t k = 0; k < stages.size(); ++k) {
+        if (stages[k].get_type().get_type_id() != ckernel_deferred_type_id) {
+            throw type_error("the stages to fuse must be nd.arrays of type ckernel_deferred");
+        }
+        ckds[k] = reinterpret_cast<const ckernel_deferred *>(stages[k].get_readonly_originptr());
+        if (ckds[k]->instantiate_func == NULL) {
+            throw runtime_error("cannot fuse a NULL ckernel_deferred");
+        }
+        if (ckds[k]->ckernel_funcproto != unary_operation_funcproto &&
+                        ckds[k]->ckernel_funcproto != expr_operation_funcproto) {
+            throw type_error("only unary and expr ckernel_deferreds can be fused");
+        }
+        if (k == 0) {
+            continue;
+        }
+        // Each stage takes the previous stage's output
+        const ndt::type& tp = ckds[k - 1]->data_dynd_types[0];
+        if (ckds[k]->data_types_size != 2) {
+            stringstream ss;
+            ss << "stage " << k << " of the fused pipeline must take one input, ";
+            ss << "it takes " << (ckds[k]->data_types_size - 1);
+            throw type_error(ss.str());
+        }
+        if (ckds[k]->data_dynd_types[1] != tp) {
+            stringstream ss;
+            ss << "stage " << k << " of the fused pipeline takes " << ckds[k]->data_dynd_types[1];
+            ss << ", but the previous stage produces " << tp;
+            throw type_error(ss.str());
+        }
+        if (!tp.is_pod() || tp.get_metadata_size() != 0) {
+            stringstream ss;
+            ss << "the intermediate type " << tp << " of a fused pipeline must be POD without metadata";
+            throw type_error(ss.str());
+        }
+    }
+
+    fused_deferred_data *data = new fused_deferred_data;
+    data->stages = stages;
+    data->data_types.push_back(ckds.back()->data_dynd_types[0]);
+    for (intptr_t i = 1; i < ckds[0]->data_types_size; ++i) {
+        data->data_types.push_back(ckds[0]->data_dynd_types[i]);
+    }
+    out_ckd->data_ptr = data;
+    out_ckd->free_func = &delete_fused_deferred_data;
+    out_ckd->instantiate_func = &instantiate_fused;
+    out_ckd->ckernel_funcproto = ckds[0]->ckernel_funcproto;
+    out_ckd->data_types_size = data->data_types.size();
+    out_ckd->data_dynd_types = &data->data_types[0];
+}
@@ -25,10 +25,167 @@
 
 #include <numpy/arrayscalars.h>
 
+#include <list>
+#include <map>
+#include <mutex>
+
 using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
+namespace {
+    /**
+     * A bounded LRU cache of type conversions between NumPy and dynd,
+     * keyed on the identity of the source type. Each entry holds a
+     * reference to an ndt::type and to a Python object, which between
+     * them keep the key alive so its address can't be reused.
+     *
+     * The lock only protects the cache structure; the conversions
+     * themselves are done outside it, and references to evicted
+     * objects are released by the caller, which holds the GIL.
+     */
+    template<class Key>
+    class type_conversion_cache {
+        struct entry {
+            Key key;
+            ndt::type tp;
+            PyObject *obj;
+        };
+        typedef list<entry> list_type;
+        typedef map<Key, typename list_type::iterator> map_type;
+
+        std::mutex m_mutex;
+        list_type m_entries;
+        map_type m_index;
+        size_t m_capacity;
+        size_t m_hits, m_misses;
+
+        // Non-copyable
+        type_conversion_cache(const type_conversion_cache&);
+        type_conversion_cache& operator=(const type_conversion_cache&);
+    public:
+        explicit type_conversion_cache(size_t capacity)
+            : m_capacity(capacity), m_hits(0), m_misses(0)
+        {
+        }
+
+        /**
+         * Looks up the key, returning borrowed references to the
+         * cached type and object on a hit.
+         */
+        bool lookup(const Key& key, ndt::type& out_tp, PyObject *&out_obj)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            typename map_type::iterator it = m_index.find(key);
+            if (it == m_index.end()) {
+                ++m_misses;
+                return false;
+            }
+            ++m_hits;
+            // Move the entry to the front as the most recently used
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            out_tp = it->second->tp;
+            out_obj = it->second->obj;
+            Py_INCREF(out_obj);
+            return true;
+        }
+
+        /**
+         * Adds an entry, which takes a new reference to 'obj'. The
+         * objects of evicted entries are appended to 'out_evicted',
+         * for the caller to release.
+         */
+        void insert(const Key& key, const ndt::type& tp, PyObject *obj,
+                        vector<PyObject *>& out_evicted)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_index.find(key) != m_index.end()) {
+                return;
+            }
+            entry e;
+            e.key = key;
+            e.tp = tp;
+            e.obj = obj;
+            Py_INCREF(obj);
+            m_entries.push_front(e);
+            m_index[key] = m_entries.begin();
+            while (m_entries.size() > m_capacity) {
+                out_evicted.push_back(m_entries.back().obj);
+                m_index.erase(m_entries.back().key);
+                m_entries.pop_back();
+            }
+        }
+
+        void clear(vector<PyObject *>& out_evicted)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (typename list_type::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+                out_evicted.push_back(it->obj);
+            }
+            m_entries.clear();
+            m_index.clear();
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+        void get_stats(size_t& out_hits, size_t& out_misses, size_t& out_size)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            out_hits = m_hits;
+            out_misses = m_misses;
+            out_size = m_entries.size();
+        }
+
+        size_t get_capacity() const {
+            return m_capacity;
+        }
+    };
+
+    /**
+     * Key for NumPy dtype to dynd type conversions. The dtype's
+     * names and fields are part of the key, because assigning to
+     * a dtype's names attribute replaces them in place. The cache
+     * entry's object holds references to all three.
+     */
+    struct from_numpy_key {
+        PyArray_Descr *descr;
+        PyObject *names, *fields;
+        size_t data_alignment;
+
+        bool operator<(const from_numpy_key& rhs) const {
+            if (descr != rhs.descr) {
+                return descr < rhs.descr;
+            } else if (names != rhs.names) {
+                return names < rhs.names;
+            } else if (fields != rhs.fields) {
+                return fields < rhs.fields;
+            } else {
+                return data_alignment < rhs.data_alignment;
+            }
+        }
+    };
+
+    /**
+     * Key for dynd type to NumPy dtype conversions. For struct types,
+     * whose field offsets live in the metadata, it includes a copy
+     * of the metadata.
+     */
+    typedef pair<const base_type *, string> to_numpy_key;
+
+    void release_evicted(vector<PyObject *>& evicted)
+    {
+        for (size_t i = 0; i != evicted.size(); ++i) {
+            Py_DECREF(evicted[i]);
+        }
+    }
+} // anonymous namespace
+
+// The number of entries in each direction's cache
+#define DYND_NUMPY_TYPE_CACHE_CAPACITY 256
+
+static type_conversion_cache<from_numpy_key> from_numpy_cache(DYND_NUMPY_TYPE_CACHE_CAPACITY);
+static type_conversion_cache<to_numpy_key> to_numpy_cache(DYND_NUMPY_TYPE_CACHE_CAPACITY);
+
 ndt::type make_struct_type_from_numpy_struct(PyArray_Descr *d, size_t data_alignment)
 {
     vector<ndt::type> field_types;
@@ -79,7 +236,7 @@ ndt::type make_struct_type_from_numpy_struct(PyArray_Descr *d, size_t data_align
     }
 }
 
-ndt::type pydynd::ndt_type_from_numpy_dtype(PyArray_Descr *d, size_t data_alignment)
+static ndt::type ndt_type_from_numpy_dtype_uncached(PyArray_Descr *d, size_t data_alignment)
 {
     ndt::type dt;
 
@@ -198,6 +355,35 @@ ndt::type pydynd::ndt_type_from_numpy_dtype(PyArray_Descr *d, size_t data_alignm
     return dt;
 }
 
+ndt::type pydynd::ndt_type_from_numpy_dtype(PyArray_Descr *d, size_t data_alignment)
+{
+    from_numpy_key key;
+    key.descr = d;
+    key.names = d->names;
+    key.fields = d->fields;
+    key.data_alignment = data_alignment;
+
+    ndt::type result;
+    PyObject *obj;
+    if (from_numpy_cache.lookup(key, result, obj)) {
+        Py_DECREF(obj);
+        return result;
+    }
+
+    result = ndt_type_from_numpy_dtype_uncached(d, data_alignment);
+    // The entry keeps the names and fields alive along with the dtype,
+    // so their addresses in the key can't be reused by new objects
+    bool has_names = (d->names != NULL);
+    pyobject_ownref owner(has_names ?
+                    Py_BuildValue("(OOO)", (PyObject *)d, d->names,
+                                  d->fields != NULL ? d->fields : Py_None) :
+                    (PyObject *)d, !has_names);
+    vector<PyObject *> evicted;
+    from_numpy_cache.insert(key, result, owner.get(), evicted);
+    release_evicted(evicted);
+    return result;
+}
+
 dynd::ndt::type pydynd::ndt_type_from_numpy_type_num(int numpy_type_num)
 {
     switch (numpy_type_num) {
@@ -313,7 +499,7 @@ void pydynd::fill_metadata_from_numpy_dtype(const ndt::type& dt, PyArray_Descr *
 }
 
 
-PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp)
+static PyArray_Descr *numpy_dtype_from_ndt_type_uncached(const dynd::ndt::type& tp)
 {
     switch (tp.get_type_id()) {
         case bool_type_id:
@@ -505,7 +691,68 @@ PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp)
     throw dynd::type_error(ss.str());
 }
 
-PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp, const char *metadata)
+/**
+ * Returns a copy of the cached dtype 'd', stealing the reference
+ * to it. NumPy dtypes can be modified in place, for example by
+ * assigning to their names, so the cached one is never handed out.
+ */
+static PyArray_Descr *copy_cached_numpy_dtype(PyArray_Descr *d)
+{
+    PyArray_Descr *result = PyArray_DescrNew(d);
+    Py_DECREF(d);
+    if (result == NULL) {
+        throw exception();
+    }
+    return result;
+}
+
+/**
+ * Looks up a dynd type to NumPy dtype conversion in the cache,
+ * returning a new reference to a copy of the cached dtype or NULL.
+ */
+static PyArray_Descr *lookup_numpy_dtype(const to_numpy_key& key)
+{
+    ndt::type tp;
+    PyObject *obj;
+    if (to_numpy_cache.lookup(key, tp, obj)) {
+        return copy_cached_numpy_dtype((PyArray_Descr *)obj);
+    }
+    return NULL;
+}
+
+/**
+ * Adds the conversion to the cache, stealing the reference to
+ * 'result' and returning a new reference to a copy of it.
+ */
+static PyArray_Descr *insert_numpy_dtype(const to_numpy_key& key, const ndt::type& tp,
+                PyArray_Descr *result)
+{
+    vector<PyObject *> evicted;
+    try {
+        to_numpy_cache.insert(key, tp, (PyObject *)result, evicted);
+    } catch(...) {
+        Py_DECREF(result);
+        throw;
+    }
+    release_evicted(evicted);
+    return copy_cached_numpy_dtype(result);
+}
+
+PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp)
+{
+    // Builtin types are cheap to convert, and have no base_type to key on
+    if (tp.is_builtin()) {
+        return numpy_dtype_from_ndt_type_uncached(tp);
+    }
+    to_numpy_key key(tp.extended(), string());
+    PyArray_Descr *result = lookup_numpy_dtype(key);
+    if (result == NULL) {
+        result = insert_numpy_dtype(key, tp, numpy_dtype_from_ndt_type_uncached(tp));
+    }
+    return result;
+}
+
+static PyArray_Descr *numpy_dtype_from_struct_type(const dynd::ndt::type& tp, const char *metadata)
 {
     switch (tp.get_type_id()) {
         case struct_type_id: {
@@ -573,6 +820,47 @@ PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp, cons
     }
 }
 
+PyArray_Descr *pydynd::numpy_dtype_from_ndt_type(const dynd::ndt::type& tp, const char *metadata)
+{
+    if (tp.get_type_id() != struct_type_id || metadata == NULL) {
+        return numpy_dtype_from_struct_type(tp, metadata);
+    }
+    // The field offsets of a struct are in its metadata
+    to_numpy_key key(tp.extended(), string(metadata, tp.get_metadata_size()));
+    PyArray_Descr *result = lookup_numpy_dtype(key);
+    if (result == NULL) {
+        result = insert_numpy_dtype(key, tp, numpy_dtype_from_struct_type(tp, metadata));
+    }
+    return result;
+}
+
+PyObject *pydynd::numpy_type_cache_info()
+{
+    size_t from_hits, from_misses, from_size, to_hits, to_misses, to_size;
+    from_numpy_cache.get_stats(from_hits, from_misses, from_size);
+    to_numpy_cache.get_stats(to_hits, to_misses, to_size);
+    pyobject_ownref result(PyDict_New());
+    pyobject_ownref from_numpy(Py_BuildValue("{s:n,s:n,s:n}",
+                    "hits", (Py_ssize_t)from_hits, "misses", (Py_ssize_t)from_misses,
+                    "size", (Py_ssize_t)from_size));
+    pyobject_ownref to_numpy(Py_BuildValue("{s:n,s:n,s:n}",
+                    "hits", (Py_ssize_t)to_hits, "misses", (Py_ssize_t)to_misses,
+                    "size", (Py_ssize_t)to_size));
+    pyobject_ownref capacity(PyLong_FromSize_t(from_numpy_cache.get_capacity()));
+    PyDict_SetItemString(result.get(), "from_numpy", from_numpy.get());
+    PyDict_SetItemString(result.get(), "to_numpy", to_numpy.get());
+    PyDict_SetItemString(result.get(), "capacity", capacity.get());
+    return result.release();
+}
+
+void pydynd::clear_numpy_type_cache()
+{
+    vector<PyObject *> evicted;
+    from_numpy_cache.clear(evicted);
+    to_numpy_cache.clear(evicted);
+    release_evicted(evicted);
+}
+
 int pydynd::ndt_type_from_numpy_scalar_typeobject(PyTypeObject* obj, dynd::ndt::type& out_d)
 {
     if (obj == &PyBoolArrType_Type) {
@@ -14,6 +14,8 @@
 #pragma warning(pop)
 #endif
 
+#include <algorithm>
+
 #include <dynd/kernels/expr_kernels.hpp>
 #include <dynd/types/ckernel_deferred_type.hpp>
 
@@ -147,12 +149,19 @@ namespace {
         free(data);
     }
 
+    // Bytes of stack space used to stage misaligned operands
+    static const intptr_t UFUNC_STAGING_BUFFER_SIZE = 8192;
+
     struct scalar_ufunc_ckernel_data {
         ckernel_prefix base;
         PyUFuncGenericFunction funcptr;
         void *ufunc_data;
         intptr_t data_types_size;
         PyUFuncObject *ufunc;
+        // The element size and alignment of each argument, in
+        // the numpy order "in, out"
+        intptr_t arg_sizes[NPY_MAXARGS];
+        intptr_t arg_alignments[NPY_MAXARGS];
     };
 
     static void delete_scalar_ufunc_ckernel_data(ckernel_prefix *self_data_ptr)
@@ -205,6 +214,88 @@ namespace {
         data->funcptr(args, &dimsize, strides, data->ufunc_data);
     }
 
+    /**
+     * Calls the ufunc loop on 'count' elements of args/strides, in
+     * the numpy order "in, out". NumPy inner loops assume aligned
+     * data, so any operand whose pointer or stride is misaligned
+     * gets staged through an aligned contiguous buffer, and the
+     * loop is called once per buffered block.
+     */
+    static void call_ufunc_loop_strided(scalar_ufunc_ckernel_data *data,
+                    char **args, intptr_t *strides, intptr_t count)
+    {
+        intptr_t nargs = data->data_types_size;
+        bool needs_staging[NPY_MAXARGS];
+        bool any_staging = false;
+        intptr_t staged_size = 0;
+        for (intptr_t i = 0; i < nargs; ++i) {
+            intptr_t align_mask = data->arg_alignments[i] - 1;
+            uintptr_t addr_bits = (uintptr_t)args[i] | (count > 1 ? (uintptr_t)strides[i] : 0);
+            needs_staging[i] = (addr_bits & align_mask) != 0;
+            if (needs_staging[i]) {
+                any_staging = true;
+                staged_size += data->arg_sizes[i];
+            }
+        }
+        if (!any_staging) {
+            // The common case, one call for the whole run
+            data->funcptr(args, &count, strides, data->ufunc_data);
+            return;
+        }
+
+        // Each staged operand gets an aligned slice of the buffer,
+        // leaving room for the padding between slices
+        union {
+            char bytes[UFUNC_STAGING_BUFFER_SIZE];
+            long double ld;
+            int64_t i64;
+            double d;
+        } buffer;
+        intptr_t block_size = max((UFUNC_STAGING_BUFFER_SIZE - 16 * nargs) / staged_size,
+                        (intptr_t)1);
+        char *block_args[NPY_MAXARGS];
+        intptr_t block_strides[NPY_MAXARGS];
+        char *buffer_pos = buffer.bytes;
+        for (intptr_t i = 0; i < nargs; ++i) {
+            if (needs_staging[i]) {
+                intptr_t align_mask = data->arg_alignments[i] - 1;
+                buffer_pos = reinterpret_cast<char *>(
+                                ((uintptr_t)buffer_pos + align_mask) & ~(uintptr_t)align_mask);
+                block_args[i] = buffer_pos;
+                block_strides[i] = data->arg_sizes[i];
+                buffer_pos += block_size * data->arg_sizes[i];
+            } else {
+                block_strides[i] = strides[i];
+            }
+        }
+
+        intptr_t out = nargs - 1;
+        for (intptr_t pos = 0; pos < count; pos += block_size) {
+            intptr_t block_count = min(block_size, count - pos);
+            for (intptr_t i = 0; i < nargs; ++i) {
+                char *arg = args[i] + pos * strides[i];
+                if (!needs_staging[i]) {
+                    block_args[i] = arg;
+                } else if (i != out) {
+                    // Copy the input into the aligned buffer
+                    intptr_t size = data->arg_sizes[i];
+                    for (intptr_t j = 0; j < block_count; ++j) {
+                        memcpy(block_args[i] + j * size, arg + j * strides[i], size);
+                    }
+                }
+            }
+            data->funcptr(block_args, &block_count, block_strides, data->ufunc_data);
+            if (needs_staging[out]) {
+                // Copy the output back from the aligned buffer
+                char *arg = args[out] + pos * strides[out];
+                intptr_t size = data->arg_sizes[out];
+                for (intptr_t j = 0; j < block_count; ++j) {
+                    memcpy(arg + j * strides[out], block_args[out] + j * size, size);
+                }
+            }
+        }
+    }
+
     static void scalar_ufunc_strided_ckernel_acquiregil(
                     char *dst, intptr_t dst_stride,
                     const char * const *src, const intptr_t *src_stride,
@@ -217,15 +308,12 @@ namespace {
         // Set up the args array the way the numpy ufunc wants it
         memcpy(&args[0], &src[0], (data_types_size - 1) * sizeof(void *));
         args[data_types_size - 1] = dst;
-        // Call the ufunc loop with a dim size of 1
         intptr_t strides[NPY_MAXARGS];
         memcpy(&strides[0], &src_stride[0], (data_types_size - 1) * sizeof(intptr_t));
         strides[data_types_size - 1] = dst_stride;
-        {
-            PyGILState_RAII pgs;
-            data->funcptr(args, reinterpret_cast<intptr_t *>(&count), strides,
-                            data->ufunc_data);
-        }
+        // Hold the GIL for the whole strided run
+        PyGILState_RAII pgs;
+        call_ufunc_loop_strided(data, args, strides, (intptr_t)count);
     }
 
     static void scalar_ufunc_strided_ckernel_nogil(
@@ -240,11 +328,10 @@ namespace {
         // Set up the args array the way the numpy ufunc wants it
         memcpy(&args[0], &src[0], (data_types_size - 1) * sizeof(void *));
         args[data_types_size - 1] = dst;
-        // Call the ufunc loop with a dim size of 1
         intptr_t strides[NPY_MAXARGS];
         memcpy(&strides[0], &src_stride[0], (data_types_size - 1) * sizeof(intptr_t));
         strides[data_types_size - 1] = dst_stride;
-        data->funcptr(args, reinterpret_cast<intptr_t *>(&count), strides, data->ufunc_data);
+        call_ufunc_loop_strided(data, args, strides, (intptr_t)count);
     }
 
     static intptr_t instantiate_scalar_ufunc_ckernel(void *self_data_ptr,
@@ -278,6 +365,15 @@ namespace {
         ckd->funcptr = data->funcptr;
         ckd->ufunc_data = data->ufunc_data;
         ckd->data_types_size = data->data_types_size;
+        // Record the element layout of the arguments, converting
+        // from the dynd order "out, in" to the numpy order "in, out"
+        const ndt::type *data_types = reinterpret_cast<const ndt::type *>(data->data_types);
+        intptr_t nargs = data->data_types_size;
+        for (intptr_t i = 0; i < nargs; ++i) {
+            const ndt::type& tp = data_types[i == nargs - 1 ? 0 : i + 1];
+            ckd->arg_sizes[i] = tp.get_data_size();
+            ckd->arg_alignments[i] = tp.get_data_alignment();
+        }
         ckd->ufunc = data->ufunc;
         Py_INCREF(ckd->ufunc);
         return ckb_end;
@@ -388,4 +484,14 @@ PyObject *pydynd::ckernel_deferred_from_ufunc(PyObject *ufunc,
     }
 }
 
+bool pydynd::ckernel_deferred_is_from_ufunc(const ckernel_deferred *ckd, PyObject *ufunc)
+{
+    if (ckd->instantiate_func != &instantiate_scalar_ufunc_ckernel) {
+        return false;
+    }
+    const scalar_ufunc_deferred_data *data =
+                    reinterpret_cast<const scalar_ufunc_deferred_data *>(ckd->data_ptr);
+    return (PyObject *)data->ufunc == ufunc;
+}
+
 #endif // DYND_NUMPY_INTEROP
\ No newline at end of file
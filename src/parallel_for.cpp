@@ -0,0 +1,217 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "parallel_for.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace pydynd;
+
+static atomic<int> g_num_threads(1);
+
+int pydynd::get_num_threads()
+{
+    return g_num_threads.load();
+}
+
+void pydynd::set_num_threads(int num_threads)
+{
+    if (num_threads < 0) {
+        throw runtime_error("the number of threads must be nonnegative");
+    } else if (num_threads == 0) {
+        num_threads = max((int)thread::hardware_concurrency(), 1);
+    }
+    g_num_threads.store(num_threads);
+}
+
+namespace {
+    // True on the pool's worker threads, and on a calling thread
+    // while it works on chunks, so nested calls run serially
+    thread_local bool t_in_pool_job = false;
+
+    /**
+     * A pool of persistent worker threads which run one parallel_for
+     * job at a time. The threads of the pool and the calling thread
+     * all claim chunks of the job from a shared counter until it
+     * runs out, so threads which finish early take over the
+     * remaining work.
+     *
+     * The workers have no Python thread state of their own, so a
+     * Python error raised by a chunk, for example from a ckernel
+     * which calls back into Python, would be lost with the temporary
+     * thread state the chunk used. PyGILState_RAII saves it to the
+     * worker's sink instead, and it is passed along with the C++
+     * exception and restored on the calling thread.
+     */
+    class thread_pool {
+        // Serializes jobs, a second concurrent caller runs serially
+        mutex m_job_mutex;
+        // Protects the fields below
+        mutex m_mutex;
+        condition_variable m_work_cv, m_done_cv;
+        vector<thread> m_threads;
+        // The current job
+        const function<void (intptr_t, intptr_t)> *m_fn;
+        intptr_t m_count, m_chunk_size;
+        atomic<intptr_t> m_next_begin;
+        size_t m_job_workers, m_active_workers;
+        size_t m_generation;
+        exception_ptr m_error;
+        // The Python error that goes with m_error, if any
+        saved_pyerr m_pyerr;
+
+        thread_pool(const thread_pool&);
+        thread_pool& operator=(const thread_pool&);
+
+        void run_chunks()
+        {
+            for (;;) {
+                intptr_t begin = m_next_begin.fetch_add(m_chunk_size);
+                if (begin >= m_count) {
+                    return;
+                }
+                saved_pyerr *sink = get_thread_pyerr_sink();
+                try {
+                    (*m_fn)(begin, min(begin + m_chunk_size, m_count));
+                } catch(...) {
+                    lock_guard<mutex> lock(m_mutex);
+                    if (!m_error) {
+                        m_error = current_exception();
+                        if (sink != NULL) {
+                            m_pyerr.take(*sink);
+                        }
+                    }
+                }
+                if (sink != NULL && !sink->empty()) {
+                    // An error which didn't go with the exception kept
+                    PyGILState_RAII pgs;
+                    sink->clear();
+                }
+            }
+        }
+
+        void worker_main(size_t index)
+        {
+            t_in_pool_job = true;
+            saved_pyerr pyerr_sink;
+            set_thread_pyerr_sink(&pyerr_sink);
+            size_t generation = 0;
+            for (;;) {
+                {
+                    unique_lock<mutex> lock(m_mutex);
+                    while (m_generation == generation) {
+                        m_work_cv.wait(lock);
+                    }
+                    generation = m_generation;
+                    if (index >= m_job_workers) {
+                        continue;
+                    }
+                }
+                run_chunks();
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    if (--m_active_workers == 0) {
+                        m_done_cv.notify_one();
+                    }
+                }
+            }
+        }
+
+    public:
+        thread_pool()
+            : m_fn(NULL), m_count(0), m_chunk_size(1), m_next_begin(0),
+              m_job_workers(0), m_active_workers(0), m_generation(0)
+        {
+        }
+
+        void run(intptr_t count, intptr_t chunk_size, size_t num_workers,
+                        const function<void (intptr_t, intptr_t)>& fn)
+        {
+            if (t_in_pool_job) {
+                // A nested call from inside a chunk
+                fn(0, count);
+                return;
+            }
+            unique_lock<mutex> job_lock(m_job_mutex, try_to_lock);
+            if (!job_lock.owns_lock()) {
+                // Another thread is using the pool
+                fn(0, count);
+                return;
+            }
+
+            {
+                lock_guard<mutex> lock(m_mutex);
+                while (m_threads.size() < num_workers) {
+                    m_threads.push_back(thread(&thread_pool::worker_main, this, m_threads.size()));
+                }
+                m_fn = &fn;
+                m_count = count;
+                m_chunk_size = chunk_size;
+                m_next_begin.store(0);
+                m_job_workers = num_workers;
+                m_active_workers = num_workers;
+                m_error = exception_ptr();
+                ++m_generation;
+            }
+            m_work_cv.notify_all();
+
+            // The calling thread works on the job too
+            t_in_pool_job = true;
+            run_chunks();
+            t_in_pool_job = false;
+
+            exception_ptr error;
+            saved_pyerr pyerr;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                while (m_active_workers != 0) {
+                    m_done_cv.wait(lock);
+                }
+                m_fn = NULL;
+                error = m_error;
+                m_error = exception_ptr();
+                pyerr.take(m_pyerr);
+            }
+            if (error) {
+                if (!pyerr.empty()) {
+                    // translate_exception passes the Python error through
+                    PyGILState_RAII pgs;
+                    pyerr.restore();
+                }
+                rethrow_exception(error);
+            }
+        }
+    };
+
+    // The pool is intentionally never destroyed, so its idle threads
+    // don't have to be joined during interpreter shutdown
+    thread_pool *g_thread_pool = new thread_pool;
+} // anonymous namespace
+
+void pydynd::parallel_for(intptr_t count, intptr_t min_chunk,
+                const function<void (intptr_t, intptr_t)>& fn, int num_threads)
+{
+    if (num_threads <= 0) {
+        num_threads = get_num_threads();
+    }
+    intptr_t chunk_count = min((intptr_t)num_threads,
+                    count / max(min_chunk, (intptr_t)1));
+    if (chunk_count <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    intptr_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    g_thread_pool->run(count, chunk_size, (size_t)(chunk_count - 1), fn);
+}
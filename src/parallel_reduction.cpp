@@ -0,0 +1,247 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <algorithm>
+#include <vector>
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+#include <dynd/types/ckernel_deferred_type.hpp>
+
+#include "parallel_reduction.hpp"
+#include "parallel_for.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+// The smallest number of elements worth giving to a thread
+static const intptr_t PARALLEL_REDUCE_MIN_CHUNK = 1 << 16;
+// Partial results are padded to this size to avoid false sharing
+static const intptr_t CACHE_LINE_SIZE = 64;
+
+namespace {
+    struct parallel_reduction_deferred_data {
+        nd::array lifted_reduction;
+        nd::array elwise_reduction;
+    };
+
+    void delete_parallel_reduction_deferred_data(void *self_data_ptr)
+    {
+        delete reinterpret_cast<parallel_reduction_deferred_data *>(self_data_ptr);
+    }
+
+    struct parallel_reduction_ckernel {
+        ckernel_prefix base;
+        // One instance of the lifted reduction per chunk
+        ckernel_builder *chunk_ckbs;
+        intptr_t chunk_count, chunk_size, src_stride;
+        // Metadata for the full chunks and the last chunk, which
+        // the chunk ckernels may refer to
+        char *chunk_metadata;
+        // Combines a partial result into the destination
+        ckernel_builder *combine_ckb;
+        bool combine_is_expr;
+        intptr_t dst_size;
+    };
+
+    void delete_parallel_reduction_ckernel(ckernel_prefix *self_data_ptr)
+    {
+        parallel_reduction_ckernel *e = reinterpret_cast<parallel_reduction_ckernel *>(self_data_ptr);
+        delete[] e->chunk_ckbs;
+        delete e->combine_ckb;
+        delete[] e->chunk_metadata;
+    }
+
+    void parallel_reduction_single(char *dst, const char *src, ckernel_prefix *ckp)
+    {
+        parallel_reduction_ckernel *e = reinterpret_cast<parallel_reduction_ckernel *>(ckp);
+        intptr_t chunk_count = e->chunk_count;
+        intptr_t partial_stride = (e->dst_size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+        vector<char> partials_buf(chunk_count * partial_stride + CACHE_LINE_SIZE);
+        char *partials = reinterpret_cast<char *>(
+                        ((uintptr_t)&partials_buf[0] + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+
+        {
+            // The chunk ckernels may acquire the GIL, for example ones
+            // wrapping NumPy ufuncs, so make sure this thread isn't
+            // holding it while it waits for them. A Python error they
+            // raise on a pool thread is restored on this thread by
+            // parallel_for, and stays set through the RAII objects
+            PyGILState_RAII pgs;
+            PyAllowThreads_RAII nogil;
+            parallel_for(chunk_count, 1, [&](intptr_t begin, intptr_t end) {
+                for (intptr_t k = begin; k < end; ++k) {
+                    ckernel_prefix *child = e->chunk_ckbs[k].get();
+                    child->get_function<unary_single_operation_t>()(partials + k * partial_stride,
+                                    src + k * e->chunk_size * e->src_stride, child);
+                }
+            }, (int)chunk_count);
+        }
+
+        // Combine the partial results in order, so only associativity
+        // is relied on for the result
+        memcpy(dst, partials, e->dst_size);
+        ckernel_prefix *combine = e->combine_ckb->get();
+        for (intptr_t k = 1; k < chunk_count; ++k) {
+            const char *partial = partials + k * partial_stride;
+            if (e->combine_is_expr) {
+                const char *combine_src[2] = {dst, partial};
+                combine->get_function<expr_single_operation_t>()(dst, combine_src, combine);
+            } else {
+                combine->get_function<unary_single_operation_t>()(dst, partial, combine);
+            }
+        }
+    }
+
+    /**
+     * The number of elements in each index of the leading
+     * dimension, counting any var dims as size one.
+     */
+    intptr_t get_inner_element_count(const ndt::type& tp, const char *metadata)
+    {
+        const base_uniform_dim_type *budd = static_cast<const base_uniform_dim_type *>(tp.extended());
+        const ndt::type *el_tp = &budd->get_element_type();
+        metadata += budd->get_element_metadata_offset();
+        intptr_t count = 1;
+        for (;;) {
+            switch (el_tp->get_type_id()) {
+                case strided_dim_type_id:
+                    count *= reinterpret_cast<const strided_dim_type_metadata *>(metadata)->size;
+                    break;
+                case fixed_dim_type_id:
+                    count *= static_cast<const fixed_dim_type *>(el_tp->extended())->get_fixed_dim_size();
+                    break;
+                case var_dim_type_id:
+                    break;
+                default:
+                    return count;
+            }
+            budd = static_cast<const base_uniform_dim_type *>(el_tp->extended());
+            el_tp = &budd->get_element_type();
+            metadata += budd->get_element_metadata_offset();
+        }
+    }
+
+    intptr_t instantiate_parallel_reduction(void *self_data_ptr,
+                    dynd::ckernel_builder *out_ckb, intptr_t ckb_offset,
+                    const char *const* dynd_metadata, uint32_t kerntype)
+    {
+        parallel_reduction_deferred_data *data =
+                        reinterpret_cast<parallel_reduction_deferred_data *>(self_data_ptr);
+        const ckernel_deferred *lifted =
+                        reinterpret_cast<const ckernel_deferred *>(data->lifted_reduction.get_readonly_originptr());
+        const ndt::type& src_tp = lifted->data_dynd_types[1];
+        const strided_dim_type_metadata *src_md =
+                        reinterpret_cast<const strided_dim_type_metadata *>(dynd_metadata[1]);
+
+        // Only split up big single reductions
+        intptr_t chunk_count = 0;
+        int num_threads = get_num_threads();
+        if (kerntype == kernel_request_single && num_threads > 1) {
+            intptr_t inner_count = get_inner_element_count(src_tp, dynd_metadata[1]);
+            intptr_t min_rows = max(PARALLEL_REDUCE_MIN_CHUNK / max(inner_count, (intptr_t)1), (intptr_t)1);
+            chunk_count = min((intptr_t)num_threads, src_md->size / min_rows);
+        }
+        if (chunk_count <= 1) {
+            return lifted->instantiate_func(lifted->data_ptr, out_ckb, ckb_offset,
+                            dynd_metadata, kerntype);
+        }
+        intptr_t chunk_size = (src_md->size + chunk_count - 1) / chunk_count;
+        chunk_count = (src_md->size + chunk_size - 1) / chunk_size;
+
+        intptr_t ckb_end = ckb_offset + sizeof(parallel_reduction_ckernel);
+        out_ckb->ensure_capacity_leaf(ckb_end);
+        parallel_reduction_ckernel *e = out_ckb->get_at<parallel_reduction_ckernel>(ckb_offset);
+        e->chunk_ckbs = NULL;
+        e->combine_ckb = NULL;
+        e->chunk_metadata = NULL;
+        e->base.destructor = &delete_parallel_reduction_ckernel;
+        e->base.set_function<unary_single_operation_t>(&parallel_reduction_single);
+        e->chunk_count = chunk_count;
+        e->chunk_size = chunk_size;
+        e->src_stride = src_md->stride;
+        e->dst_size = lifted->data_dynd_types[0].get_data_size();
+
+        // Metadata with the leading dimension cut to the chunk sizes
+        size_t metadata_size = src_tp.get_metadata_size();
+        e->chunk_metadata = new char[2 * metadata_size];
+        memcpy(e->chunk_metadata, dynd_metadata[1], metadata_size);
+        memcpy(e->chunk_metadata + metadata_size, dynd_metadata[1], metadata_size);
+        reinterpret_cast<strided_dim_type_metadata *>(e->chunk_metadata)->size = chunk_size;
+        reinterpret_cast<strided_dim_type_metadata *>(e->chunk_metadata + metadata_size)->size =
+                        src_md->size - (chunk_count - 1) * chunk_size;
+
+        e->chunk_ckbs = new ckernel_builder[chunk_count];
+        for (intptr_t k = 0; k < chunk_count; ++k) {
+            const char *chunk_dynd_metadata[2] = {dynd_metadata[0],
+                            e->chunk_metadata + (k == chunk_count - 1 ? metadata_size : 0)};
+            lifted->instantiate_func(lifted->data_ptr, &e->chunk_ckbs[k], 0,
+                            chunk_dynd_metadata, kernel_request_single);
+        }
+
+        // The combining kernel has the scalar destination type for every argument
+        const ckernel_deferred *elwise =
+                        reinterpret_cast<const ckernel_deferred *>(data->elwise_reduction.get_readonly_originptr());
+        const char *combine_dynd_metadata[3] = {dynd_metadata[0], dynd_metadata[0], dynd_metadata[0]};
+        e->combine_ckb = new ckernel_builder;
+        e->combine_is_expr = (elwise->ckernel_funcproto == expr_operation_funcproto);
+        elwise->instantiate_func(elwise->data_ptr, e->combine_ckb, 0,
+                        combine_dynd_metadata, kernel_request_single);
+        return ckb_end;
+    }
+} // anonymous namespace
+
+bool pydynd::can_parallelize_reduction(const nd::array& lifted_reduction,
+                const nd::array& elwise_reduction,
+                bool associative, bool commutative,
+                bool has_dst_initialization)
+{
+    if (!associative || !commutative || has_dst_initialization) {
+        return false;
+    }
+    const ckernel_deferred *lifted =
+                    reinterpret_cast<const ckernel_deferred *>(lifted_reduction.get_readonly_originptr());
+    const ckernel_deferred *elwise =
+                    reinterpret_cast<const ckernel_deferred *>(elwise_reduction.get_readonly_originptr());
+    const ndt::type& dst_tp = lifted->data_dynd_types[0];
+    if (lifted->data_types_size != 2 || lifted->ckernel_funcproto != unary_operation_funcproto ||
+                    lifted->data_dynd_types[1].get_type_id() != strided_dim_type_id ||
+                    dst_tp.get_ndim() != 0 || !dst_tp.is_pod()) {
+        return false;
+    }
+    // Partial results get combined with the elwise reduction
+    if (elwise->ckernel_funcproto != unary_operation_funcproto &&
+                    elwise->ckernel_funcproto != expr_operation_funcproto) {
+        return false;
+    }
+    for (intptr_t i = 0; i < elwise->data_types_size; ++i) {
+        if (elwise->data_dynd_types[i] != dst_tp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void pydynd::make_parallel_reduction_ckernel_deferred(ckernel_deferred *out_ckd,
+                const nd::array& lifted_reduction,
+                const nd::array& elwise_reduction)
+{
+    const ckernel_deferred *lifted =
+                    reinterpret_cast<const ckernel_deferred *>(lifted_reduction.get_readonly_originptr());
+    parallel_reduction_deferred_data *data = new parallel_reduction_deferred_data;
+    data->lifted_reduction = lifted_reduction;
+    data->elwise_reduction = elwise_reduction;
+    out_ckd->data_ptr = data;
+    out_ckd->free_func = &delete_parallel_reduction_deferred_data;
+    out_ckd->instantiate_func = &instantiate_parallel_reduction;
+    out_ckd->ckernel_funcproto = lifted->ckernel_funcproto;
+    out_ckd->data_types_size = lifted->data_types_size;
+    // The types are owned by the lifted reduction, which 'data' holds on to
+    out_ckd->data_dynd_types = lifted->data_dynd_types;
+}
@@ -17,6 +17,10 @@
 #include "utility_functions.hpp"
 #include "exception_translation.hpp"
 #include "ckernel_deferred_from_pyfunc.hpp"
+#include "parallel_reduction.hpp"
+#include "summation_reduction.hpp"
+#include "ckernel_cache.hpp"
+#include "fuse_ckernel_deferred.hpp"
 
 using namespace std;
 using namespace dynd;
@@ -225,7 +229,8 @@ namespace {
     PyObject *lift_reduction_ckernel_deferred(PyObject *elwise_reduction_obj, PyObject *lifted_type_obj,
                     PyObject *dst_initialization_obj, PyObject *axis_obj, PyObject *keepdims_obj,
                     PyObject *associative_obj, PyObject *commutative_obj,
-                    PyObject *right_associative_obj, PyObject *reduction_identity_obj)
+                    PyObject *right_associative_obj, PyObject *reduction_identity_obj,
+                    PyObject *summation_obj)
     {
         try {
             nd::array out_ckd = nd::empty(ndt::make_ckernel_deferred());
@@ -322,12 +327,92 @@ namespace {
                 throw dynd::type_error(ss.str());
             }
 
+            summation_mode_t summation = pyarg_summation_mode(summation_obj);
+
             dynd::lift_reduction_ckernel_deferred(out_ckd_ptr, elwise_reduction,
                         lifted_type, dst_initialization, keepdims,
                         reduction_ndim, reduction_dimflags.get(),
                         associative, commutative, right_associative,
                         reduction_identity);
 
+            if (summation != summation_naive) {
+                // Evaluate the reduction in a different order
+                nd::array summation_ckd = nd::empty(ndt::make_ckernel_deferred());
+                make_summation_reduction_ckernel_deferred(
+                            reinterpret_cast<ckernel_deferred *>(summation_ckd.get_readwrite_originptr()),
+                            out_ckd, elwise_reduction, summation, associative,
+                            !dst_initialization.is_empty(), reduction_identity);
+                out_ckd = summation_ckd;
+            }
+
+            if (can_parallelize_reduction(out_ckd, elwise_reduction, associative, commutative,
+                            !dst_initialization.is_empty())) {
+                // Wrap it so it can split the work across threads
+                nd::array parallel_ckd = nd::empty(ndt::make_ckernel_deferred());
+                make_parallel_reduction_ckernel_deferred(
+                            reinterpret_cast<ckernel_deferred *>(parallel_ckd.get_readwrite_originptr()),
+                            out_ckd, elwise_reduction);
+                return wrap_array(parallel_ckd);
+            }
+
+            return wrap_array(out_ckd);
+        } catch(...) {
+            translate_exception();
+            return NULL;
+        }
+    }
+
+    PyObject *make_cached_ckernel_deferred(PyObject *ckd_obj)
+    {
+        try {
+            if (!WArray_Check(ckd_obj) ||
+                        ((WArray *)ckd_obj)->v.get_type().get_type_id() != ckernel_deferred_type_id) {
+                throw dynd::type_error("ckd must be an nd.array of type ckernel_deferred");
+            }
+            nd::array out_ckd = nd::empty(ndt::make_ckernel_deferred());
+            pydynd::make_cached_ckernel_deferred(
+                        reinterpret_cast<ckernel_deferred *>(out_ckd.get_readwrite_originptr()),
+                        ((WArray *)ckd_obj)->v);
+            return wrap_array(out_ckd);
+        } catch(...) {
+            translate_exception();
+            return NULL;
+        }
+    }
+
+    PyObject *ckernel_cache_info()
+    {
+        try {
+            return pydynd::ckernel_cache_info();
+        } catch(...) {
+            translate_exception();
+            return NULL;
+        }
+    }
+
+    PyObject *clear_ckernel_cache()
+    {
+        pydynd::clear_ckernel_cache();
+        Py_RETURN_NONE;
+    }
+
+    PyObject *fuse_ckernel_deferreds(PyObject *ckds_obj)
+    {
+        try {
+            Py_ssize_t size = pysequence_size(ckds_obj);
+            vector<nd::array> stages(size);
+            for (Py_ssize_t i = 0; i < size; ++i) {
+                pyobject_ownref item(PySequence_GetItem(ckds_obj, i));
+                if (!WArray_Check(item.get()) ||
+                            ((WArray *)item.get())->v.get_type().get_type_id() != ckernel_deferred_type_id) {
+                    throw dynd::type_error("ckds must be a list of nd.arrays of type ckernel_deferred");
+                }
+                stages[i] = ((WArray *)item.get())->v;
+            }
+            nd::array out_ckd = nd::empty(ndt::make_ckernel_deferred());
+            pydynd::fuse_ckernel_deferreds(
+                        reinterpret_cast<ckernel_deferred *>(out_ckd.get_readwrite_originptr()),
+                        stages);
             return wrap_array(out_ckd);
         } catch(...) {
             translate_exception();
@@ -347,7 +432,11 @@ namespace {
         &pydynd::ckernel_deferred_from_ufunc,
         &lift_ckernel_deferred,
         &lift_reduction_ckernel_deferred,
-        &pydynd::ckernel_deferred_from_pyfunc
+        &pydynd::ckernel_deferred_from_pyfunc,
+        &make_cached_ckernel_deferred,
+        &ckernel_cache_info,
+        &clear_ckernel_cache,
+        &fuse_ckernel_deferreds
     };
 } // anonymous namespace
 
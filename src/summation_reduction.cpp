@@ -0,0 +1,400 @@
+//
+// Copyright (C) 2011-14 Mark Wiebe, DyND Developers
+// BSD 2-Clause License, see LICENSE.txt
+//
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include <dynd/kernels/ckernel_builder.hpp>
+#include <dynd/kernels/expr_kernels.hpp>
+#include <dynd/types/strided_dim_type.hpp>
+#include <dynd/types/fixed_dim_type.hpp>
+
+#include "summation_reduction.hpp"
+#include "numpy_ufunc_kernel.hpp"
+#include "utility_functions.hpp"
+
+using namespace std;
+using namespace dynd;
+using namespace pydynd;
+
+// The number of interleaved partial results in a pairwise leaf,
+// and the size of the leaves, as in NumPy's pairwise summation
+static const intptr_t PAIRWISE_LANES = 8;
+static const intptr_t PAIRWISE_BLOCK_SIZE = 128;
+// Enough scratch elements for the accumulators and the deepest
+// recursion of the pairwise tree
+static const intptr_t PAIRWISE_SCRATCH_COUNT = PAIRWISE_LANES + 64;
+
+summation_mode_t pydynd::pyarg_summation_mode(PyObject *mode_obj)
+{
+    return (summation_mode_t)pyarg_strings_to_int(mode_obj, "summation", summation_naive,
+                    "naive", summation_naive,
+                    "pairwise", summation_pairwise,
+                    "kahan", summation_kahan);
+}
+
+namespace {
+    struct summation_deferred_data {
+        nd::array lifted_reduction;
+        nd::array elwise_reduction;
+        summation_mode_t mode;
+        // The identity as the destination type, or NULL
+        nd::array identity;
+    };
+
+    void delete_summation_deferred_data(void *self_data_ptr)
+    {
+        delete reinterpret_cast<summation_deferred_data *>(self_data_ptr);
+    }
+
+    struct summation_ckernel {
+        ckernel_prefix base;
+        intptr_t ndim;
+        // Shape followed by strides of the source dimensions
+        intptr_t *shape_and_strides;
+        // A copy of the identity, or NULL
+        char *identity;
+        intptr_t element_size;
+        // The strided elwise reduction, used by the pairwise mode
+        ckernel_builder *op_ckb;
+        bool op_is_expr;
+    };
+
+    void delete_summation_ckernel(ckernel_prefix *self_data_ptr)
+    {
+        summation_ckernel *e = reinterpret_cast<summation_ckernel *>(self_data_ptr);
+        delete[] e->shape_and_strides;
+        delete[] e->identity;
+        delete e->op_ckb;
+    }
+
+    /**
+     * Does ``dst[i] = op(dst[i], src[i])`` for 'count' elements.
+     */
+    inline void call_op(const summation_ckernel *e, char *dst, intptr_t dst_stride,
+                    const char *src, intptr_t src_stride, intptr_t count)
+    {
+        ckernel_prefix *op = e->op_ckb->get();
+        if (e->op_is_expr) {
+            const char *op_src[2] = {dst, src};
+            intptr_t op_src_stride[2] = {dst_stride, src_stride};
+            op->get_function<expr_strided_operation_t>()(dst, dst_stride,
+                            op_src, op_src_stride, count, op);
+        } else {
+            op->get_function<unary_strided_operation_t>()(dst, dst_stride,
+                            src, src_stride, count, op);
+        }
+    }
+
+    /**
+     * Reduces the 'count' > 0 elements at 'src' into 'dst' with a
+     * blocked pairwise tree. Each call on a leaf accumulates eight
+     * independent partial results, which keeps the dependency chains
+     * short and the rounding error growing with the log of 'count'.
+     */
+    void pairwise_reduce(const summation_ckernel *e, char *dst,
+                    const char *src, intptr_t src_stride, intptr_t count, char *scratch)
+    {
+        intptr_t es = e->element_size;
+        if (count < PAIRWISE_LANES) {
+            memcpy(dst, src, es);
+            if (count > 1) {
+                call_op(e, dst, 0, src + src_stride, src_stride, count - 1);
+            }
+        } else if (count <= PAIRWISE_BLOCK_SIZE) {
+            char *acc = scratch;
+            for (intptr_t j = 0; j < PAIRWISE_LANES; ++j) {
+                memcpy(acc + j * es, src + j * src_stride, es);
+            }
+            intptr_t i = PAIRWISE_LANES;
+            for (; i + PAIRWISE_LANES <= count; i += PAIRWISE_LANES) {
+                call_op(e, acc, es, src + i * src_stride, src_stride, PAIRWISE_LANES);
+            }
+            // Combine the lanes as a tree
+            for (intptr_t half = PAIRWISE_LANES / 2; half > 0; half /= 2) {
+                call_op(e, acc, es, acc + half * es, es, half);
+            }
+            if (i < count) {
+                call_op(e, acc, 0, src + i * src_stride, src_stride, count - i);
+            }
+            memcpy(dst, acc, es);
+        } else {
+            // Split at a multiple of the lane count
+            intptr_t n2 = count / 2;
+            n2 -= n2 % PAIRWISE_LANES;
+            pairwise_reduce(e, dst, src, src_stride, n2, scratch);
+            // Each level of recursion keeps one element of scratch
+            char *rest = scratch;
+            pairwise_reduce(e, rest, src + n2 * src_stride, src_stride, count - n2, scratch + es);
+            call_op(e, dst, 0, rest, 0, 1);
+        }
+    }
+
+    /**
+     * Reduces the array at 'src' from dimension 'dim' on. Each row is
+     * reduced pairwise, and the rows' results are reduced pairwise too.
+     */
+    void pairwise_reduce_dims(const summation_ckernel *e, char *dst, const char *src,
+                    intptr_t dim, char *scratch)
+    {
+        const intptr_t *shape = e->shape_and_strides;
+        const intptr_t *strides = shape + e->ndim;
+        intptr_t size = shape[dim];
+        if (dim == e->ndim - 1) {
+            pairwise_reduce(e, dst, src, strides[dim], size, scratch);
+        } else {
+            intptr_t es = e->element_size;
+            vector<char> row_results(size * es);
+            for (intptr_t i = 0; i < size; ++i) {
+                pairwise_reduce_dims(e, &row_results[i * es], src + i * strides[dim], dim + 1, scratch);
+            }
+            pairwise_reduce(e, dst, &row_results[0], es, size, scratch);
+        }
+    }
+
+    template<class T>
+    struct kahan_accumulator {
+        T sum, compensation;
+
+        inline void add(T x) {
+            // Kahan-Babuska (Neumaier) step, which also compensates
+            // when the new value is bigger than the running sum. Once
+            // the sum is inf or nan the compensation would be nan, so
+            // it's left alone and the sum carries through
+            T t = sum + x;
+            if (!std::isfinite(t)) {
+                sum = t;
+                return;
+            }
+            if ((sum >= 0 ? sum : -sum) >= (x >= 0 ? x : -x)) {
+                compensation += (sum - t) + x;
+            } else {
+                compensation += (x - t) + sum;
+            }
+            sum = t;
+        }
+    };
+
+    template<class T>
+    void kahan_reduce_dims(const summation_ckernel *e, kahan_accumulator<T>& acc,
+                    const char *src, intptr_t dim)
+    {
+        const intptr_t *shape = e->shape_and_strides;
+        const intptr_t *strides = shape + e->ndim;
+        intptr_t size = shape[dim], stride = strides[dim];
+        if (dim == e->ndim - 1) {
+            for (intptr_t i = 0; i < size; ++i, src += stride) {
+                acc.add(*reinterpret_cast<const T *>(src));
+            }
+        } else {
+            for (intptr_t i = 0; i < size; ++i, src += stride) {
+                kahan_reduce_dims(e, acc, src, dim + 1);
+            }
+        }
+    }
+
+    /**
+     * Returns true if any of the source dimensions is empty, in which
+     * case 'dst' is set to the identity, or an error is raised if
+     * there is none, the same as the naive reduction.
+     */
+    bool reduce_empty(const summation_ckernel *e, char *dst)
+    {
+        const intptr_t *shape = e->shape_and_strides;
+        for (intptr_t i = 0; i < e->ndim; ++i) {
+            if (shape[i] == 0) {
+                if (e->identity == NULL) {
+                    throw runtime_error("cannot reduce an empty array without a reduction_identity");
+                }
+                memcpy(dst, e->identity, e->element_size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<class T>
+    void kahan_single(char *dst, const char *src, ckernel_prefix *ckp)
+    {
+        summation_ckernel *e = reinterpret_cast<summation_ckernel *>(ckp);
+        if (reduce_empty(e, dst)) {
+            return;
+        }
+        kahan_accumulator<T> acc;
+        acc.sum = e->identity ? *reinterpret_cast<const T *>(e->identity) : T(0);
+        acc.compensation = 0;
+        kahan_reduce_dims(e, acc, src, 0);
+        *reinterpret_cast<T *>(dst) = acc.sum + acc.compensation;
+    }
+
+    void pairwise_single(char *dst, const char *src, ckernel_prefix *ckp)
+    {
+        summation_ckernel *e = reinterpret_cast<summation_ckernel *>(ckp);
+        if (reduce_empty(e, dst)) {
+            return;
+        }
+        vector<char> scratch(PAIRWISE_SCRATCH_COUNT * e->element_size);
+        pairwise_reduce_dims(e, dst, src, 0, &scratch[0]);
+    }
+
+    intptr_t instantiate_summation(void *self_data_ptr,
+                    dynd::ckernel_builder *out_ckb, intptr_t ckb_offset,
+                    const char *const* dynd_metadata, uint32_t kerntype)
+    {
+        summation_deferred_data *data = reinterpret_cast<summation_deferred_data *>(self_data_ptr);
+        const ckernel_deferred *lifted =
+                        reinterpret_cast<const ckernel_deferred *>(data->lifted_reduction.get_readonly_originptr());
+        if (kerntype != kernel_request_single) {
+            throw runtime_error("summation reductions only support single kernel requests");
+        }
+        const ndt::type& dst_tp = lifted->data_dynd_types[0];
+
+        intptr_t ckb_end = ckb_offset + sizeof(summation_ckernel);
+        out_ckb->ensure_capacity_leaf(ckb_end);
+        summation_ckernel *e = out_ckb->get_at<summation_ckernel>(ckb_offset);
+        e->shape_and_strides = NULL;
+        e->identity = NULL;
+        e->op_ckb = NULL;
+        e->base.destructor = &delete_summation_ckernel;
+        e->element_size = dst_tp.get_data_size();
+
+        // Get the shape and strides of the source dimensions
+        const ndt::type& src_tp = lifted->data_dynd_types[1];
+        intptr_t ndim = src_tp.get_ndim();
+        e->ndim = ndim;
+        e->shape_and_strides = new intptr_t[2 * ndim];
+        const ndt::type *tp = &src_tp;
+        const char *metadata = dynd_metadata[1];
+        for (intptr_t i = 0; i < ndim; ++i) {
+            if (tp->get_type_id() == strided_dim_type_id) {
+                const strided_dim_type_metadata *md =
+                                reinterpret_cast<const strided_dim_type_metadata *>(metadata);
+                e->shape_and_strides[i] = md->size;
+                e->shape_and_strides[ndim + i] = md->stride;
+            } else {
+                const fixed_dim_type *fdt = static_cast<const fixed_dim_type *>(tp->extended());
+                e->shape_and_strides[i] = fdt->get_fixed_dim_size();
+                e->shape_and_strides[ndim + i] = fdt->get_fixed_stride();
+            }
+            const base_uniform_dim_type *budd = static_cast<const base_uniform_dim_type *>(tp->extended());
+            metadata += budd->get_element_metadata_offset();
+            tp = &budd->get_element_type();
+        }
+
+        if (!data->identity.is_empty()) {
+            e->identity = new char[e->element_size];
+            memcpy(e->identity, data->identity.get_readonly_originptr(), e->element_size);
+        }
+
+        if (data->mode == summation_kahan) {
+            if (dst_tp.get_type_id() == float32_type_id) {
+                e->base.set_function<unary_single_operation_t>(&kahan_single<float>);
+            } else {
+                e->base.set_function<unary_single_operation_t>(&kahan_single<double>);
+            }
+        } else {
+            e->base.set_function<unary_single_operation_t>(&pairwise_single);
+            const ckernel_deferred *elwise =
+                            reinterpret_cast<const ckernel_deferred *>(data->elwise_reduction.get_readonly_originptr());
+            const char *op_dynd_metadata[3] = {dynd_metadata[0], dynd_metadata[0], dynd_metadata[0]};
+            e->op_ckb = new ckernel_builder;
+            e->op_is_expr = (elwise->ckernel_funcproto == expr_operation_funcproto);
+            elwise->instantiate_func(elwise->data_ptr, e->op_ckb, 0,
+                            op_dynd_metadata, kernel_request_strided);
+        }
+        return ckb_end;
+    }
+} // anonymous namespace
+
+void pydynd::make_summation_reduction_ckernel_deferred(ckernel_deferred *out_ckd,
+                const nd::array& lifted_reduction,
+                const nd::array& elwise_reduction,
+                summation_mode_t mode, bool associative,
+                bool has_dst_initialization,
+                const nd::array& reduction_identity)
+{
+    const ckernel_deferred *lifted =
+                    reinterpret_cast<const ckernel_deferred *>(lifted_reduction.get_readonly_originptr());
+    const ckernel_deferred *elwise =
+                    reinterpret_cast<const ckernel_deferred *>(elwise_reduction.get_readonly_originptr());
+    const ndt::type& dst_tp = lifted->data_dynd_types[0];
+    const ndt::type& src_tp = lifted->data_dynd_types[1];
+    const char *mode_name = (mode == summation_kahan) ? "kahan" : "pairwise";
+
+    // Check that the reduction is one these modes handle
+    if (dst_tp.get_ndim() != 0 || !dst_tp.is_pod() || dst_tp.get_metadata_size() != 0) {
+        stringstream ss;
+        ss << "summation='" << mode_name << "' requires a reduction of all dimensions";
+        ss << " to a scalar without keepdims, got result type " << dst_tp;
+        throw type_error(ss.str());
+    }
+    if (src_tp.get_ndim() == 0) {
+        stringstream ss;
+        ss << "summation='" << mode_name << "' requires at least one dimension to reduce";
+        throw type_error(ss.str());
+    }
+    const ndt::type *tp = &src_tp;
+    for (intptr_t i = 0, i_end = src_tp.get_ndim(); i < i_end; ++i) {
+        if (tp->get_type_id() != strided_dim_type_id && tp->get_type_id() != fixed_dim_type_id) {
+            stringstream ss;
+            ss << "summation='" << mode_name << "' requires strided or fixed dimensions, got " << src_tp;
+            throw type_error(ss.str());
+        }
+        tp = &static_cast<const base_uniform_dim_type *>(tp->extended())->get_element_type();
+    }
+    for (intptr_t i = 0; i < elwise->data_types_size; ++i) {
+        if (elwise->data_dynd_types[i] != dst_tp) {
+            stringstream ss;
+            ss << "summation='" << mode_name << "' requires the elwise reduction's types";
+            ss << " to all be " << dst_tp;
+            throw type_error(ss.str());
+        }
+    }
+    if (elwise->ckernel_funcproto != unary_operation_funcproto &&
+                    elwise->ckernel_funcproto != expr_operation_funcproto) {
+        throw type_error("the elwise reduction must be a unary or expr ckernel");
+    }
+    // The reordering only gives the same result up to rounding
+    // for addition, and the kahan mode adds the values itself
+    pyobject_ownref numpy_module(PyImport_ImportModule("numpy"));
+    pyobject_ownref add_ufunc(PyObject_GetAttrString(numpy_module, "add"));
+    if (!ckernel_deferred_is_from_ufunc(elwise, add_ufunc)) {
+        stringstream ss;
+        ss << "summation='" << mode_name << "' requires an elwise reduction";
+        ss << " made from numpy.add by ckernel_deferred_from_ufunc";
+        throw type_error(ss.str());
+    }
+    if (has_dst_initialization) {
+        stringstream ss;
+        ss << "summation='" << mode_name << "' does not support dst_initialization";
+        throw type_error(ss.str());
+    }
+    if (mode == summation_pairwise && !associative) {
+        throw type_error("summation='pairwise' requires an associative reduction");
+    }
+    if (mode == summation_kahan && dst_tp.get_type_id() != float32_type_id &&
+                    dst_tp.get_type_id() != float64_type_id) {
+        stringstream ss;
+        ss << "summation='kahan' requires float32 or float64, got " << dst_tp;
+        throw type_error(ss.str());
+    }
+
+    summation_deferred_data *data = new summation_deferred_data;
+    data->lifted_reduction = lifted_reduction;
+    data->elwise_reduction = elwise_reduction;
+    data->mode = mode;
+    if (!reduction_identity.is_empty()) {
+        data->identity = nd::empty(dst_tp);
+        data->identity.vals() = reduction_identity;
+    }
+    out_ckd->data_ptr = data;
+    out_ckd->free_func = &delete_summation_deferred_data;
+    out_ckd->instantiate_func = &instantiate_summation;
+    out_ckd->ckernel_funcproto = unary_operation_funcproto;
+    out_ckd->data_types_size = 2;
+    // The types are owned by the lifted reduction, which 'data' holds on to
+    out_ckd->data_dynd_types = lifted->data_dynd_types;
+}
@@ -17,6 +17,18 @@ using namespace std;
 using namespace dynd;
 using namespace pydynd;
 
+static thread_local saved_pyerr *t_pyerr_sink = NULL;
+
+void pydynd::set_thread_pyerr_sink(saved_pyerr *sink)
+{
+    t_pyerr_sink = sink;
+}
+
+saved_pyerr *pydynd::get_thread_pyerr_sink()
+{
+    return t_pyerr_sink;
+}
+
 void pydynd::py_decref_function(void* obj)
 {
     // Because dynd in general is intended to do things multi-threaded (eventually),